@@ -306,18 +306,33 @@ void SourceInfo::OutputInfo::Copy(const OutputInfo& copy)
     }
     fBasePort = copy.fBasePort;
     fAlreadySetup = copy.fAlreadySetup;
+    fNumFanOutAddrs = copy.fNumFanOutAddrs;
+    if ((fNumFanOutAddrs != 0) && (copy.fFanOutAddrArray != NULL))
+    {
+        fFanOutAddrArray = NEW UInt32[fNumFanOutAddrs];
+        ::memcpy(fFanOutAddrArray, copy.fFanOutAddrArray, fNumFanOutAddrs * sizeof(UInt32));
+    }
+    fTreeDepth = copy.fTreeDepth;
 }
 
 SourceInfo::OutputInfo::~OutputInfo()
 {
     if (fPortArray != NULL)
         delete [] fPortArray;
+    if (fFanOutAddrArray != NULL)
+        delete [] fFanOutAddrArray;
 }
 
 Bool16 SourceInfo::OutputInfo::Equal(const OutputInfo& info)
 {
     if ((fDestAddr == info.fDestAddr) && (fLocalAddr == info.fLocalAddr) && (fTimeToLive == info.fTimeToLive))
     {
+        // A relay tree output only matches if it still feeds the same set of children
+        if (fNumFanOutAddrs != info.fNumFanOutAddrs)
+            return false;
+        if ((fNumFanOutAddrs != 0) && (::memcmp(fFanOutAddrArray, info.fFanOutAddrArray, fNumFanOutAddrs * sizeof(UInt32)) != 0))
+            return false;
+            
         if ((fBasePort != 0) && (fBasePort == info.fBasePort))
             return true;
         else if ((fNumPorts == 0) || ((fNumPorts == info.fNumPorts) && (fPortArray[0] == info.fPortArray[0])))
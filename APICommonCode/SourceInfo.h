@@ -97,8 +97,9 @@ class SourceInfo
         // contains one RTP port for each incoming stream.
         struct OutputInfo
         {
-            OutputInfo() : fDestAddr(0), fLocalAddr(0), fTimeToLive(0), fPortArray(NULL), fNumPorts(0), fBasePort(0), fAlreadySetup(false) {}
-            ~OutputInfo(); // Deletes the memory allocated for fPortArray
+            OutputInfo() : fDestAddr(0), fLocalAddr(0), fTimeToLive(0), fPortArray(NULL), fNumPorts(0), fBasePort(0), fAlreadySetup(false),
+                            fFanOutAddrArray(NULL), fNumFanOutAddrs(0), fTreeDepth(0) {}
+            ~OutputInfo(); // Deletes the memory allocated for fPortArray and fFanOutAddrArray
             
             // Returns true if the two are equal
             Bool16 Equal(const OutputInfo& info);
@@ -112,6 +113,13 @@ class SourceInfo
             UInt32 fNumPorts;       // Size of the fPortArray (usually equal to fNumStreams)
             UInt16 fBasePort;       // The base destination RTP port - for i=1 to fNumStreams fPortArray[i] = fPortArray[i-1] + 2
             Bool16  fAlreadySetup;  // A flag used in QTSSReflectorModule.cpp
+            
+            // Relay tree outputs send the same streams to several unicast destinations
+            // on the same ports. If fFanOutAddrArray is not NULL it holds all of them,
+            // and fDestAddr is a copy of the first entry.
+            UInt32* fFanOutAddrArray;
+            UInt32  fNumFanOutAddrs;
+            UInt32  fTreeDepth;     // Hops between the root of the relay tree and this server
         };
 
         // Returns the number of OutputInfo objects.
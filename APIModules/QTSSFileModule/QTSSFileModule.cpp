@@ -49,19 +49,33 @@
 
 #include <errno.h>
 
+#ifndef __Win32__
+#include <dirent.h>
+#endif
+
 #include "QTSS.h"
 
 class FileSession
 {
     public:
     
+        enum
+        {
+            kMaxAlternates = 8
+        };
+        
         FileSession() : fAdjustedPlayTime(0), fNextPacketLen(0), fLastQualityCheck(0),
                         fAllowNegativeTTs(false), fSpeed(1),
                         fStartTime(-1), fStopTime(-1), fStopTrackID(0), fStopPN(0),
-                        fLastRTPTime(0), fLastPauseTime(0),fTotalPauseTime(0), fPaused(false)
+                        fLastRTPTime(0), fLastPauseTime(0),fTotalPauseTime(0), fPaused(false),
+                        fNumAlternates(0), fCurFile(&fFile), fCurAlternate(0), fTargetAlternate(0)
         {}
         
-        ~FileSession() {}
+        ~FileSession()  { for (UInt32 x = 0; x < fNumAlternates; x++) delete fAlternates[x]; }
+        
+        // 0 is fFile, the movie the client asked for. The rest are the alternates, highest bitrate first.
+        QTRTPFile*          GetAlternate(UInt32 inIndex) { return (inIndex == 0) ? &fFile : fAlternates[inIndex - 1]; }
+        void                RemoveAlternate(UInt32 inIndex);
         
         QTRTPFile           fFile;
         SInt64              fAdjustedPlayTime;
@@ -81,8 +95,34 @@ class FileSession
         UInt64              fLastPauseTime;
         SInt64              fTotalPauseTime;
         Bool16              fPaused;
+        
+        // Copies of fFile encoded at lower bitrates. Packets come from fCurFile,
+        // which is fFile or one of these.
+        QTRTPFile*          fAlternates[kMaxAlternates];
+        UInt32              fNumAlternates;
+        QTRTPFile*          fCurFile;
+        UInt32              fCurAlternate;
+        UInt32              fTargetAlternate;
 };
 
+void FileSession::RemoveAlternate(UInt32 inIndex)
+{
+    Assert((inIndex > 0) && (inIndex <= fNumAlternates));
+    
+    // Only happens if a track is set up while playing. The next PLAY seeks fFile.
+    if (fCurFile == fAlternates[inIndex - 1])
+    {
+        fCurFile = &fFile;
+        fCurAlternate = 0;
+    }
+    fTargetAlternate = 0;
+    
+    delete fAlternates[inIndex - 1];
+    for (UInt32 x = inIndex; x < fNumAlternates; x++)
+        fAlternates[x - 1] = fAlternates[x];
+    fNumAlternates--;
+}
+
 // ref to the prefs dictionary object
 static QTSS_ModulePrefsObject       sPrefs;
 static QTSS_PrefsObject             sServerPrefs;
@@ -119,6 +159,8 @@ static QTSS_AttributeID sRTPStreamLastSentPacketSeqNumAttrID   = qtssIllegalAttr
 
 static QTSS_AttributeID sRTPStreamLastPacketSeqNumAttrID   = qtssIllegalAttrID;
 
+static QTSS_AttributeID sRTPStreamNumAlternatesAttrID   = qtssIllegalAttrID;
+
 // OTHER DATA
 
 static UInt32				sFlowControlProbeInterval	= 10;
@@ -148,7 +190,11 @@ static Float64              sDefaultStartTime = 0.0;
 static Bool16               sPlayerCompatibility = true;
 static UInt32               sAdjustMediaBandwidthPercent = 50;
 
+static Bool16               sEnableAlternateBitrates = false;
+static StrPtrLen            sKBitName("kbit");
+
 static const StrPtrLen              kCacheControlHeader("must-revalidate");
+static const UInt32                 kNumQualityLevels = 5;
 static const QTSS_RTSPStatusCode    kNotModifiedStatus          = qtssRedirectNotModified;
 
 
@@ -170,6 +216,11 @@ static QTSS_Error DestroySession(QTSS_ClientSessionClosing_Params* inParams);
 static void       DeleteFileSession(FileSession* inFileSession);
 static UInt32   WriteSDPHeader(FILE* sdpFile, iovec *theSDPVec, SInt16 *ioVectorIndex, StrPtrLen *sdpHeader);
 static void     BuildPrefBasedHeaders();
+static Bool16   ParseAlternateName(char* inName, UInt32* outPrefixLen, UInt32* outKBits, char** outExtension);
+static void     OpenAlternates(FileSession* inFile, char* inPath);
+static void     SetupAlternateTracks(FileSession* inFile, UInt32 inTrackID, SInt32 inTimescale, StrPtrLen* inPayloadName,
+                                        UInt32 inPayloadType, QTSS_RTPStreamObject inStream, UInt32 inSSRC);
+static Bool16   SwitchAlternate(FileSession* inFile, Float64 inSampleTime);
 
 QTSS_Error QTSSFileModule_Main(void* inPrivateArgs)
 {
@@ -345,6 +396,12 @@ QTSS_Error Register(QTSS_Register_Params* inParams)
     (void)QTSS_AddStaticAttribute(qtssRTPStreamObjectType, sRTPStreamLastPacketSeqNumName, NULL, qtssAttrDataTypeUInt16);
     (void)QTSS_IDForAttr(qtssRTPStreamObjectType, sRTPStreamLastPacketSeqNumName, &sRTPStreamLastPacketSeqNumAttrID);
 
+    // How many of the stream's quality levels pick a bitrate alternate. QTSSFlowControlModule
+    // reads this to step through them one at a time, and adds it too in case it registers first.
+    static char*        sRTPStreamNumAlternatesName   = "QTSSFileModuleNumAlternates";
+    (void)QTSS_AddStaticAttribute(qtssRTPStreamObjectType, sRTPStreamNumAlternatesName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssRTPStreamObjectType, sRTPStreamNumAlternatesName, &sRTPStreamNumAlternatesAttrID);
+
     // Tell the server our name!
     static char* sModuleName = "QTSSFileModule";
     ::strcpy(inParams->outModuleName, sModuleName);
@@ -498,6 +555,9 @@ QTSS_Error RereadPrefs()
     if (sAdjustMediaBandwidthPercent < 1)
         sAdjustMediaBandwidthPercent = 1;
         
+    sEnableAlternateBitrates = false;
+    QTSSModuleUtils::GetIOAttribute(sPrefs, "enable_alternate_bitrates", qtssAttrDataTypeBool16, &sEnableAlternateBitrates, sizeof(sEnableAlternateBitrates));
+
     BuildPrefBasedHeaders();
     
     return QTSS_NoErr;
@@ -923,9 +983,184 @@ QTSS_Error CreateQTRTPFile(QTSS_StandardRTSP_Params* inParamBlock, char* inPath,
         AssertV(0, theErr);
     }
     
+    if (sEnableAlternateBitrates)
+        OpenAlternates(*outFile, inPath);
+        
     return QTSS_NoErr;
 }
 
+Bool16 ParseAlternateName(char* inName, UInt32* outPrefixLen, UInt32* outKBits, char** outExtension)
+{
+    // Alternates are named <movie>_<bitrate>kbit<extension>, like sample_300kbit.mov
+    char* theUnderscore = ::strrchr(inName, '_');
+    if (theUnderscore == NULL)
+        return false;
+        
+    char* theKBitStr = NULL;
+    UInt32 theKBits = ::strtoul(theUnderscore + 1, &theKBitStr, 10);
+    if ((theKBitStr == theUnderscore + 1) || (::strncmp(theKBitStr, sKBitName.Ptr, sKBitName.Len) != 0))
+        return false;
+        
+    *outPrefixLen = (theUnderscore + 1) - inName;
+    *outKBits = theKBits;
+    *outExtension = theKBitStr + sKBitName.Len;
+    return true;
+}
+
+void OpenAlternates(FileSession* inFile, char* inPath)
+{
+#ifndef __Win32__
+    char* theName = ::strrchr(inPath, kPathDelimiterChar);
+    if (theName == NULL)
+        return;
+    theName++;
+    
+    UInt32 thePrefixLen = 0;
+    UInt32 theKBits = 0;
+    char* theExtension = NULL;
+    if (!ParseAlternateName(theName, &thePrefixLen, &theKBits, &theExtension))
+        return;
+        
+    StrPtrLen theFolder(inPath, theName - inPath);
+    OSCharArrayDeleter theFolderStr(theFolder.GetAsCString());
+    DIR* theDir = ::opendir(theFolderStr.GetObject());
+    if (theDir == NULL)
+        return;
+        
+    //
+    // Find the movies in the same folder with the same name at a lower bitrate,
+    // keeping the highest kMaxAlternates of them, highest first.
+    char* theAltNames[FileSession::kMaxAlternates];
+    UInt32 theAltKBits[FileSession::kMaxAlternates];
+    UInt32 theNumAlts = 0;
+    
+    struct dirent* theEntry = NULL;
+    while ((theEntry = ::readdir(theDir)) != NULL)
+    {
+        UInt32 theAltPrefixLen = 0;
+        UInt32 theAltKBitsValue = 0;
+        char* theAltExtension = NULL;
+        if (!ParseAlternateName(theEntry->d_name, &theAltPrefixLen, &theAltKBitsValue, &theAltExtension))
+            continue;
+        if ((theAltPrefixLen != thePrefixLen) || (::strncmp(theEntry->d_name, theName, thePrefixLen) != 0))
+            continue;
+        if ((::strcmp(theAltExtension, theExtension) != 0) || (theAltKBitsValue >= theKBits))
+            continue;
+            
+        UInt32 theIndex = theNumAlts;
+        while ((theIndex > 0) && (theAltKBits[theIndex - 1] < theAltKBitsValue))
+            theIndex--;
+        if (theIndex == FileSession::kMaxAlternates)
+            continue;
+            
+        if (theNumAlts == FileSession::kMaxAlternates)
+            delete [] theAltNames[--theNumAlts];
+        for (UInt32 x = theNumAlts; x > theIndex; x--)
+        {
+            theAltNames[x] = theAltNames[x - 1];
+            theAltKBits[x] = theAltKBits[x - 1];
+        }
+        theAltNames[theIndex] = NEW char[::strlen(theEntry->d_name) + 1];
+        ::strcpy(theAltNames[theIndex], theEntry->d_name);
+        theAltKBits[theIndex] = theAltKBitsValue;
+        theNumAlts++;
+    }
+    (void)::closedir(theDir);
+    
+    for (UInt32 x = 0; x < theNumAlts; x++)
+    {
+        OSCharArrayDeleter theAltName(theAltNames[x]);
+        ResizeableStringFormatter theAltPath(NULL, 0);
+        theAltPath.Put(theFolder);
+        theAltPath.Put(theAltName.GetObject());
+        theAltPath.PutTerminator();
+        
+        QTRTPFile* theAltFile = NEW QTRTPFile();
+        if (theAltFile->Initialize(theAltPath.GetBufPtr()) != QTRTPFile::errNoError)
+        {
+            delete theAltFile;
+            continue;
+        }
+        inFile->fAlternates[inFile->fNumAlternates++] = theAltFile;
+    }
+#endif
+}
+
+void SetupAlternateTracks(FileSession* inFile, UInt32 inTrackID, SInt32 inTimescale, StrPtrLen* inPayloadName,
+                            UInt32 inPayloadType, QTSS_RTPStreamObject inStream, UInt32 inSSRC)
+{
+    //
+    // An alternate is only any use if every track the client sets up is in it,
+    // with the same payload and timescale. Otherwise forget about it.
+    for (UInt32 theIndex = 1; theIndex <= inFile->fNumAlternates; )
+    {
+        QTRTPFile* theAltFile = inFile->GetAlternate(theIndex);
+        Bool16 isUsable = false;
+        
+        if ((theAltFile->AddTrack(inTrackID, true) == QTRTPFile::errNoError) &&
+            ((SInt32)theAltFile->GetTrackTimeScale(inTrackID) == inTimescale))
+        {
+            int theSDPLen = 0;
+            char* theSDPData = theAltFile->GetSDPFile(&theSDPLen);
+            SDPSourceInfo theSDPSource(theSDPData, theSDPLen);
+            
+            for (UInt32 x = 0; x < theSDPSource.GetNumStreams(); x++)
+            {
+                SourceInfo::StreamInfo* theStreamInfo = theSDPSource.GetStreamInfo(x);
+                if (theStreamInfo->fTrackID == inTrackID)
+                {
+                    isUsable = (theStreamInfo->fPayloadType == inPayloadType) && theStreamInfo->fPayloadName.Equal(*inPayloadName);
+                    break;
+                }
+            }
+        }
+        
+        if (!isUsable)
+        {
+            inFile->RemoveAlternate(theIndex);
+            continue;
+        }
+        
+        theAltFile->SetTrackSSRC(inTrackID, inSSRC);
+        theAltFile->SetTrackCookies(inTrackID, inStream, inPayloadType);
+        theIndex++;
+    }
+}
+
+Bool16 SwitchAlternate(FileSession* inFile, Float64 inSampleTime)
+{
+    QTRTPFile* theOldFile = inFile->fCurFile;
+    QTRTPFile* theNewFile = inFile->GetAlternate(inFile->fTargetAlternate);
+    
+    //
+    // The packet at inSampleTime hasn't been sent, so the sequence number in it is
+    // the next one the client expects on its track. The other tracks have their
+    // next packets waiting as well. Have the new file carry on from there.
+    QTRTPFile::RTPTrackListEntry* theTrack = NULL;
+    for (UInt32 x = 0; x < inFile->fSDPSource.GetNumStreams(); x++)
+    {
+        UInt32 theTrackID = inFile->fSDPSource.GetStreamInfo(x)->fTrackID;
+        if (!theOldFile->FindTrackEntry(theTrackID, &theTrack) || !theTrack->IsTrackActive)
+            continue;
+            
+        theNewFile->SetTrackContinuation(theTrackID, theOldFile->GetNextTrackSequenceNumber(theTrackID),
+                                            theOldFile->GetTrackTimestampOffset(theTrackID));
+        if (theNewFile->FindTrackEntry(theTrackID, &theTrack))
+            theNewFile->SetTrackQualityLevel(theTrack, QTRTPFile::kAllPackets);
+    }
+    
+    //
+    // Don't back up at all. If the alternates were encoded with their key frames
+    // at the same times, as they should be, this lands on a key frame.
+    if (theNewFile->Seek(inSampleTime, 0.0) != QTRTPFile::errNoError)
+        return false;
+        
+    inFile->fCurFile = theNewFile;
+    inFile->fCurAlternate = inFile->fTargetAlternate;
+    inFile->fPacketStruct.packetData = NULL;
+    return true;
+}
+
 
 QTSS_Error DoSetup(QTSS_StandardRTSP_Params* inParamBlock)
 {
@@ -1048,7 +1283,7 @@ QTSS_Error DoSetup(QTSS_StandardRTSP_Params* inParamBlock)
     Assert(theErr == QTSS_NoErr);
     
     // Set the number of quality levels. Allow up to 6
-    static UInt32 sNumQualityLevels = 5;
+    static UInt32 sNumQualityLevels = kNumQualityLevels;
     
     theErr = QTSS_SetValue(newStream, qtssRTPStrNumQualityLevels, 0, &sNumQualityLevels, sizeof(sNumQualityLevels));
     Assert(theErr == QTSS_NoErr);
@@ -1064,6 +1299,7 @@ QTSS_Error DoSetup(QTSS_StandardRTSP_Params* inParamBlock)
     //give the file some info it needs.
     theFile->fFile.SetTrackSSRC(theTrackID, *theTrackSSRC);
     theFile->fFile.SetTrackCookies(theTrackID, newStream, thePayloadType);
+    SetupAlternateTracks(theFile, theTrackID, theTimescale, thePayload, thePayloadType, newStream, *theTrackSSRC);
     
     StrPtrLen theHeader;
     theErr = QTSS_GetValuePtr(inParamBlock->inRTSPHeaders, qtssXRTPMetaInfoHeader, 0, (void**)&theHeader.Ptr, &theHeader.Len);
@@ -1086,7 +1322,13 @@ QTSS_Error DoSetup(QTSS_StandardRTSP_Params* inParamBlock)
         if (thePayloadType == qtssVideoPayloadType)
             isVideo = true;
         if (theErr == QTSS_NoErr)
+        {
             theFile->fFile.SetTrackRTPMetaInfo(theTrackID, theFields, isVideo);
+            
+            // RTP-Meta-Info packets number every packet in the movie, so they can't switch movies
+            while (theFile->fNumAlternates > 0)
+                theFile->RemoveAlternate(theFile->fNumAlternates);
+        }
     }
     
     //
@@ -1117,11 +1359,16 @@ QTSS_Error SetupCacheBuffers(QTSS_StandardRTSP_Params* inParamBlock, FileSession
             return QTSS_RequestFailed;
     }
     
-    if (sEnableSharedBuffers && playCount == 1) // increments num buffers after initialization so do only once per session
-        (*theFile)->fFile.AllocateSharedBuffers(sSharedBufferUnitKSize, sSharedBufferInc, sSharedBufferUnitSize,sSharedBufferMaxUnits);
-    
-    if (sEnablePrivateBuffers) // reinitializes buffers to current location so do every time 
-        (*theFile)->fFile.AllocatePrivateBuffers(sSharedBufferUnitKSize, sPrivateBufferUnitSize, sPrivateBufferMaxUnits);
+    for (UInt32 x = 0; x <= (*theFile)->fNumAlternates; x++)
+    {
+        QTRTPFile* theQTRTPFile = (*theFile)->GetAlternate(x);
+        
+        if (sEnableSharedBuffers && playCount == 1) // increments num buffers after initialization so do only once per session
+            theQTRTPFile->AllocateSharedBuffers(sSharedBufferUnitKSize, sSharedBufferInc, sSharedBufferUnitSize,sSharedBufferMaxUnits);
+        
+        if (sEnablePrivateBuffers) // reinitializes buffers to current location so do every time 
+            theQTRTPFile->AllocatePrivateBuffers(sSharedBufferUnitKSize, sPrivateBufferUnitSize, sPrivateBufferMaxUnits);
+    }
 
     playCount ++;
     theErr = QTSS_SetValue(inParamBlock->inClientSession, sFileSessionPlayCountAttrID, 0, &playCount, sizeof(playCount));
@@ -1156,6 +1403,12 @@ QTSS_Error DoPlay(QTSS_StandardRTSP_Params* inParamBlock)
     if (theErr != QTSS_NoErr)
         return theErr;
     
+    //
+    // Every PLAY starts out with the movie the client asked for. SendPackets
+    // switches to an alternate again if the stream's quality level calls for it.
+    (*theFile)->fCurFile = &(*theFile)->fFile;
+    (*theFile)->fCurAlternate = 0;
+    
 
     // Set the default quality before playing.
     QTRTPFile::RTPTrackListEntry* thePacketTrack;
@@ -1316,6 +1569,19 @@ QTSS_Error DoPlay(QTSS_StandardRTSP_Params* inParamBlock)
         Assert(theErr == QTSS_NoErr);
         theErr = QTSS_SetValue(*theRef, qtssRTPStrFirstTimestamp, 0, &theTimestamp, sizeof(theTimestamp));
         Assert(theErr == QTSS_NoErr);
+        
+        //
+        // The first quality levels of a video stream pick the alternates, highest bitrate
+        // first. The levels after those thin the lowest bitrate alternate, as usual.
+        QTSS_RTPPayloadType thePayloadType = qtssUnknownPayloadType;
+        theLen = sizeof(thePayloadType);
+        (void)QTSS_GetValue(*theRef, qtssRTPStrPayloadType, 0, &thePayloadType, &theLen);
+        if (thePayloadType == qtssVideoPayloadType)
+        {
+            UInt32 theNumQualityLevels = kNumQualityLevels + (*theFile)->fNumAlternates;
+            (void)QTSS_SetValue(*theRef, qtssRTPStrNumQualityLevels, 0, &theNumQualityLevels, sizeof(theNumQualityLevels));
+            (void)QTSS_SetValue(*theRef, sRTPStreamNumAlternatesAttrID, 0, &(*theFile)->fNumAlternates, sizeof((*theFile)->fNumAlternates));
+        }
 
         if (allTracksReliable)
         {
@@ -1331,7 +1597,8 @@ QTSS_Error DoPlay(QTSS_StandardRTSP_Params* inParamBlock)
     
     //Tell the QTRTPFile whether repeat packets are wanted based on the transport
     // we don't care if it doesn't set (i.e. this is a meta info session)
-     (void)  (*theFile)->fFile.SetDropRepeatPackets(allTracksReliable);// if alltracks are reliable then drop repeat packets.
+    for (UInt32 x = 0; x <= (*theFile)->fNumAlternates; x++)
+        (void) (*theFile)->GetAlternate(x)->SetDropRepeatPackets(allTracksReliable);// if alltracks are reliable then drop repeat packets.
         
     //Tell the server to start playing this movie. We do want it to send RTCP SRs, but
     //we DON'T want it to write the RTP header
@@ -1423,14 +1690,14 @@ QTSS_Error SendPackets(QTSS_RTPSendPackets_Params* inParams)
     bool isBeginningOfWriteBurst = true;
     QTSS_Object theStream = NULL;
 
-    QTRTPFile::RTPTrackListEntry* theLastPacketTrack = (*theFile)->fFile.GetLastPacketTrack();
+    QTRTPFile::RTPTrackListEntry* theLastPacketTrack = (*theFile)->fCurFile->GetLastPacketTrack();
     
     while (true)
     {   
         if ((*theFile)->fPacketStruct.packetData == NULL)
         {
-            Float64 theTransmitTime = (*theFile)->fFile.GetNextPacket((char**)&(*theFile)->fPacketStruct.packetData, &(*theFile)->fNextPacketLen);
-            if ( QTRTPFile::errNoError != (*theFile)->fFile.Error() )
+            Float64 theTransmitTime = (*theFile)->fCurFile->GetNextPacket((char**)&(*theFile)->fPacketStruct.packetData, &(*theFile)->fNextPacketLen);
+            if ( QTRTPFile::errNoError != (*theFile)->fCurFile->Error() )
             {
                 QTSS_CliSesTeardownReason reason = qtssCliSesTearDownUnsupportedMedia;
                 (void) QTSS_SetValue(inParams->inClientSession, qtssCliTeardownReason, 0, &reason, sizeof(reason));
@@ -1438,7 +1705,7 @@ QTSS_Error SendPackets(QTSS_RTPSendPackets_Params* inParams)
                 return QTSS_RequestFailed;
             }
             
-            theLastPacketTrack = (*theFile)->fFile.GetLastPacketTrack();
+            theLastPacketTrack = (*theFile)->fCurFile->GetLastPacketTrack();
 
 			if (theLastPacketTrack == NULL)
 				break;
@@ -1475,6 +1742,16 @@ QTSS_Error SendPackets(QTSS_RTPSendPackets_Params* inParams)
                 return QTSS_NoErr;
             }
             
+            //
+            // If we're due to move to another bitrate, do it at the start of a key frame
+            if (((*theFile)->fTargetAlternate != (*theFile)->fCurAlternate) && ((*theFile)->fStopTrackID == 0) &&
+                ((QTSS_RTPPayloadType)theLastPacketTrack->Cookie2 == qtssVideoPayloadType))
+            {
+                Float64 theSampleTime = 0;
+                if ((*theFile)->fCurFile->IsLastPacketSyncSampleStart(&theSampleTime) && SwitchAlternate(*theFile, theSampleTime))
+                    continue;
+            }
+            
             //
             // Find out what our play speed is. Send packets out at the specified rate,
             // and do so by altering the transmit time of the packet based on the Speed rate.
@@ -1523,8 +1800,17 @@ QTSS_Error SendPackets(QTSS_RTPSendPackets_Params* inParams)
                 Assert(theErr == QTSS_NoErr);
                 Assert(theQualityLevel != NULL);
                 Assert(theLen == sizeof(UInt32));
+                
+                UInt32 theThinningLevel = *theQualityLevel;
+                if ((*theFile)->fNumAlternates > 0)
+                {
+                    (*theFile)->fTargetAlternate = theThinningLevel;
+                    if ((*theFile)->fTargetAlternate > (*theFile)->fNumAlternates)
+                        (*theFile)->fTargetAlternate = (*theFile)->fNumAlternates;
+                    theThinningLevel -= (*theFile)->fTargetAlternate;
+                }
         
-                (*theFile)->fFile.SetTrackQualityLevel(theLastPacketTrack, *theQualityLevel);
+                (*theFile)->fCurFile->SetTrackQualityLevel(theLastPacketTrack, theThinningLevel);
             }
         }
 
@@ -1594,7 +1880,9 @@ QTSS_Error DestroySession(QTSS_ClientSessionClosing_Params* inParams)
 
     //
     // Tell the ClientSession how many samples we skipped because of stream thinning
-    UInt32 theNumSkippedSamples = (*theFile)->fFile.GetNumSkippedSamples();
+    UInt32 theNumSkippedSamples = 0;
+    for (UInt32 x = 0; x <= (*theFile)->fNumAlternates; x++)
+        theNumSkippedSamples += (*theFile)->GetAlternate(x)->GetNumSkippedSamples();
     (void)QTSS_SetValue(inParams->inClientSession, qtssCliSesFramesSkipped, 0, &theNumSkippedSamples, sizeof(theNumSkippedSamples));
     
     DeleteFileSession(*theFile);
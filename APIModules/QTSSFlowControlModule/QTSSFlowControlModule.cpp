@@ -44,20 +44,52 @@
 
 // ATTRIBUTES IDs
 
-static QTSS_AttributeID sNumLossesAboveTolAttr          = qtssIllegalAttrID;
-static QTSS_AttributeID sNumLossesBelowTolAttr          = qtssIllegalAttrID;
+// These live on the client session, so that reports from all of its streams
+// add up to one decision for the whole session
+static QTSS_AttributeID sNumCongestedAttr               = qtssIllegalAttrID;
+static QTSS_AttributeID sNumClearAttr                   = qtssIllegalAttrID;
+static QTSS_AttributeID sNumClearToThickAttr            = qtssIllegalAttrID;
 static QTSS_AttributeID sNumWorsesAttr                  = qtssIllegalAttrID;
+static QTSS_AttributeID sMinRTTAttr                     = qtssIllegalAttrID;
+static QTSS_AttributeID sOverbufferingOffAttr           = qtssIllegalAttrID;
+
+// Set by QTSSFileModule on streams whose first quality levels pick a bitrate alternate
+static QTSS_AttributeID sNumAlternatesAttr              = qtssIllegalAttrID;
 
 // STATIC VARIABLES
 
 static QTSS_ModulePrefsObject sPrefs = NULL;
 
+// After each thinning, it takes twice as many clear reports to thicken again, up to this many times more
+static const UInt32 kMaxThickBackoff = 8;
+
+// What one report says to do with the session
+enum
+{
+    kNoChange   = 0,
+    kThin       = 1,
+    kThicken    = 2
+};
+
+// The session's counts, as kept in the attributes above
+struct FlowControlCounts
+{
+    UInt32  fNumCongested;
+    UInt32  fNumClear;
+    UInt32  fNumClearToThick;
+    UInt32  fNumWorses;
+    UInt32  fMinRTT;
+};
+
 // Default values for preferences
 static UInt32   sDefaultLossThinTolerance       = 30;
 static UInt32   sDefaultNumLossesToThin         = 3;
 static UInt32   sDefaultLossThickTolerance      = 5;
 static UInt32   sDefaultLossesToThick           = 6;
 static UInt32   sDefaultWorsesToThin            = 2;
+static UInt32   sDefaultRTTThinTolerance        = 300;
+static UInt32   sDefaultJitterThinTolerance     = 200;
+static UInt32   sDefaultDelayThinTolerance      = 1000;
 
 // Current values for preferences
 static UInt32   sLossThinTolerance      = 30;
@@ -65,6 +97,9 @@ static UInt32   sNumLossesToThin        = 3;
 static UInt32   sLossThickTolerance     = 5;
 static UInt32   sLossesToThick          = 6;
 static UInt32   sWorsesToThin           = 2;
+static UInt32   sRTTThinTolerance       = 300;
+static UInt32   sJitterThinTolerance    = 200;
+static UInt32   sDelayThinTolerance     = 1000;
 
 
 // FUNCTION PROTOTYPES
@@ -74,7 +109,14 @@ static QTSS_Error   Register(QTSS_Register_Params* inParams);
 static QTSS_Error   Initialize(QTSS_Initialize_Params* inParams);
 static QTSS_Error   RereadPrefs();
 static QTSS_Error   ProcessRTCPPacket(QTSS_RTCPProcess_Params* inParams);
-static void             InitializeDictionaryItems(QTSS_RTPStreamObject inStream);
+static void         InitializeDictionaryItems(QTSS_ClientSessionObject inSession);
+static UInt32       GetUInt32(QTSS_Object inObject, QTSS_AttributeID inAttr);
+static UInt16       GetUInt16(QTSS_Object inObject, QTSS_AttributeID inAttr);
+static void         AdjustQuality(QTSS_ClientSessionObject inSession, Bool16 inThin);
+static UInt32       CheckReport(FlowControlCounts* ioCounts, UInt32 inPercentLoss, UInt32 inRTT, UInt32 inJitterInMsec,
+                                SInt32 inDelayInMsec, Bool16 inGettingWorse, Bool16 inGettingBetter);
+static UInt32       NextQualityLevel(UInt32 inCurQuality, UInt32 inNumQualityLevels, UInt32 inNumAlternates, Bool16 inThin);
+static Bool16       CheckOverbuffering(Bool16 inThin, Bool16 inAllAtFullQuality, Bool16* ioOverbuffering, UInt32* ioTurnedOff);
 
 
 
@@ -94,7 +136,7 @@ QTSS_Error  QTSSFlowControlModuleDispatch(QTSS_Role inRole, QTSS_RoleParamPtr in
             return Initialize(&inParamBlock->initParams);
         case QTSS_RereadPrefs_Role:
             return RereadPrefs();
-        case QTSS_RTCPProcess_Role:
+        case QTSS_RTCPReport_Role:
             return ProcessRTCPPacket(&inParamBlock->rtcpProcessParams);
     }
     return QTSS_NoErr;
@@ -104,23 +146,40 @@ QTSS_Error Register(QTSS_Register_Params* inParams)
 {
     // Do role setup
     (void)QTSS_AddRole(QTSS_Initialize_Role);
-    (void)QTSS_AddRole(QTSS_RTCPProcess_Role);
+    (void)QTSS_AddRole(QTSS_RTCPReport_Role);
     (void)QTSS_AddRole(QTSS_RereadPrefs_Role);
     
 
     // Add other attributes
-    static char*        sNumLossesAboveToleranceName    =   "QTSSFlowControlModuleLossAboveTol";
-    static char*        sNumLossesBelowToleranceName    =   "QTSSFlowControlModuleLossBelowTol";
+    static char*        sNumCongestedName               =   "QTSSFlowControlModuleCongested";
+    static char*        sNumClearName                   =   "QTSSFlowControlModuleClear";
+    static char*        sNumClearToThickName            =   "QTSSFlowControlModuleClearToThick";
     static char*        sNumGettingWorsesName           =   "QTSSFlowControlModuleGettingWorses";
+    static char*        sMinRTTName                     =   "QTSSFlowControlModuleMinRTT";
+    static char*        sOverbufferingOffName           =   "QTSSFlowControlModuleOverbufferingOff";
 
-    (void)QTSS_AddStaticAttribute(qtssRTPStreamObjectType, sNumLossesAboveToleranceName, NULL, qtssAttrDataTypeUInt32);
-    (void)QTSS_IDForAttr(qtssRTPStreamObjectType, sNumLossesAboveToleranceName, &sNumLossesAboveTolAttr);
+    (void)QTSS_AddStaticAttribute(qtssClientSessionObjectType, sNumCongestedName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssClientSessionObjectType, sNumCongestedName, &sNumCongestedAttr);
+    
+    (void)QTSS_AddStaticAttribute(qtssClientSessionObjectType, sNumClearName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssClientSessionObjectType, sNumClearName, &sNumClearAttr);
     
-    (void)QTSS_AddStaticAttribute(qtssRTPStreamObjectType, sNumLossesBelowToleranceName, NULL, qtssAttrDataTypeUInt32);
-    (void)QTSS_IDForAttr(qtssRTPStreamObjectType, sNumLossesBelowToleranceName, &sNumLossesBelowTolAttr);
+    (void)QTSS_AddStaticAttribute(qtssClientSessionObjectType, sNumClearToThickName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssClientSessionObjectType, sNumClearToThickName, &sNumClearToThickAttr);
     
-    (void)QTSS_AddStaticAttribute(qtssRTPStreamObjectType, sNumGettingWorsesName, NULL, qtssAttrDataTypeUInt32);
-    (void)QTSS_IDForAttr(qtssRTPStreamObjectType, sNumGettingWorsesName, &sNumWorsesAttr);
+    (void)QTSS_AddStaticAttribute(qtssClientSessionObjectType, sNumGettingWorsesName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssClientSessionObjectType, sNumGettingWorsesName, &sNumWorsesAttr);
+
+    (void)QTSS_AddStaticAttribute(qtssClientSessionObjectType, sMinRTTName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssClientSessionObjectType, sMinRTTName, &sMinRTTAttr);
+
+    (void)QTSS_AddStaticAttribute(qtssClientSessionObjectType, sOverbufferingOffName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssClientSessionObjectType, sOverbufferingOffName, &sOverbufferingOffAttr);
+
+    // QTSSFileModule adds this too. Whichever module registers first creates it.
+    static char*        sNumAlternatesName              =   "QTSSFileModuleNumAlternates";
+    (void)QTSS_AddStaticAttribute(qtssRTPStreamObjectType, sNumAlternatesName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssRTPStreamObjectType, sNumAlternatesName, &sNumAlternatesAttr);
 
     // Tell the server our name!
     static char* sModuleName = "QTSSFlowControlModule";
@@ -150,6 +209,12 @@ QTSS_Error RereadPrefs()
                                 &sLossesToThick,        &sDefaultLossesToThick, sizeof(sLossesToThick));
     QTSSModuleUtils::GetAttribute(sPrefs, "num_worses_to_thin", qtssAttrDataTypeUInt32,
                                 &sWorsesToThin,         &sDefaultWorsesToThin, sizeof(sWorsesToThin));
+    QTSSModuleUtils::GetAttribute(sPrefs, "rtt_thin_tolerance", qtssAttrDataTypeUInt32,
+                                &sRTTThinTolerance,     &sDefaultRTTThinTolerance, sizeof(sRTTThinTolerance));
+    QTSSModuleUtils::GetAttribute(sPrefs, "jitter_thin_tolerance", qtssAttrDataTypeUInt32,
+                                &sJitterThinTolerance,  &sDefaultJitterThinTolerance, sizeof(sJitterThinTolerance));
+    QTSSModuleUtils::GetAttribute(sPrefs, "delay_thin_tolerance", qtssAttrDataTypeUInt32,
+                                &sDelayThinTolerance,   &sDefaultDelayThinTolerance, sizeof(sDelayThinTolerance));
     return QTSS_NoErr;
 }
 
@@ -186,214 +251,434 @@ QTSS_Error ProcessRTCPPacket(QTSS_RTCPProcess_Params* inParams)
     //to be flexible: you may swap this algorithm out for another implemented in another module,
     //and this algorithm uses settings that are adjustable at runtime.
     
-    //It uses the % loss statistic in the RTCP packets, as well as the "getting better" &
-    //"getting worse" fields.
-
-    //Less bandwidth will be served if the loss % of N number of RTCP packets is above M, where
-    //N and M are runtime settings.
-    
-    //Less bandwidth will be served if "getting worse" is reported N number of times.
+    //Each RTCP packet with a receiver report or status packet in it, from any stream of
+    //the session, counts as one report on the whole session. A report is "congested" if
+    //any of these is over its thin tolerance:
+    //  - % loss, from the receiver report or the client's status (APP) packet
+    //  - round trip time above the lowest seen on this session, which grows as queues build up
+    //  - interarrival jitter from the receiver report
+    //  - how late the server is in sending the stream's packets
+    //It is "clear" if all of them are comfortably below (loss under loss_thick_tolerance,
+    //the others under half their thin tolerance).
+
+    //Less bandwidth will be served after N congested reports in a row, or N "getting worse"
+    //reports from the client. Overbuffering is turned off then as well, so the server
+    //doesn't send faster than the stream's own bitrate.
     
-    //More bandwidth will be served if the loss % of N number of RTCPs is below M.
-    //N will scale up over time.
+    //More bandwidth will be served after M clear reports in a row, or when the client
+    //reports "getting better". Each time the session is thinned, M doubles (up to
+    //kMaxThickBackoff times num_losses_to_thick), so a session that can't keep up at
+    //the higher bitrate doesn't keep flapping between levels.
     
-    //More bandwidth will be served if the client reports "getting better"
+    QTSS_RTPStreamObject theStream = inParams->inRTPStream;
+    QTSS_ClientSessionObject theSession = inParams->inClientSession;
     
     //If the initial values of our dictionary items aren't yet in, put them in.
-    InitializeDictionaryItems(inParams->inRTPStream);
+    InitializeDictionaryItems(theSession);
     
-    QTSS_RTPStreamObject theStream = inParams->inRTPStream;
-
-    Bool16 ratchetMore = false;
-    Bool16 ratchetLess = false;
+    FlowControlCounts theCounts;
+    theCounts.fNumCongested = GetUInt32(theSession, sNumCongestedAttr);
+    theCounts.fNumClear = GetUInt32(theSession, sNumClearAttr);
+    theCounts.fNumClearToThick = GetUInt32(theSession, sNumClearToThickAttr);
+    theCounts.fNumWorses = GetUInt32(theSession, sNumWorsesAttr);
+    theCounts.fMinRTT = GetUInt32(theSession, sMinRTTAttr);
+    UInt32 theOldMinRTT = theCounts.fMinRTT;
     
-    Bool16 clearPercentLossThinCount = true;
-    Bool16 clearPercentLossThickCount = true;
+    //Loss. The receiver report has it in 256ths, the status packet in % times 256
+    UInt32 thePercentLoss = GetUInt32(theStream, qtssRTPStrFractionLostPackets) * 100 / 256;
+    UInt32 theAppPercentLoss = GetUInt16(theStream, qtssRTPStrPercentPacketsLost) / 256;
+    if (theAppPercentLoss > thePercentLoss)
+        thePercentLoss = theAppPercentLoss;
+        
+    UInt32 theRTT = GetUInt32(theStream, qtssRTPStrRoundTripTimeInMsec);
     
-    UInt32* uint32Ptr = NULL;
-    UInt16* uint16Ptr = NULL;
-    theLen = 0;
-    
-    UInt32 theNumLossesAboveTol = 0;
-    UInt32 theNumLossesBelowTol = 0;
-    UInt32 theNumWorses = 0;
-
-    // Get our current counts for this stream. If any of these aren't present, something is seriously wrong
-    // with this dictionary, so we should probably just abort
-    (void)QTSS_GetValuePtr(theStream, sNumLossesAboveTolAttr, 0, (void**)&uint32Ptr, &theLen);
-    if ((uint32Ptr != NULL) && (theLen == sizeof(UInt32)))
-        theNumLossesAboveTol = *uint32Ptr;
-
-    (void)QTSS_GetValuePtr(theStream, sNumLossesBelowTolAttr, 0, (void**)&uint32Ptr, &theLen);
-    if ((uint32Ptr != NULL) && (theLen == sizeof(UInt32)))
-        theNumLossesBelowTol = *uint32Ptr;
-
-    (void)QTSS_GetValuePtr(theStream, sNumWorsesAttr, 0, (void**)&uint32Ptr, &theLen);
-    if ((uint32Ptr != NULL) && (theLen == sizeof(UInt32)))
-        theNumWorses = *uint32Ptr;
-     
-    
-    //First take any action necessitated by the loss percent
-    (void)QTSS_GetValuePtr(inParams->inRTPStream, qtssRTPStrPercentPacketsLost, 0, (void**)&uint16Ptr, &theLen);
-    if ((uint16Ptr != NULL) && (theLen == sizeof(UInt16)))
+    //Jitter comes in timestamp units
+    UInt32 theJitterInMsec = 0;
+    UInt32 theTimescale = GetUInt32(theStream, qtssRTPStrTimescale);
+    if (theTimescale > 0)
+        theJitterInMsec = (UInt32)((UInt64)GetUInt32(theStream, qtssRTPStrJitter) * 1000 / theTimescale);
+    
+    //How far behind the server is in sending
+    SInt32 theDelay = (SInt32)GetUInt32(theStream, qtssRTPStrCurPacketDelayInMsec);
+    
+    UInt32 theAdjustment = CheckReport(&theCounts, thePercentLoss, theRTT, theJitterInMsec, theDelay,
+                                        GetUInt16(theStream, qtssRTPStrGettingWorse) != 0,
+                                        GetUInt16(theStream, qtssRTPStrGettingBetter) > 0);
+    if (theAdjustment == kThin)
+        AdjustQuality(theSession, true);
+    else if (theAdjustment == kThicken)
+        AdjustQuality(theSession, false);
+    
+    if (theCounts.fMinRTT != theOldMinRTT)
+        (void)QTSS_SetValue(theSession, sMinRTTAttr, 0, &theCounts.fMinRTT, sizeof(theCounts.fMinRTT));
+    (void)QTSS_SetValue(theSession, sNumCongestedAttr, 0, &theCounts.fNumCongested, sizeof(theCounts.fNumCongested));
+    (void)QTSS_SetValue(theSession, sNumClearAttr, 0, &theCounts.fNumClear, sizeof(theCounts.fNumClear));
+    (void)QTSS_SetValue(theSession, sNumClearToThickAttr, 0, &theCounts.fNumClearToThick, sizeof(theCounts.fNumClearToThick));
+    (void)QTSS_SetValue(theSession, sNumWorsesAttr, 0, &theCounts.fNumWorses, sizeof(theCounts.fNumWorses));
+    return QTSS_NoErr;
+}
+
+UInt32 CheckReport(FlowControlCounts* ioCounts, UInt32 inPercentLoss, UInt32 inRTT, UInt32 inJitterInMsec,
+                    SInt32 inDelayInMsec, Bool16 inGettingWorse, Bool16 inGettingBetter)
+{
+    //
+    // Works only on what it is passed, so the decisions can be replayed without a session.
+    Bool16 isCongested = false;
+    Bool16 isClear = true;
+    
+    if (inPercentLoss > sLossThinTolerance)
+        isCongested = true;
+    if (inPercentLoss >= sLossThickTolerance)
+        isClear = false;
+        
+    //Round trip time, against the best seen so far. 0 means no measurement.
+    if (inRTT > 0)
     {
-        UInt16 thePercentLoss = *uint16Ptr;
-        thePercentLoss /= 256; //Hmmm... looks like the client reports loss percent in multiples of 256
-#if FLOW_CONTROL_DEBUGGING
-        qtss_printf("Percent loss: %d\n", thePercentLoss);
-#endif
+        if ((ioCounts->fMinRTT == 0) || (inRTT < ioCounts->fMinRTT))
+            ioCounts->fMinRTT = inRTT;
+        if (inRTT - ioCounts->fMinRTT > sRTTThinTolerance)
+            isCongested = true;
+        if (inRTT - ioCounts->fMinRTT > sRTTThinTolerance / 2)
+            isClear = false;
+    }
     
-        //check for a thinning condition
-        if (thePercentLoss > sLossThinTolerance)
-        {
-            theNumLossesAboveTol++;//we must count this loss
+    if (inJitterInMsec > sJitterThinTolerance)
+        isCongested = true;
+    if (inJitterInMsec > sJitterThinTolerance / 2)
+        isClear = false;
+    
+    if (inDelayInMsec > (SInt32)sDelayThinTolerance)
+        isCongested = true;
+    if (inDelayInMsec > (SInt32)sDelayThinTolerance / 2)
+        isClear = false;
+        
+    if (isCongested)
+        isClear = false;
 
-            //We only adjust after a certain number of these in a row. Check to see if we've
-            //satisfied the thinning condition, and adjust the count
-            if (theNumLossesAboveTol >= sNumLossesToThin)
-            {
-#if FLOW_CONTROL_DEBUGGING
-                qtss_printf("Percent loss too high: ratcheting less\n");
-#endif
-                ratchetLess = true;
-            }
-            else
-            {
-#if FLOW_CONTROL_DEBUGGING
-                qtss_printf("Percent loss too high: Incrementing percent loss count to %lu\n", theNumLossesAboveTol);
-#endif
-                (void)QTSS_SetValue(theStream, sNumLossesAboveTolAttr, 0, &theNumLossesAboveTol, sizeof(theNumLossesAboveTol));
-                clearPercentLossThinCount = false;
-            }
-        }
-        //check for a thickening condition
-        else if (thePercentLoss < sLossThickTolerance)
-        {
-            theNumLossesBelowTol++;//we must count this loss
-            if (theNumLossesBelowTol >= sLossesToThick)
-            {
 #if FLOW_CONTROL_DEBUGGING
-                qtss_printf("Percent is low: ratcheting more\n");
+    qtss_printf("Loss %lu%%, RTT %lu (min %lu), jitter %lu, delay %ld: %s\n", inPercentLoss, inRTT, ioCounts->fMinRTT,
+                inJitterInMsec, inDelayInMsec, isCongested ? "congested" : (isClear ? "clear" : "neither"));
 #endif
-                ratchetMore = true;
-            }
-            else
-            {
-#if FLOW_CONTROL_DEBUGGING
-                qtss_printf("Percent is low: Incrementing percent loss count to %lu\n", theNumLossesBelowTol);
-#endif
-                (void)QTSS_SetValue(theStream, sNumLossesBelowTolAttr, 0, &theNumLossesBelowTol, sizeof(theNumLossesBelowTol));
-                clearPercentLossThickCount = false;
-            }           
-        }
-    }
+    
+    //Only reports in a row count
+    ioCounts->fNumCongested = isCongested ? ioCounts->fNumCongested + 1 : 0;
+    ioCounts->fNumClear = isClear ? ioCounts->fNumClear + 1 : 0;
+    
+    Bool16 ratchetLess = (ioCounts->fNumCongested >= sNumLossesToThin);
+    Bool16 ratchetMore = (ioCounts->fNumClear >= ioCounts->fNumClearToThick);
     
     //Now take a look at the getting worse heuristic
-    (void)QTSS_GetValuePtr(inParams->inRTPStream, qtssRTPStrGettingWorse, 0, (void**)&uint16Ptr, &theLen);
-    if ((uint16Ptr != NULL) && (theLen == sizeof(UInt16)))
+    if (inGettingWorse)
+    {
+        ioCounts->fNumWorses++;//we must count this getting worse
+        
+        //If we've gotten N number of getting worses, then thin.
+        if (ioCounts->fNumWorses >= sWorsesToThin)
+            ratchetLess = true;
+    }
+
+    //Finally, if we get a getting better, ratchet up unless something else says not to
+    if (inGettingBetter && !isCongested)
+        ratchetMore = true;
+    
+    UInt32 theAdjustment = kNoChange;
+    if (ratchetLess)
     {
-        UInt16 isGettingWorse = *uint16Ptr;
-        if (isGettingWorse != 0)
-        {
-            theNumWorses++;//we must count this getting worse
-            
-            //If we've gotten N number of getting worses, then thin. Otherwise, just
-            //increment our count of getting worses
-            if (theNumWorses >= sWorsesToThin)
-            {
 #if FLOW_CONTROL_DEBUGGING
-                qtss_printf("Client reporting getting worse. Ratcheting less\n");
+        qtss_printf("Ratcheting less\n");
 #endif
-                ratchetLess = true;
-            }
-            else
-            {
+        theAdjustment = kThin;
+        
+        ioCounts->fNumClearToThick *= 2;
+        if (ioCounts->fNumClearToThick > sLossesToThick * kMaxThickBackoff)
+            ioCounts->fNumClearToThick = sLossesToThick * kMaxThickBackoff;
+    }
+    else if (ratchetMore)
+    {
 #if FLOW_CONTROL_DEBUGGING
-                qtss_printf("Client reporting getting worse. Incrementing num worses count to %lu\n", theNumWorses);
+        qtss_printf("Ratcheting more\n");
 #endif
-                (void)QTSS_SetValue(theStream, sNumWorsesAttr, 0, &theNumWorses, sizeof(theNumWorses));
-            }
-        }
+        theAdjustment = kThicken;
+        
+        ioCounts->fNumClearToThick /= 2;
+        if (ioCounts->fNumClearToThick < sLossesToThick)
+            ioCounts->fNumClearToThick = sLossesToThick;
     }
 
-    //Finally, if we get a getting better, automatically ratchet up
-    (void)QTSS_GetValuePtr(inParams->inRTPStream, qtssRTPStrGettingBetter, 0, (void**)&uint16Ptr, &theLen);
-    if ((uint16Ptr != NULL) && (theLen == sizeof(UInt16)) && (*uint16Ptr > 0))
-        ratchetMore = true;
-        
-    //For clearing out counts below
-    UInt32 zero = 0;
+    //When adjusting the quality, ALWAYS clear out ALL our counts of EVERYTHING. Note
+    //that this is the ONLY way that the num getting worses count gets cleared
+    if (theAdjustment != kNoChange)
+    {
+        ioCounts->fNumCongested = 0;
+        ioCounts->fNumClear = 0;
+        ioCounts->fNumWorses = 0;
+    }
+    return theAdjustment;
+}
 
-    //Based on the ratchetMore / ratchetLess variables, adjust the stream
-    if (ratchetMore || ratchetLess)
+void AdjustQuality(QTSS_ClientSessionObject inSession, Bool16 inThin)
+{
+    UInt32* uint32Ptr = NULL;
+    UInt32 theLen = 0;
+    Bool16 allAtFullQuality = true;
+    
+    QTSS_RTPStreamObject* theStreamPtr = NULL;
+    for (UInt32 x = 0; QTSS_GetValuePtr(inSession, qtssCliSesStreamObjects, x, (void**)&theStreamPtr, &theLen) == QTSS_NoErr; x++)
     {
+        QTSS_RTPStreamObject theStream = *theStreamPtr;
+        if (GetUInt32(theStream, qtssRTPStrTransportType) != qtssRTPTransportTypeUDP)
+            continue;
+            
         UInt32 curQuality = 0;
         (void)QTSS_GetValuePtr(theStream, qtssRTPStrQualityLevel, 0, (void**)&uint32Ptr, &theLen);
         if ((uint32Ptr != NULL) && (theLen == sizeof(UInt32)))
             curQuality = *uint32Ptr;
 
-        UInt32 numQualityLevels = 0;
-        (void)QTSS_GetValuePtr(theStream, qtssRTPStrNumQualityLevels, 0, (void**)&uint32Ptr, &theLen);
-        if ((uint32Ptr != NULL) && (theLen == sizeof(UInt32)))
-            numQualityLevels = *uint32Ptr;
-            
-        if ((ratchetLess) && (curQuality < numQualityLevels))
+        UInt32 numQualityLevels = GetUInt32(theStream, qtssRTPStrNumQualityLevels);
+        UInt32 newQuality = NextQualityLevel(curQuality, numQualityLevels, GetUInt32(theStream, sNumAlternatesAttr), inThin);
+        if (newQuality != curQuality)
         {
-            curQuality++;
-            if (curQuality > 1) // v3.0.1=v2.0.1 make level 2 means key frames in the file or max if reflected.
-                curQuality = numQualityLevels;
-            (void)QTSS_SetValue(theStream, qtssRTPStrQualityLevel, 0, &curQuality, sizeof(curQuality));
-        }
-        else if ((ratchetMore) && (curQuality > 0))
-        {
-            curQuality--;
-            if (curQuality > 1)  // v3.0.1=v2.0.1 make level 2 means key frames in the file or max if reflected.
-                curQuality = 1;
+            curQuality = newQuality;
             (void)QTSS_SetValue(theStream, qtssRTPStrQualityLevel, 0, &curQuality, sizeof(curQuality));
         }
         
-
-        //When adjusting the quality, ALWAYS clear out ALL our counts of EVERYTHING. Note
-        //that this is the ONLY way that the fNumGettingWorses count gets cleared
-        (void)QTSS_SetValue(theStream, sNumWorsesAttr, 0, &zero, sizeof(zero));
-#if FLOW_CONTROL_DEBUGGING
-        qtss_printf("Clearing num worses count\n");
-#endif
-        clearPercentLossThinCount = true;
-        clearPercentLossThickCount = true;
+        if (curQuality > 0)
+            allAtFullQuality = false;
+        theLen = 0;
     }
     
-    //clear thick / thin counts if we are supposed to.
-    if (clearPercentLossThinCount)
+    Bool16 isOverbuffering = false;
+    theLen = sizeof(isOverbuffering);
+    (void)QTSS_GetValue(inSession, qtssCliSesOverBufferEnabled, 0, &isOverbuffering, &theLen);
+    UInt32 turnedOff = GetUInt32(inSession, sOverbufferingOffAttr);
+    
+    if (!CheckOverbuffering(inThin, allAtFullQuality, &isOverbuffering, &turnedOff))
+        return;
+        
+    (void)QTSS_SetValue(inSession, qtssCliSesOverBufferEnabled, 0, &isOverbuffering, sizeof(isOverbuffering));
+    (void)QTSS_SetValue(inSession, sOverbufferingOffAttr, 0, &turnedOff, sizeof(turnedOff));
+}
+
+UInt32 NextQualityLevel(UInt32 inCurQuality, UInt32 inNumQualityLevels, UInt32 inNumAlternates, Bool16 inThin)
+{
+    //
+    // The first inNumAlternates levels each switch to a lower bitrate alternate, so step
+    // through those one at a time. Past them, v3.0.1=v2.0.1: the level after the last
+    // alternate means key frames in the file, and anything past that goes straight to max.
+    UInt32 theKeyFrameLevel = inNumAlternates + 1;
+    if (inThin && (inCurQuality < inNumQualityLevels))
     {
-#if FLOW_CONTROL_DEBUGGING
-        qtss_printf("Clearing num losses above tolerance count\n");
-#endif
-        (void)QTSS_SetValue(theStream, sNumLossesAboveTolAttr, 0, &zero, sizeof(zero));
+        inCurQuality++;
+        if (inCurQuality > theKeyFrameLevel)
+            inCurQuality = inNumQualityLevels;
     }
-    if (clearPercentLossThickCount)
+    else if (!inThin && (inCurQuality > 0))
     {
-#if FLOW_CONTROL_DEBUGGING
-        qtss_printf("Clearing num losses below tolerance count\n");
-#endif
-    
-        (void)QTSS_SetValue(theStream, sNumLossesBelowTolAttr, 0, &zero, sizeof(zero));
+        inCurQuality--;
+        if (inCurQuality > theKeyFrameLevel)
+            inCurQuality = theKeyFrameLevel;
     }
-    return QTSS_NoErr;
+    return inCurQuality;
+}
+
+Bool16 CheckOverbuffering(Bool16 inThin, Bool16 inAllAtFullQuality, Bool16* ioOverbuffering, UInt32* ioTurnedOff)
+{
+    //
+    // Overbuffering goes off with the first thinning, and back on once every stream is
+    // at full quality again. Only turn it back on if it was this module that turned it off.
+    // Returns true if anything changed.
+    if (inThin && *ioOverbuffering)
+    {
+        *ioOverbuffering = false;
+        *ioTurnedOff = 1;
+        return true;
+    }
+    if (!inThin && inAllAtFullQuality && (*ioTurnedOff != 0))
+    {
+        *ioOverbuffering = true;
+        *ioTurnedOff = 0;
+        return true;
+    }
+    return false;
+}
+
+UInt32 GetUInt32(QTSS_Object inObject, QTSS_AttributeID inAttr)
+{
+    UInt32* theValue = NULL;
+    UInt32 theLen = 0;
+    if ((QTSS_GetValuePtr(inObject, inAttr, 0, (void**)&theValue, &theLen) == QTSS_NoErr) && (theLen == sizeof(UInt32)))
+        return *theValue;
+    return 0;
+}
+
+UInt16 GetUInt16(QTSS_Object inObject, QTSS_AttributeID inAttr)
+{
+    UInt16* theValue = NULL;
+    UInt32 theLen = 0;
+    if ((QTSS_GetValuePtr(inObject, inAttr, 0, (void**)&theValue, &theLen) == QTSS_NoErr) && (theLen == sizeof(UInt16)))
+        return *theValue;
+    return 0;
 }
 
-void    InitializeDictionaryItems(QTSS_RTPStreamObject inStream)
+void    InitializeDictionaryItems(QTSS_ClientSessionObject inSession)
 {
     UInt32* theValue = NULL;
     UInt32 theValueLen = 0;
     
-    QTSS_Error theErr = QTSS_GetValuePtr(inStream, sNumLossesAboveTolAttr, 0, (void**)&theValue, &theValueLen);
+    QTSS_Error theErr = QTSS_GetValuePtr(inSession, sNumCongestedAttr, 0, (void**)&theValue, &theValueLen);
 
     if (theErr != QTSS_NoErr)
     {
         // The dictionary parameters haven't been initialized yet. Just set them all to 0.
-        (void)QTSS_SetValue(inStream, sNumLossesAboveTolAttr, 0, &theValueLen, sizeof(theValueLen));
-        (void)QTSS_SetValue(inStream, sNumLossesBelowTolAttr, 0, &theValueLen, sizeof(theValueLen));
-        (void)QTSS_SetValue(inStream, sNumWorsesAttr, 0, &theValueLen, sizeof(theValueLen));
+        theValueLen = 0;
+        (void)QTSS_SetValue(inSession, sNumCongestedAttr, 0, &theValueLen, sizeof(theValueLen));
+        (void)QTSS_SetValue(inSession, sNumClearAttr, 0, &theValueLen, sizeof(theValueLen));
+        (void)QTSS_SetValue(inSession, sNumWorsesAttr, 0, &theValueLen, sizeof(theValueLen));
+        (void)QTSS_SetValue(inSession, sMinRTTAttr, 0, &theValueLen, sizeof(theValueLen));
+        (void)QTSS_SetValue(inSession, sOverbufferingOffAttr, 0, &theValueLen, sizeof(theValueLen));
+        (void)QTSS_SetValue(inSession, sNumClearToThickAttr, 0, &sLossesToThick, sizeof(sLossesToThick));
     }
 }
+
+#if QTSSFLOWCONTROLMODULETESTING
+Bool16 QTSSFlowControlModule_Test()
+{
+    sLossThinTolerance = sDefaultLossThinTolerance;
+    sNumLossesToThin = sDefaultNumLossesToThin;
+    sLossThickTolerance = sDefaultLossThickTolerance;
+    sLossesToThick = sDefaultLossesToThick;
+    sWorsesToThin = sDefaultWorsesToThin;
+    sRTTThinTolerance = sDefaultRTTThinTolerance;
+    sJitterThinTolerance = sDefaultJitterThinTolerance;
+    sDelayThinTolerance = sDefaultDelayThinTolerance;
+    
+    FlowControlCounts theCounts;
+    ::memset(&theCounts, 0, sizeof(theCounts));
+    theCounts.fNumClearToThick = sLossesToThick;
+    
+    //Heavy loss thins after sNumLossesToThin reports in a row, and doubles the clear reports needed
+    for (UInt32 x = 1; x < sNumLossesToThin; x++)
+    {
+        if (CheckReport(&theCounts, 40, 0, 0, 0, false, false) != kNoChange)
+            return false;
+    }
+    if (CheckReport(&theCounts, 40, 0, 0, 0, false, false) != kThin)
+        return false;
+    if ((theCounts.fNumCongested != 0) || (theCounts.fNumClearToThick != sLossesToThick * 2))
+        return false;
+        
+    //A report that is neither congested nor clear breaks the run
+    if (CheckReport(&theCounts, 40, 0, 0, 0, false, false) != kNoChange)
+        return false;
+    if (CheckReport(&theCounts, 10, 0, 0, 0, false, false) != kNoChange)
+        return false;
+    if ((theCounts.fNumCongested != 0) || (theCounts.fNumClear != 0))
+        return false;
+    
+    //RTT well over the best seen thins too, and the backoff doubles up to its cap and stays there
+    if ((CheckReport(&theCounts, 0, 100, 0, 0, false, false) != kNoChange) || (theCounts.fMinRTT != 100))
+        return false;
+    UInt32 theExpected = sLossesToThick * 2;
+    for (UInt32 y = 0; y < 4; y++)
+    {
+        for (UInt32 z = 1; z < sNumLossesToThin; z++)
+        {
+            if (CheckReport(&theCounts, 0, 500, 0, 0, false, false) != kNoChange)
+                return false;
+        }
+        if (CheckReport(&theCounts, 0, 500, 0, 0, false, false) != kThin)
+            return false;
+        
+        theExpected *= 2;
+        if (theExpected > sLossesToThick * kMaxThickBackoff)
+            theExpected = sLossesToThick * kMaxThickBackoff;
+        if (theCounts.fNumClearToThick != theExpected)
+            return false;
+    }
+    if ((theCounts.fNumClearToThick != sLossesToThick * kMaxThickBackoff) || (theCounts.fMinRTT != 100))
+        return false;
+        
+    //High jitter is not clear, and resets the run of clear reports
+    if (CheckReport(&theCounts, 0, 100, 0, 0, false, false) != kNoChange)
+        return false;
+    if ((CheckReport(&theCounts, 0, 100, 150, 0, false, false) != kNoChange) || (theCounts.fNumClear != 0))
+        return false;
+    
+    //It then takes the full backed off count of clear reports to thicken, which halves the count
+    for (UInt32 a = 1; a < sLossesToThick * kMaxThickBackoff; a++)
+    {
+        if (CheckReport(&theCounts, 0, 100, 0, 0, false, false) != kNoChange)
+            return false;
+    }
+    if (CheckReport(&theCounts, 0, 100, 0, 0, false, false) != kThicken)
+        return false;
+    if ((theCounts.fNumClear != 0) || (theCounts.fNumClearToThick != sLossesToThick * kMaxThickBackoff / 2))
+        return false;
+        
+    //Getting better thickens right away unless the report is congested
+    if (CheckReport(&theCounts, 0, 100, 0, 2000, false, true) != kNoChange)
+        return false;
+    if (CheckReport(&theCounts, 0, 100, 0, 0, false, true) != kThicken)
+        return false;
+    
+    //Getting worse thins after sWorsesToThin of them, in a row or not
+    for (UInt32 b = 1; b < sWorsesToThin; b++)
+    {
+        if (CheckReport(&theCounts, 0, 100, 0, 0, true, false) != kNoChange)
+            return false;
+    }
+    if ((CheckReport(&theCounts, 0, 100, 0, 0, true, false) != kThin) || (theCounts.fNumWorses != 0))
+        return false;
+        
+    //Without alternates a thin goes to key frames, then to max. With them, it first steps
+    //down through each alternate. Thickening comes back the same way.
+    const UInt32 kNumLevels = 5;
+    UInt32 theThinSteps[] = { 1, kNumLevels, kNumLevels };
+    UInt32 theQuality = 0;
+    for (UInt32 c = 0; c < 3; c++)
+    {
+        theQuality = NextQualityLevel(theQuality, kNumLevels, 0, true);
+        if (theQuality != theThinSteps[c])
+            return false;
+    }
+    if ((NextQualityLevel(kNumLevels, kNumLevels, 0, false) != 1) || (NextQualityLevel(1, kNumLevels, 0, false) != 0))
+        return false;
+        
+    const UInt32 kNumAlternates = 3;
+    UInt32 theAlternateSteps[] = { 1, 2, 3, 4, kNumLevels + kNumAlternates, kNumLevels + kNumAlternates };
+    theQuality = 0;
+    for (UInt32 d = 0; d < 6; d++)
+    {
+        theQuality = NextQualityLevel(theQuality, kNumLevels + kNumAlternates, kNumAlternates, true);
+        if (theQuality != theAlternateSteps[d])
+            return false;
+    }
+    for (UInt32 e = kNumAlternates + 1; e > 0; e--)
+    {
+        theQuality = NextQualityLevel(theQuality, kNumLevels + kNumAlternates, kNumAlternates, false);
+        if (theQuality != e)
+            return false;
+    }
+    if (NextQualityLevel(theQuality, kNumLevels + kNumAlternates, kNumAlternates, false) != 0)
+        return false;
+        
+    //Overbuffering goes off on the first thinning, and comes back only once everything is at full quality
+    Bool16 isOverbuffering = true;
+    UInt32 turnedOff = 0;
+    if (!CheckOverbuffering(true, false, &isOverbuffering, &turnedOff) || isOverbuffering || (turnedOff != 1))
+        return false;
+    if (CheckOverbuffering(true, false, &isOverbuffering, &turnedOff))
+        return false;
+    if (CheckOverbuffering(false, false, &isOverbuffering, &turnedOff) || isOverbuffering)
+        return false;
+    if (!CheckOverbuffering(false, true, &isOverbuffering, &turnedOff) || !isOverbuffering || (turnedOff != 0))
+        return false;
+        
+    //If something else turned it off, it stays off
+    isOverbuffering = false;
+    if (CheckOverbuffering(false, true, &isOverbuffering, &turnedOff) || isOverbuffering)
+        return false;
+    
+    return true;
+}
+#endif
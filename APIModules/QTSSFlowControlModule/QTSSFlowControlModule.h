@@ -26,7 +26,9 @@
     File:       QTSSFlowControlModule.h
 
     Contains:   Uses information in RTCP packers to throttle back the server
-                when it's pumping out too much data to a given client
+                when it's pumping out too much data to a given client.
+                Loss, round trip time, jitter and how late the server is sending
+                all count, and the whole session is thinned or thickened at once.
     
     
     
@@ -38,9 +40,16 @@
 
 #include "QTSS.h"
 
+#define QTSSFLOWCONTROLMODULETESTING 0
+
 extern "C"
 {
     EXPORT QTSS_Error QTSSFlowControlModule_Main(void* inPrivateArgs);
 }
 
+#if QTSSFLOWCONTROLMODULETESTING
+// Replays loss and round trip time traces through the thin / thicken decisions
+Bool16 QTSSFlowControlModule_Test();
+#endif
+
 #endif //_QTSSFLOWCONTROLMODULE_H_
@@ -227,6 +227,8 @@ static QTSS_Error RedirectBroadcast(QTSS_StandardRTSP_Params* inParams);
 static Bool16 AllowBroadcast(QTSS_RTSPRequestObject inRTSPRequest);
 static Bool16 InBroadcastDirList(QTSS_RTSPRequestObject inRTSPRequest);
 static Bool16 IsAbsolutePath(StrPtrLen *inPathPtr);
+static SInt64 ParseClockRange(StrPtrLen* inRangeHeader);
+static Bool16 DoTimeShift(QTSS_StandardRTSP_Params* inParams, ReflectorSession* inSession);
 
 inline void KeepSession(QTSS_RTSPRequestObject theRequest,Bool16 keep)
 {
@@ -407,7 +409,7 @@ QTSS_Error Initialize(QTSS_Initialize_Params* inParams)
     sPrefs = QTSSModuleUtils::GetModulePrefsObject(inParams->inModule);
 
     // Call helper class initializers
-    ReflectorStream::Initialize(sPrefs);
+    ReflectorStream::Initialize(sPrefs, inParams->inServer);
     ReflectorSession::Initialize();
     
     // Report to the server that this module handles DESCRIBE, SETUP, PLAY, PAUSE, and TEARDOWN
@@ -726,6 +728,7 @@ QTSS_Error ProcessRTSPRequest(QTSS_StandardRTSP_Params* inParams)
             (void)QTSS_SendStandardRTSPResponse(inParams->inRTSPRequest, inParams->inClientSession, 0);
             break;
         case qtssPauseMethod:
+            (*theOutput)->Pause(OS::Milliseconds());
             (void)QTSS_Pause(inParams->inClientSession);
             (void)QTSS_SendStandardRTSPResponse(inParams->inRTSPRequest, inParams->inClientSession, 0);
             break;
@@ -1342,6 +1345,8 @@ ReflectorSession* FindOrCreateSession(StrPtrLen* inPath, QTSS_StandardRTSP_Param
         UInt32 theSetupFlag = ReflectorSession::kMarkSetup;
         if (isPush)
             theSetupFlag |= ReflectorSession::kIsPushSession;
+        if (ReflectorStream::GetTimeShiftMSec() > 0)
+            theSetupFlag |= ReflectorSession::kTimeShift;
         
         theSession = NEW ReflectorSession(inPath);
 		if (theSession == NULL)
@@ -1866,6 +1871,104 @@ Bool16 HaveStreamBuffers(QTSS_StandardRTSP_Params* inParams, ReflectorSession* i
     return haveBufferedStreams;
 }
 
+static UInt32 ConsumeDigits(StringParser* inParser, UInt32 inNumDigits, Bool16* ioOK)
+{
+    UInt32 theValue = 0;
+    for (UInt32 x = 0; x < inNumDigits; x++)
+    {
+        if (inParser->GetDataRemaining() == 0)
+        {   *ioOK = false;
+            return 0;
+        }
+        char theDigit = inParser->PeekFast();
+        if ((theDigit < '0') || (theDigit > '9'))
+        {   *ioOK = false;
+            return 0;
+        }
+        theValue = (theValue * 10) + (theDigit - '0');
+        inParser->ConsumeLength(NULL, 1);
+    }
+    return theValue;
+}
+
+SInt64 ParseClockRange(StrPtrLen* inRangeHeader)
+{
+    // Returns the start of a "clock=YYYYMMDDTHHMMSS[.fraction]Z-" range (RFC 2326 absolute time)
+    // in milliseconds since 1970, or 0 if the range isn't in that form.
+    StringParser theParser(inRangeHeader);
+    theParser.ConsumeWhitespace();
+    
+    StrPtrLen theUnits;
+    theParser.ConsumeUntil(&theUnits, '=');
+    if (!theUnits.EqualIgnoreCase("clock", 5) || !theParser.Expect('='))
+        return 0;
+        
+    Bool16 isOK = true;
+    SInt32 theYear = (SInt32) ConsumeDigits(&theParser, 4, &isOK);
+    UInt32 theMonth = ConsumeDigits(&theParser, 2, &isOK);
+    UInt32 theDay = ConsumeDigits(&theParser, 2, &isOK);
+    if (!isOK || !theParser.Expect('T'))
+        return 0;
+    UInt32 theHour = ConsumeDigits(&theParser, 2, &isOK);
+    UInt32 theMinute = ConsumeDigits(&theParser, 2, &isOK);
+    UInt32 theSecond = ConsumeDigits(&theParser, 2, &isOK);
+    if (!isOK || (theMonth < 1) || (theMonth > 12) || (theDay < 1) || (theDay > 31) || (theHour > 23) || (theMinute > 59) || (theSecond > 60))
+        return 0;
+
+    UInt32 theMilliseconds = 0;
+    if (theParser.Expect('.'))
+    {
+        UInt32 theScale = 100;
+        while ((theParser.GetDataRemaining() > 0) && (theParser.PeekFast() >= '0') && (theParser.PeekFast() <= '9'))
+        {
+            theMilliseconds += (theParser.PeekFast() - '0') * theScale;
+            theScale /= 10;
+            theParser.ConsumeLength(NULL, 1);
+        }
+    }
+    if (!theParser.Expect('Z'))
+        return 0;
+        
+    // Days since 1970-01-01 in the proleptic Gregorian calendar
+    if (theMonth <= 2)
+        theYear -= 1;
+    SInt32 theEra = theYear / 400;
+    SInt32 theYearOfEra = theYear - (theEra * 400);
+    SInt32 theDayOfYear = (153 * (theMonth > 2 ? theMonth - 3 : theMonth + 9) + 2) / 5 + theDay - 1;
+    SInt32 theDayOfEra = (theYearOfEra * 365) + (theYearOfEra / 4) - (theYearOfEra / 100) + theDayOfYear;
+    SInt64 theDays = ((SInt64) theEra * 146097) + theDayOfEra - 719468;
+    
+    SInt64 theSeconds = (theDays * 86400) + (theHour * 3600) + (theMinute * 60) + theSecond;
+    return (theSeconds * 1000) + theMilliseconds;
+}
+
+Bool16 DoTimeShift(QTSS_StandardRTSP_Params* inParams, ReflectorSession* inSession)
+{
+    // Decides whether this PLAY starts in the past. A "clock=" Range asks for a point in
+    // the past, no Range after a PAUSE resumes where the client left off, and anything
+    // else (npt=now-, npt=0-) is live. If the time-shift buffers don't have the requested
+    // time the client gets the live stream.
+    RTPSessionOutput** theOutput = NULL;
+    UInt32 theLen = 0;
+    QTSS_Error theErr = QTSS_GetValuePtr(inParams->inClientSession, sOutputAttr, 0, (void**)&theOutput, &theLen);
+    if ((theErr != QTSS_NoErr) || (theLen != sizeof(RTPSessionOutput*)) || (*theOutput == NULL))
+        return false;
+    
+    SInt64 thePosition = 0;
+    StrPtrLen theRangeHeader;
+    if (QTSS_GetValuePtr(inParams->inRTSPHeaders, qtssRangeHeader, 0, (void**)&theRangeHeader.Ptr, &theRangeHeader.Len) == QTSS_NoErr)
+        thePosition = ParseClockRange(&theRangeHeader);
+    else
+        thePosition = (*theOutput)->GetPausePosition();
+        
+    SInt64 theLivePosition = OS::Milliseconds() - ReflectorStream::sOverBufferInMsec;
+    if ((thePosition > 0) && (thePosition < theLivePosition) && (*theOutput)->StartTimeShift(thePosition))
+        return true;
+    
+    (*theOutput)->StopTimeShift();
+    return false;
+}
+
 QTSS_Error DoPlay(QTSS_StandardRTSP_Params* inParams, ReflectorSession* inSession)
 {
     QTSS_Error theErr = QTSS_NoErr;
@@ -1948,6 +2051,22 @@ QTSS_Error DoPlay(QTSS_StandardRTSP_Params* inParams, ReflectorSession* inSessio
         UInt32 bitsPerSecond =  inSession->GetBitRate();
         (void)QTSS_SetValue(inParams->inClientSession, qtssCliSesMovieAverageBitRate, 0, &bitsPerSecond, sizeof(bitsPerSecond));
    
+        if ((ReflectorStream::GetTimeShiftMSec() > 0) && DoTimeShift(inParams, inSession))
+        {
+            // The time-shift task has the first sequence number and timestamp of every
+            // stream already, so there's no need to wait for the live buffers.
+            flags = qtssPlayRespWriteTrackInfo;
+            theErr = QTSS_Play(inParams->inClientSession, inParams->inRTSPRequest, qtssPlayRespWriteTrackInfo);
+            if (theErr != QTSS_NoErr)
+                return theErr;
+                
+            if (sRTPInfoFullURL)
+                flags |= qtssPlayFlagsRTPInfoFullURL;
+
+            (void)QTSS_SendStandardRTSPResponse(inParams->inRTSPRequest, inParams->inClientSession, flags);
+            return QTSS_NoErr;
+        }
+        
         if (sPlayResponseRangeHeader)
         {
             StrPtrLen temp;
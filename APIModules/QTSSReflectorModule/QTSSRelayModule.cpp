@@ -358,7 +358,7 @@ QTSS_Error Initialize(QTSS_Initialize_Params* inParams)
         QTSSModuleUtils::GetModulePrefsObject(QTSSModuleUtils::GetModuleObjectByName(theReflectorModule));
 
     // Call helper class initializers
-    ReflectorStream::Initialize(theReflectorPrefs);
+    ReflectorStream::Initialize(theReflectorPrefs, inParams->inServer);
     RereadPrefs();
 
     return QTSS_NoErr;
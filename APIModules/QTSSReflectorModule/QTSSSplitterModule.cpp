@@ -185,7 +185,7 @@ QTSS_Error Initialize(QTSS_Initialize_Params* inParams)
         QTSSModuleUtils::GetModulePrefsObject(QTSSModuleUtils::GetModuleObjectByName(theReflectorModule));
 
     // Call helper class initializers
-    ReflectorStream::Initialize(theReflectorPrefs);
+    ReflectorStream::Initialize(theReflectorPrefs, inParams->inServer);
     ReflectorSession::Initialize();
         
     // Report to the server that this module handles DESCRIBE, SETUP, PLAY, PAUSE, and TEARDOWN
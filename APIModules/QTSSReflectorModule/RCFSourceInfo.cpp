@@ -167,9 +167,15 @@ void RCFSourceInfo::ParseRelayDestinations(XMLTag* relayTag)
             return;
         
         if (!strcmp(destType, "udp_destination"))
-            ParseDestination(destTag, y);
+            ParseDestination(destTag, fNumOutputs);
         else if (!strcmp(destType, "announced_destination"))
-            ParseAnnouncedDestination(destTag, y);
+            ParseAnnouncedDestination(destTag, fNumOutputs);
+        else if (!strcmp(destType, "relay_tree"))
+        {
+            // Leaf nodes of a relay tree have nothing to send
+            if (!ParseTreeDestination(destTag, fNumOutputs))
+                continue;
+        }
             
         fNumOutputs++;
     }
@@ -235,6 +241,114 @@ void RCFSourceInfo::ParseDestination(XMLTag* destTag, UInt32 index)
     }
 }
 
+Bool16 RCFSourceInfo::ParseTreeDestination(XMLTag* destTag, UInt32 index)
+{
+    // A relay tree destination lists every relay node of a distribution tree along
+    // with the number of children each node is willing to feed. Every server in the
+    // tree reads the same description, builds the same tree, finds itself in it by
+    // local address, and sends only to its own children. A server that is not one
+    // of the listed nodes is the root of the tree.
+    //
+    // The tree is filled breadth first in the order the nodes are listed: the root
+    // takes the first "fan_out" nodes as children, the first listed node takes the
+    // next "node_fan_out" nodes, and so on. Nodes that don't fit anywhere are left out.
+    XMLTag* nodeListTag = destTag->GetEmbeddedTagByNameAndAttr("LIST-PREF", "NAME", "node_addrs");
+    if (nodeListTag == NULL)
+        return false;
+    
+    UInt32 theNumNodes = nodeListTag->GetNumEmbeddedTags();
+    if (theNumNodes == 0)
+        return false;
+    
+    UInt32 theDefaultFanOut = kDefaultTreeFanOut;
+    XMLTag* prefTag = destTag->GetEmbeddedTagByNameAndAttr("PREF", "NAME", "fan_out");
+    if ((prefTag != NULL) && (prefTag->GetValue() != NULL))
+        theDefaultFanOut = ::atoi(prefTag->GetValue());
+    
+    XMLTag* fanOutListTag = destTag->GetEmbeddedTagByNameAndAttr("LIST-PREF", "NAME", "node_fan_out");
+    
+    UInt32* theNodeAddrs = NEW UInt32[theNumNodes];
+    UInt32* theNodeFanOut = NEW UInt32[theNumNodes];
+    SInt32* theNodeParent = NEW SInt32[theNumNodes];
+    SInt32 theLocalNode = -1;
+    
+    for (UInt32 x = 0; x < theNumNodes; x++)
+    {
+        theNodeAddrs[x] = 0;
+        XMLTag* valueTag = nodeListTag->GetEmbeddedTagByName("VALUE", x);
+        if ((valueTag != NULL) && (valueTag->GetValue() != NULL))
+            theNodeAddrs[x] = SocketUtils::ConvertStringToAddr(valueTag->GetValue());
+        
+        theNodeFanOut[x] = theDefaultFanOut;
+        if (fanOutListTag != NULL)
+        {
+            valueTag = fanOutListTag->GetEmbeddedTagByName("VALUE", x);
+            if ((valueTag != NULL) && (valueTag->GetValue() != NULL))
+                theNodeFanOut[x] = ::atoi(valueTag->GetValue());
+        }
+
+        if ((theLocalNode == -1) && (theNodeAddrs[x] != 0) && SocketUtils::IsLocalIPAddr(theNodeAddrs[x]))
+            theLocalNode = (SInt32)x;
+    }
+    
+    // Assign parents. -1 is the root, kNoTreeParent marks a node that didn't fit.
+    SInt32 theParent = -1;
+    UInt32 theParentFanOut = theDefaultFanOut;
+    UInt32 theNumChildren = 0;
+    UInt32 theNextParent = 0;
+    for (UInt32 y = 0; y < theNumNodes; y++)
+    {
+        while ((theNumChildren == theParentFanOut) && (theNextParent < y))
+        {
+            if (theNodeParent[theNextParent] != kNoTreeParent)
+            {
+                theParent = (SInt32)theNextParent;
+                theParentFanOut = theNodeFanOut[theNextParent];
+                theNumChildren = 0;
+            }
+            theNextParent++;
+        }
+        
+        if ((theNumChildren == theParentFanOut) || (theNodeAddrs[y] == 0))
+        {
+            theNodeParent[y] = kNoTreeParent;
+            continue;
+        }
+        theNodeParent[y] = theParent;
+        theNumChildren++;
+    }
+
+    UInt32 theNumLocalChildren = 0;
+    for (UInt32 z = 0; z < theNumNodes; z++)
+    {
+        if (theNodeParent[z] == theLocalNode)
+            theNodeAddrs[theNumLocalChildren++] = theNodeAddrs[z];
+    }
+    
+    UInt32 theDepth = 0;
+    if ((theLocalNode != -1) && (theNodeParent[theLocalNode] == kNoTreeParent))
+        theNumLocalChildren = 0; // this server didn't make it into the tree
+    else for (SInt32 theNode = theLocalNode; theNode != -1; theNode = theNodeParent[theNode])
+        theDepth++;
+    
+    delete [] theNodeFanOut;
+    delete [] theNodeParent;
+    
+    if (theNumLocalChildren == 0)
+    {
+        delete [] theNodeAddrs;
+        return false;
+    }
+    
+    // out_addr, ttl and the ports are parsed just like a udp_destination
+    this->ParseDestination(destTag, index);
+    fOutputArray[index].fFanOutAddrArray = theNodeAddrs;
+    fOutputArray[index].fNumFanOutAddrs = theNumLocalChildren;
+    fOutputArray[index].fDestAddr = theNodeAddrs[0];
+    fOutputArray[index].fTreeDepth = theDepth;
+    return true;
+}
+
 void RCFSourceInfo::ParseAnnouncedDestination(XMLTag* destTag, UInt32 index)
 {
     // should log some sort of error
@@ -62,9 +62,19 @@ class RCFSourceInfo : public SourceInfo
     protected:
         virtual void ParseDestination(XMLTag* destTag, UInt32 index);
         virtual void ParseAnnouncedDestination(XMLTag* destTag, UInt32 index);
+        
+        // Sets up the output with this server's children in a relay tree.
+        // Returns false if this server has no children to send to.
+        Bool16  ParseTreeDestination(XMLTag* destTag, UInt32 index);
         virtual void AllocateOutputArray(UInt32 numOutputs);
                 
                 char*   fName;
+                
+        enum
+        {
+            kDefaultTreeFanOut  = 4,
+            kNoTreeParent       = -2
+        };
 
 };
 #endif // __SDP_SOURCE_INFO_H__
@@ -33,6 +33,7 @@
 
 #include "RTPSessionOutput.h"
 #include "ReflectorStream.h"
+#include "OSMemory.h"
 
 #include <errno.h>
 
@@ -77,17 +78,25 @@ RTPSessionOutput::RTPSessionOutput(QTSS_ClientSessionObject inClientSession, Ref
     fReflectorSession(inReflectorSession),
     fCookieAttrID(inCookieAddrID),
     fBufferDelayMSecs(ReflectorStream::sOverBufferInMsec),
+    fFastStartBeginTime(0),
     fBaseArrivalTime(0),
     fIsUDP(false),
     fTransportInitialized(false),
     fMustSynch(true),
-    fPreFilter(true)
+    fPreFilter(true),
+    fTimeShiftTask(NULL),
+    fPausePosition(0)
 {
     // create a bookmark for each stream we'll reflect
     this->InititializeBookmarks( inReflectorSession->GetNumStreams() );
    
 }
 
+RTPSessionOutput::~RTPSessionOutput()
+{
+    this->StopTimeShift();
+}
+
 void RTPSessionOutput::Register()
 {
     // Add some attributes to QTSS_RTPStream dictionary 
@@ -546,7 +555,7 @@ QTSS_Error  RTPSessionOutput::TrackPackets(QTSS_RTPStreamObject *theStreamPtr, S
 }
 
 
-QTSS_Error  RTPSessionOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec, SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTimeMSecPtr)
+QTSS_Error  RTPSessionOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec, SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTimeMSecPtr, OSSharedBuffer* inSharedBuffer)
 {
     QTSS_RTPSessionState*   theState = NULL;
     UInt32                  theLen = 0;
@@ -556,6 +565,13 @@ QTSS_Error  RTPSessionOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCoo
     (void)QTSS_GetValuePtr(fClientSession, qtssCliSesState, 0, (void**)&theState, &theLen);
     if (*theState != qtssPlayingState)
        return QTSS_WouldBlock;
+    
+    // While time-shifting this client only gets packets from the time-shift task.
+    // Live packets are skipped, not held, so the senders don't wait on this output.
+    if (inFlags & ReflectorOutput::kTimeShiftedPacket)
+        inFlags &= ~ReflectorOutput::kTimeShiftedPacket;
+    else if (fTimeShiftTask != NULL)
+        return QTSS_NoErr;
             
     //make sure all RTP streams with this ID see this packet
     QTSS_RTPStreamObject *theStreamPtr = NULL;
@@ -577,10 +593,17 @@ QTSS_Error  RTPSessionOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCoo
        // TrackPackets below is for re-writing the rtcps we don't use it right now-- shouldn't need to    
        // (void) this->TrackPackets(theStreamPtr, inPacket, &currentTime,inFlags,  &packetLatenessInMSec, timeToSendThisPacketAgain, packetIDPtr,arrivalTimeMSecPtr);
 
-            QTSS_PacketStruct thePacket;
+            // Passing the shared buffer along lets a reliable UDP stream keep the packet
+            // for retransmits without copying it
+            QTSS_SharedPacketStruct theSharedPacket;
+            QTSS_PacketStruct& thePacket = theSharedPacket.packet;
+            theSharedPacket.sharedBuffer = inSharedBuffer;
             thePacket.packetData = inPacket->Ptr;
-            thePacket.packetTransmitTime = (currentTime - packetLatenessInMSec) + (fBufferDelayMSecs - (currentTime - *arrivalTimeMSecPtr)); // add buffer time where oldest buffered packet as now == 0 and newest is entire buffer time in the future.
-            writeErr = QTSS_Write(*theStreamPtr, &thePacket, inPacket->Len, NULL, inFlags | qtssWriteFlagsWriteBurstBegin); 
+            thePacket.packetTransmitTime = (currentTime - packetLatenessInMSec) + (this->GetBufferDelay(currentTime) - (currentTime - *arrivalTimeMSecPtr)); // add buffer time where oldest buffered packet as now == 0 and newest is entire buffer time in the future.
+            UInt32 theWriteFlags = inFlags | qtssWriteFlagsWriteBurstBegin;
+            if (inSharedBuffer != NULL)
+                theWriteFlags |= qtssWriteFlagsSharedPacket;
+            writeErr = QTSS_Write(*theStreamPtr, &theSharedPacket, inPacket->Len, NULL, theWriteFlags); 
             if (writeErr == QTSS_WouldBlock)
             {  
                 //
@@ -609,6 +632,86 @@ QTSS_Error  RTPSessionOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCoo
     return writeErr;
 }
 
+Bool16 RTPSessionOutput::StartTimeShift(SInt64 inPosition)
+{
+    this->StopTimeShift();
+    
+    ReflectorTimeShiftTask* theTask = NEW ReflectorTimeShiftTask(fReflectorSession, this);
+    if (!theTask->Seek(inPosition, fBufferDelayMSecs))
+    {
+        delete theTask; // never signalled, so it is safe to delete here
+        return false;
+    }
+    
+    QTSS_RTPStreamObject *theStreamPtr = NULL;
+    UInt32 theLen = 0;
+    for (UInt32 z = 0; QTSS_GetValuePtr(fClientSession, qtssCliSesStreamObjects, z, (void**)&theStreamPtr, &theLen) == QTSS_NoErr; z++)
+    {
+        UInt16 theFirstSeqNum = 0;
+        UInt32 theFirstTimeStamp = 0;
+        for (UInt32 y = 0; y < fReflectorSession->GetNumStreams(); y++)
+        {
+            if (this->PacketMatchesStream(fReflectorSession->GetStreamByIndex(y)->GetStreamCookie(), theStreamPtr)
+                && theTask->GetFirstPacketInfo(y, &theFirstSeqNum, &theFirstTimeStamp))
+            {
+                (void) QTSS_SetValue(*theStreamPtr, qtssRTPStrFirstSeqNumber, 0, &theFirstSeqNum, sizeof(theFirstSeqNum));
+                (void) QTSS_SetValue(*theStreamPtr, qtssRTPStrFirstTimestamp, 0, &theFirstTimeStamp, sizeof(theFirstTimeStamp));
+                break;
+            }
+        }
+        
+        // Packet IDs from the buffer are older than the ones already sent live
+        (void) QTSS_RemoveValue(*theStreamPtr, sLastRTPPacketIDAttr, 0);
+        (void) QTSS_RemoveValue(*theStreamPtr, sLastRTCPPacketIDAttr, 0);
+    }
+    
+    fPreFilter = true;
+    fFastStartBeginTime = 0;
+    fPausePosition = 0;
+    fTimeShiftTask = theTask;
+    fTimeShiftTask->Signal(Task::kStartEvent);
+    return true;
+}
+
+void RTPSessionOutput::StopTimeShift()
+{
+    if (fTimeShiftTask == NULL)
+        return;
+    
+    // The task deletes itself
+    fTimeShiftTask->Detach();
+    fTimeShiftTask = NULL;
+}
+
+void RTPSessionOutput::Pause(SInt64 inCurrentTime)
+{
+    if (fTimeShiftTask != NULL)
+        fPausePosition = fTimeShiftTask->GetPlayPosition(inCurrentTime, fBufferDelayMSecs);
+    else
+        fPausePosition = inCurrentTime - fBufferDelayMSecs;
+        
+    this->StopTimeShift();
+}
+
+SInt64 RTPSessionOutput::GetBufferDelay(SInt64 inCurrentTime)
+{
+    // Fast start. Starting with the first packet written after PLAY, shrink the buffer delay
+    // so the buffered packets go out at sFastStartRate times real time. Once the delay is
+    // gone packets are sent as they arrive. Packets scheduled ahead of real time are still
+    // held back by the client's overbuffer window, so the burst can't overrun the client.
+    if (ReflectorStream::sFastStartRate == 0.0)
+        return fBufferDelayMSecs;
+        
+    if (fFastStartBeginTime == 0)
+        fFastStartBeginTime = inCurrentTime;
+    
+    SInt64 theCatchUpMSecs = (SInt64) ((Float64) (inCurrentTime - fFastStartBeginTime) * (ReflectorStream::sFastStartRate - 1.0));
+    if (theCatchUpMSecs >= (SInt64) fBufferDelayMSecs)
+        return 0;
+        
+    return fBufferDelayMSecs - theCatchUpMSecs;
+}
+
 UInt16 RTPSessionOutput::GetPacketSeqNumber(StrPtrLen* inPacket)
 {
     if (inPacket->Len < 4)
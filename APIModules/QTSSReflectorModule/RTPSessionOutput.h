@@ -38,6 +38,7 @@
 
 #include "ReflectorOutput.h"
 #include "ReflectorSession.h"
+#include "ReflectorTimeShift.h"
 #include "QTSS.h"
 
 class RTPSessionOutput : public ReflectorOutput
@@ -49,31 +50,47 @@ class RTPSessionOutput : public ReflectorOutput
         
         RTPSessionOutput(QTSS_ClientSessionObject inRTPSession, ReflectorSession* inReflectorSession,
                             QTSS_Object serverPrefs, QTSS_AttributeID inCookieAddrID);
-        virtual ~RTPSessionOutput() {}
+        virtual ~RTPSessionOutput();
         
         ReflectorSession* GetReflectorSession() { return fReflectorSession; }
         
         // This writes the packet out to the proper QTSS_RTPStreamObject.
         // If this function returns QTSS_WouldBlock, timeToSendThisPacketAgain will
         // be set to # of msec in which the packet can be sent, or -1 if unknown
-        virtual QTSS_Error  WritePacket(StrPtrLen* inPacketData, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec, SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTimeMSec );
+        virtual QTSS_Error  WritePacket(StrPtrLen* inPacketData, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec, SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTimeMSec, OSSharedBuffer* inSharedBuffer = NULL);
         virtual void TearDown();
         
         SInt64                  GetReflectorSessionInitTime()                    { return fReflectorSession->GetInitTimeMS(); }
         
         virtual Bool16  IsUDP();
         
+        // Time-shift. StartTimeShift plays the session to this client from inPosition
+        // (milliseconds since 1970) out of the streams' time-shift buffers, and sets the
+        // first sequence number and timestamp of each stream for the RTP-Info header.
+        // Live packets are ignored until StopTimeShift. Returns false if the buffers
+        // don't go back that far, in which case the client stays live.
+        Bool16          StartTimeShift(SInt64 inPosition);
+        void            StopTimeShift();
+        Bool16          IsTimeShifting()            { return fTimeShiftTask != NULL; }
+        
+        // Remembers where the client was so a PLAY without a Range resumes from there
+        void            Pause(SInt64 inCurrentTime);
+        SInt64          GetPausePosition()          { return fPausePosition; }
+        
     private:
     
         QTSS_ClientSessionObject fClientSession;
         ReflectorSession*       fReflectorSession;
         QTSS_AttributeID        fCookieAttrID;
         UInt32                  fBufferDelayMSecs;
+        SInt64                  fFastStartBeginTime;
         SInt64                  fBaseArrivalTime;
         Bool16                  fIsUDP;
         Bool16                  fTransportInitialized;
         Bool16                  fMustSynch;
         Bool16                  fPreFilter;
+        ReflectorTimeShiftTask* fTimeShiftTask;
+        SInt64                  fPausePosition;
         
         UInt16 GetPacketSeqNumber(StrPtrLen* inPacket);
         void SetPacketSeqNumber(StrPtrLen* inPacket, UInt16 inSeqNumber);
@@ -81,6 +98,7 @@ class RTPSessionOutput : public ReflectorOutput
         Bool16  FilterPacket(QTSS_RTPStreamObject *theStreamPtr, StrPtrLen* inPacket);
         
         UInt32 GetPacketRTPTime(StrPtrLen* packetStrPtr);
+        SInt64 GetBufferDelay(SInt64 inCurrentTime);
 inline  Bool16 PacketMatchesStream(void* inStreamCookie, QTSS_RTPStreamObject *theStreamPtr);
         Bool16 PacketReadyToSend(QTSS_RTPStreamObject *theStreamPtr,SInt64 *currentTimePtr, UInt32 inFlags, UInt64* packetIDPtr, SInt64* timeToSendThisPacketAgainPtr);
         Bool16 PacketAlreadySent(QTSS_RTPStreamObject *theStreamPtr, UInt32 inFlags, UInt64* packetIDPtr);
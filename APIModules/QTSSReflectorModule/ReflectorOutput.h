@@ -43,6 +43,7 @@
 #include "MyAssert.h"
 #include "OS.h"
 #include "OSQueue.h"
+#include "OSSharedBuffer.h"
 
 
 class ReflectorOutput
@@ -69,6 +70,14 @@ class ReflectorOutput
 inline  OSQueueElem*    GetBookMarkedPacket(OSQueue *thePacketQueue);
 inline  Bool16          SetBookMarkPacket(OSQueueElem* thePacketElemPtr);
         
+        // Set in inFlags by the time-shift task for packets played back from a
+        // time-shift buffer, so an output that is time-shifting can tell them
+        // apart from live packets. Never passed on to QTSS_Write.
+        enum
+        {
+            kTimeShiftedPacket = 0x80000000
+        };
+        
         // WritePacket
         //
         // Pass in the packet contents, the cookie of the stream to which it will be written,
@@ -76,7 +85,10 @@ inline  Bool16          SetBookMarkPacket(OSQueueElem* thePacketElemPtr);
         // packetLateness is how many MSec's late this packet is in being delivered ( will be < 0 if its early )
         // If this function returns QTSS_WouldBlock, timeToSendThisPacketAgain will
         // be set to # of msec in which the packet can be sent, or -1 if unknown
-        virtual QTSS_Error  WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec, SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTimeMSec ) = 0;
+        // If inSharedBuffer is set, inPacket is in it, and the output may retain it
+        // to keep the packet around after this call. The RTP header may change after
+        // this call returns (it is rewritten for each output); the payload won't.
+        virtual QTSS_Error  WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec, SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTimeMSec, OSSharedBuffer* inSharedBuffer = NULL) = 0;
     
         virtual void        TearDown() = 0;
         virtual Bool16      IsUDP() = 0;
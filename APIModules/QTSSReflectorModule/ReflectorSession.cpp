@@ -241,6 +241,8 @@ QTSS_Error ReflectorSession::SetupReflectorSession(SourceInfo* inInfo, QTSS_Stan
         else    
             fStreamArray[x] = (ReflectorStream*)theStreamRef->GetObject();   
 
+        if (inFlags & kTimeShift)
+            fStreamArray[x]->EnableTimeShift();
     }
     
     
@@ -97,7 +97,8 @@ class ReflectorSession
         {
             kMarkSetup = 0,     //After SetupReflectorSession is called, IsSetup returns true
             kDontMarkSetup = 1, //After SetupReflectorSession is called, IsSetup returns false
-            kIsPushSession = 2  // When setting up streams handle port conflicts by allocating.
+            kIsPushSession = 2, // When setting up streams handle port conflicts by allocating.
+            kTimeShift = 4      // Record the streams so clients can play from a point in the past.
         };
         
         QTSS_Error      SetupReflectorSession(SourceInfo* inInfo, QTSS_StandardRTSP_Params* inParams,
@@ -53,6 +53,19 @@ static ReflectorSocketPool  sSocketPool;
 
 static QTSS_AttributeID         sCantBindReflectorSocketErr = qtssIllegalAttrID;
 static QTSS_AttributeID         sCantJoinMulticastGroupErr  = qtssIllegalAttrID;
+static QTSS_AttributeID         sIngestLatencyAttr          = qtssIllegalAttrID;
+
+// INGEST STATS
+
+// How late ReflectorSocket::Run gets to run after the time it asked for, in
+// buckets of < 1, < 2, < 5, < 10, < 20, < 50, < 100, and >= 100 milliseconds.
+// A busy task thread shows up here as packets sitting in the reflector longer.
+static const SInt64             sIngestLatencyBucketLimits[] = { 1, 2, 5, 10, 20, 50, 100 };
+enum { kNumIngestLatencyBuckets = (sizeof(sIngestLatencyBucketLimits) / sizeof(SInt64)) + 1 };
+static unsigned int             sIngestLatencyCounts[kNumIngestLatencyBuckets];
+static SInt64                   sNextIngestStatsTime = 0;
+static const SInt64             kIngestStatsIntervalMSec = 10000;
+static QTSS_ServerObject        sServer = NULL;
 
 // PREFS
 
@@ -61,6 +74,12 @@ static UInt32                   sDefaultBucketDelayInMsec           = 73;
 static Bool16                   sDefaultUsePacketReceiveTime        = false; 
 static UInt32                   sDefaultMaxFuturePacketTimeSec      = 60;
 static UInt32                   sDefaultFirstPacketOffsetMsec       = 500;
+static Bool16                   sDefaultKeyFrameJoin                = true;
+static Float32                  sDefaultFastStartRate               = 0.0;
+static UInt32                   sDefaultTimeShiftMinutes            = 0;
+static UInt32                   sDefaultTimeShiftMaxMBytes          = 64;
+static char*                    sDefaultTimeShiftFolder             = "/tmp/";
+static UInt32                   sDefaultIngestThreads               = 0;
 
 UInt32                          ReflectorStream::sBucketSize  = 16;
 UInt32                          ReflectorStream::sOverBufferInMsec = 10000; // more or less what the client over buffer will be
@@ -72,6 +91,11 @@ UInt32                          ReflectorStream::sOverBufferInSec = 10;
 UInt32                          ReflectorStream::sBucketDelayInMsec = 73;
 Bool16                          ReflectorStream::sUsePacketReceiveTime = false;
 UInt32                          ReflectorStream::sFirstPacketOffsetMsec = 500;
+Bool16                          ReflectorStream::sKeyFrameJoin = true;
+Float32                         ReflectorStream::sFastStartRate = 0.0; // multiple of real time used to send the buffer to a new client. 0 is off
+UInt32                          ReflectorStream::sTimeShiftMinutes = 0; // how far back clients can play from. 0 is off
+UInt32                          ReflectorStream::sTimeShiftMaxMBytes = 64; // per stream
+char*                           ReflectorStream::sTimeShiftFolder = NULL;
 
 void ReflectorStream::Register()
 {
@@ -84,10 +108,18 @@ void ReflectorStream::Register()
 
     (void)QTSS_AddStaticAttribute(qtssTextMessagesObjectType, sCantJoinMulticastGroup, NULL, qtssAttrDataTypeCharArray);
     (void)QTSS_IDForAttr(qtssTextMessagesObjectType, sCantJoinMulticastGroup, &sCantJoinMulticastGroupErr);
+    
+    // Add the ingest latency histogram to the server object
+    static char*        sIngestLatency          = "QTSSReflectorModuleIngestLatencyHistogram";
+
+    (void)QTSS_AddStaticAttribute(qtssServerObjectType, sIngestLatency, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssServerObjectType, sIngestLatency, &sIngestLatencyAttr);
 }
 
-void ReflectorStream::Initialize(QTSS_ModulePrefsObject inPrefs)
+void ReflectorStream::Initialize(QTSS_ModulePrefsObject inPrefs, QTSS_ServerObject inServer)
 {
+    sServer = inServer;
+    
 
     QTSSModuleUtils::GetAttribute(inPrefs, "reflector_bucket_offset_delay_msec", qtssAttrDataTypeUInt32,
                               &ReflectorStream::sBucketDelayInMsec, &sDefaultBucketDelayInMsec, sizeof(sBucketDelayInMsec));
@@ -104,9 +136,37 @@ void ReflectorStream::Initialize(QTSS_ModulePrefsObject inPrefs)
     QTSSModuleUtils::GetAttribute(inPrefs, "reflector_rtp_info_offset_msec", qtssAttrDataTypeUInt32,
                               &ReflectorStream::sFirstPacketOffsetMsec, &sDefaultFirstPacketOffsetMsec, sizeof(sDefaultFirstPacketOffsetMsec));
 
+    QTSSModuleUtils::GetAttribute(inPrefs, "reflector_join_on_key_frame", qtssAttrDataTypeBool16,
+                              &ReflectorStream::sKeyFrameJoin, &sDefaultKeyFrameJoin, sizeof(sDefaultKeyFrameJoin));
+
+    QTSSModuleUtils::GetAttribute(inPrefs, "reflector_fast_start_rate", qtssAttrDataTypeFloat32,
+                              &ReflectorStream::sFastStartRate, &sDefaultFastStartRate, sizeof(sDefaultFastStartRate));
+
+    QTSSModuleUtils::GetAttribute(inPrefs, "reflector_timeshift_minutes", qtssAttrDataTypeUInt32,
+                              &ReflectorStream::sTimeShiftMinutes, &sDefaultTimeShiftMinutes, sizeof(sDefaultTimeShiftMinutes));
+
+    QTSSModuleUtils::GetAttribute(inPrefs, "reflector_timeshift_max_mbytes", qtssAttrDataTypeUInt32,
+                              &ReflectorStream::sTimeShiftMaxMBytes, &sDefaultTimeShiftMaxMBytes, sizeof(sDefaultTimeShiftMaxMBytes));
+
+    delete [] ReflectorStream::sTimeShiftFolder;
+    ReflectorStream::sTimeShiftFolder = QTSSModuleUtils::GetStringAttribute(inPrefs, "reflector_timeshift_folder", sDefaultTimeShiftFolder);
+
+    // Incoming streams can be given threads of their own so reading and reflecting
+    // broadcasts doesn't wait behind RTSP and client work. The threads are created
+    // once; changing this pref takes effect the next time the server starts.
+    UInt32 theNumIngestThreads = 0;
+    QTSSModuleUtils::GetAttribute(inPrefs, "reflector_ingest_threads", qtssAttrDataTypeUInt32,
+                              &theNumIngestThreads, &sDefaultIngestThreads, sizeof(sDefaultIngestThreads));
+    if ((theNumIngestThreads > 0) && (TaskThreadPool::GetNumDedicatedThreads() == 0))
+        (void)TaskThreadPool::AddDedicatedThreads(theNumIngestThreads);
+
     ReflectorStream::sOverBufferInMsec = sOverBufferInSec * 1000;
     ReflectorStream::sMaxFuturePacketMSec = sMaxFuturePacketSec * 1000;
     ReflectorStream::sMaxPacketAgeMSec = sOverBufferInMsec;
+    
+    // A rate at or below real time can't catch up, so it just means fast start is off
+    if (ReflectorStream::sFastStartRate <= 1.0)
+        ReflectorStream::sFastStartRate = 0.0;
 }
 
 void ReflectorStream::GenerateSourceID(SourceInfo::StreamInfo* inInfo, char* ioBuffer)
@@ -141,7 +201,15 @@ ReflectorStream::ReflectorStream(SourceInfo::StreamInfo* inInfo)
     fEnableBuffer(false),
     fEyeCount(0),
     fFirst_RTCP_RTP_Time(0),
-    fFirst_RTCP_Arrival_Time(0)
+    fFirst_RTCP_Arrival_Time(0),
+    fSyncPointType(kNoSyncPoints),
+    fLastPacketHadMarker(true),
+    fRTPPacketsReceived(0),
+    fRTPPacketsLost(0),
+    fHighestSeqNum(0),
+    fLastTransitInMSec(0),
+    fJitterInMSec(0),
+    fTimeShiftBuffer(NULL)
 {
 
     fRTPSender.fStream = this;
@@ -149,6 +217,18 @@ ReflectorStream::ReflectorStream(SourceInfo::StreamInfo* inInfo)
 
     fStreamInfo.Copy(*inInfo);
     
+    // Figure out how to find the key frames in this stream. Only video needs this;
+    // any audio packet is a fine place for a new client to start.
+    if (fStreamInfo.fPayloadType == qtssVideoPayloadType)
+    {
+        if (fStreamInfo.fPayloadName.NumEqualIgnoreCase("H264/", 5))
+            fSyncPointType = kH264SyncPoints;
+        else if (fStreamInfo.fPayloadName.NumEqualIgnoreCase("MP4V-ES/", 8))
+            fSyncPointType = kMPEG4VideoSyncPoints;
+        else
+            fSyncPointType = kFrameStartSyncPoints;
+    }
+    
     // ALLOCATE BUCKET ARRAY
     this->AllocateBucketArray(fNumBuckets);
 
@@ -230,6 +310,30 @@ ReflectorStream::~ReflectorStream()
     for (UInt32 y = 0; y < fNumBuckets; y++)
         delete [] fOutputArray[y];
     delete [] fOutputArray;
+    
+    delete fTimeShiftBuffer;
+}
+
+void ReflectorStream::EnableTimeShift()
+{
+    OSMutexLocker locker(&fBucketMutex);
+    if ((fTimeShiftBuffer != NULL) || (sTimeShiftMinutes == 0) || (sTimeShiftFolder == NULL))
+        return;
+        
+    // The buffer holds whichever is less: sTimeShiftMinutes of the stream, or sTimeShiftMaxMBytes
+    UInt32 theNumSegments = (sTimeShiftMaxMBytes * 1024 * 1024) / ReflectorTimeShiftBuffer::kSegmentSize;
+    if (theNumSegments < 2)
+        theNumSegments = 2;
+        
+    ReflectorTimeShiftBuffer* theBuffer = NEW ReflectorTimeShiftBuffer();
+    if (theBuffer->Open(sTimeShiftFolder, theNumSegments, GetTimeShiftMSec()) != OS_NoErr)
+    {
+        delete theBuffer;
+        return;
+    }
+    
+    // Only set once the buffer is ready, ProcessPacket may be looking at it
+    fTimeShiftBuffer = theBuffer;
 }
 
 void ReflectorStream::AllocateBucketArray(UInt32 inNumBuckets)
@@ -411,6 +515,12 @@ QTSS_Error ReflectorStream::BindSockets(QTSS_StandardRTSP_Params* inParams, UInt
     
     ((ReflectorSocket*)fSockets->GetSocketA())->SetSSRCFilter(filterState, timeout);
     ((ReflectorSocket*)fSockets->GetSocketB())->SetSSRCFilter(filterState, timeout);
+    
+    // If there are ingest threads, always read this port on the same one. The RTP and
+    // RTCP sockets go together, and consecutive port pairs land on different threads.
+    TaskThread* theIngestThread = TaskThreadPool::GetDedicatedThread(fSockets->GetSocketA()->GetLocalPort() / 2);
+    ((ReflectorSocket*)fSockets->GetSocketA())->SetDefaultThread(theIngestThread);
+    ((ReflectorSocket*)fSockets->GetSocketB())->SetDefaultThread(theIngestThread);
 
 #if 1 
 	// Always set the Rcv buf size for the sockets. This is important because the
@@ -470,6 +580,122 @@ void ReflectorStream::SendReceiverReport()
     (void)fSockets->GetSocketB()->SendTo(fDestRTCPAddr, fDestRTCPPort, fReceiverReportBuffer, fReceiverReportSize);
 }
 
+void ReflectorStream::UpdateReceiveStats(StrPtrLen* inPacket, SInt64 inArrivalTime)
+{
+    // Called from ReflectorSocket::ProcessPacket with the socket's demuxer mutex held
+    if (inPacket->Len < 12)
+        return;
+        
+    UInt16 theSeqNum = ntohs(((UInt16*)inPacket->Ptr)[1]);
+    UInt32 theRTPTime = ntohl(((UInt32*)inPacket->Ptr)[1]);
+
+    if (fRTPPacketsReceived > 0)
+    {
+        SInt16 theSeqDelta = (SInt16)(theSeqNum - fHighestSeqNum);
+        if (theSeqDelta > 0)
+        {
+            fRTPPacketsLost += theSeqDelta - 1;
+            fHighestSeqNum = theSeqNum;
+        }
+        else if ((theSeqDelta < 0) && (fRTPPacketsLost > 0))
+            fRTPPacketsLost--; // a late packet we had already counted as lost
+    }
+    else
+        fHighestSeqNum = theSeqNum;
+    
+    fRTPPacketsReceived++;
+
+    // Interarrival jitter as described in RFC 3550, kept in milliseconds
+    if (fStreamInfo.fTimeScale == 0)
+        return;
+        
+    Float64 theTransit = (Float64)inArrivalTime - (((Float64)theRTPTime * 1000) / (Float64)fStreamInfo.fTimeScale);
+    if (fRTPPacketsReceived > 1)
+    {
+        Float64 theDelta = theTransit - fLastTransitInMSec;
+        if (theDelta < 0)
+            theDelta = -theDelta;
+        fJitterInMSec += (theDelta - fJitterInMSec) / 16;
+    }
+    fLastTransitInMSec = theTransit;
+}
+
+Bool16 ReflectorStream::IsKeyFramePacket(StrPtrLen* inPacket)
+{
+    // Must be called for every RTP packet in arrival order, because frame starts
+    // are found by looking at the marker bit of the previous packet.
+    if ((inPacket->Ptr == NULL) || (inPacket->Len < 12))
+        return false;
+        
+    UInt8* thePacket = (UInt8*)inPacket->Ptr;
+    Bool16 isFrameStart = fLastPacketHadMarker;
+    fLastPacketHadMarker = (thePacket[1] & 0x80) != 0;
+    
+    if (fSyncPointType == kFrameStartSyncPoints)
+        return isFrameStart;
+    
+    //skip over the RTP header, the CSRC list, and any header extension
+    UInt32 theHeaderLen = 12 + ((thePacket[0] & 0x0f) * 4);
+    if ((thePacket[0] & 0x10) && (inPacket->Len >= theHeaderLen + 4))
+        theHeaderLen += 4 + (ntohs(*(UInt16*)&thePacket[theHeaderLen + 2]) * 4);
+    if (inPacket->Len <= theHeaderLen)
+        return false;
+        
+    UInt8* thePayload = &thePacket[theHeaderLen];
+    UInt32 thePayloadLen = inPacket->Len - theHeaderLen;
+    
+    if (fSyncPointType == kH264SyncPoints)
+    {
+        // RFC 3984. An SPS (7) comes in front of the IDR (5) it belongs to,
+        // so it is the better place to start.
+        UInt8 theNALType = thePayload[0] & 0x1f;
+        if ((theNALType == 5) || (theNALType == 7))
+            return true;
+            
+        if ((theNALType == 28) && (thePayloadLen > 1)) // FU-A, only the first fragment
+        {
+            UInt8 theFragmentType = thePayload[1] & 0x1f;
+            return (thePayload[1] & 0x80) && ((theFragmentType == 5) || (theFragmentType == 7));
+        }
+        
+        if (theNALType == 24) // STAP-A, look at each aggregated NAL unit
+        {
+            for (UInt32 theOffset = 1; theOffset + 2 < thePayloadLen; )
+            {
+                UInt32 theNALSize = (thePayload[theOffset] << 8) | thePayload[theOffset + 1];
+                theNALType = thePayload[theOffset + 2] & 0x1f;
+                if ((theNALType == 5) || (theNALType == 7))
+                    return true;
+                theOffset += 2 + theNALSize;
+            }
+        }
+        return false;
+    }
+    
+    if (fSyncPointType == kMPEG4VideoSyncPoints)
+    {
+        // RFC 3016. A packet that starts a frame holds the headers in front of the VOP,
+        // so stop looking at the first VOP start code.
+        if (!isFrameStart)
+            return false;
+            
+        for (UInt32 theOffset = 0; theOffset + 3 < thePayloadLen; theOffset++)
+        {
+            if ((thePayload[theOffset] != 0) || (thePayload[theOffset + 1] != 0) || (thePayload[theOffset + 2] != 1))
+                continue;
+                
+            UInt8 theStartCode = thePayload[theOffset + 3];
+            if ((theStartCode == 0xb0) || (theStartCode == 0xb3)) // VOS or GOV header
+                return true;
+            if (theStartCode == 0xb6) // VOP, vop_coding_type 0 is an I-VOP
+                return (theOffset + 4 < thePayloadLen) && ((thePayload[theOffset + 4] >> 6) == 0);
+        }
+        return false;
+    }
+    
+    return false;
+}
+
 void ReflectorStream::PushPacket(char *packet, UInt32 packetLen, Bool16 isRTCP)
 {
 
@@ -627,7 +853,7 @@ OSQueueElem*    ReflectorSender::GetClientBufferNextPacketTime(UInt32 inRTPTime)
 Bool16 ReflectorSender::GetFirstRTPTimePacket(UInt16* outSeqNumPtr, UInt32* outRTPTimePtr, SInt64* outArrivalTimePtr) 
 {
     OSMutexLocker locker(&fStream->fBucketMutex);
-    OSQueueElem* packetElem = this->GetClientBufferStartPacketOffset(ReflectorStream::sFirstPacketOffsetMsec);
+    OSQueueElem* packetElem = this->GetNewOutputStartPacket();
             
     if (packetElem == NULL)
         return false;
@@ -659,7 +885,7 @@ Bool16 ReflectorSender::GetFirstRTPTimePacket(UInt16* outSeqNumPtr, UInt32* outR
 Bool16 ReflectorSender::GetFirstPacketInfo(UInt16* outSeqNumPtr, UInt32* outRTPTimePtr, SInt64* outArrivalTimePtr) 
 {
     OSMutexLocker locker(&fStream->fBucketMutex);
-    OSQueueElem* packetElem = this->GetClientBufferStartPacketOffset(ReflectorStream::sFirstPacketOffsetMsec);
+    OSQueueElem* packetElem = this->GetNewOutputStartPacket();
 //    OSQueueElem* packetElem = this->GetClientBufferStartPacket();
             
     if (packetElem == NULL)
@@ -844,7 +1070,7 @@ void ReflectorSender::ReflectRelayPackets(SInt64* ioWakeupTime, OSQueue* inFreeQ
 						#endif
 						
 						SInt64 timeToSendPacket = -1;
-						err = theOutput->WritePacket(&thePacket->fPacketPtr, fStream, fWriteFlag, packetLateness, &timeToSendPacket, NULL, NULL);
+						err = theOutput->WritePacket(&thePacket->fPacketPtr, fStream, fWriteFlag, packetLateness, &timeToSendPacket, NULL, NULL, thePacket->fBuffer);
 					
 						if ( err == QTSS_WouldBlock )
 						{	
@@ -980,7 +1206,7 @@ void ReflectorSender::ReflectPackets(SInt64* ioWakeupTime, OSQueue* inFreeQueue)
     fStream->UpdateBitRate(currentTime);
 
     // where to start new clients in the q
-    fFirstPacketInQueueForNewOutput = this->GetClientBufferStartPacketOffset(ReflectorStream::sFirstPacketOffsetMsec); 
+    fFirstPacketInQueueForNewOutput = this->GetNewOutputStartPacket(); 
   
 /*
 ReflectorPacket* thePacket = NULL;
@@ -1050,7 +1276,7 @@ OSQueueElem*    ReflectorSender::SendPacketsToOutput(ReflectorOutput* theOutput,
               
         //printf("packetLateness %qd, seq# %li\n", packetLateness, (long) DGetPacketSeqNumber( &thePacket->fPacketPtr ) );          
                                          
-        err = theOutput->WritePacket(&thePacket->fPacketPtr, fStream, fWriteFlag, packetLateness, &timeToSendPacket,&thePacket->fStreamCountID,&thePacket->fTimeArrived );                
+        err = theOutput->WritePacket(&thePacket->fPacketPtr, fStream, fWriteFlag, packetLateness, &timeToSendPacket,&thePacket->fStreamCountID,&thePacket->fTimeArrived, thePacket->fBuffer );                
         if (err == QTSS_WouldBlock)
         { // call us again in # ms to retry on an EAGAIN
             if ((timeToSendPacket > 0) && (fNextTimeToRun > timeToSendPacket ))
@@ -1101,6 +1327,47 @@ OSQueueElem*    ReflectorSender::GetClientBufferStartPacketOffset(SInt64 offsetM
     return oldestPacketInClientBufferTime;
 }
 
+OSQueueElem*    ReflectorSender::GetNewOutputStartPacket()
+{
+    OSQueueElem* theStartPacket = this->GetClientBufferStartPacketOffset(ReflectorStream::sFirstPacketOffsetMsec);
+    if (!ReflectorStream::sKeyFrameJoin || (fWriteFlag != qtssWriteFlagsIsRTP) || (fStream->GetSyncPointType() == ReflectorStream::kNoSyncPoints))
+        return theStartPacket;
+        
+    return this->GetKeyFramePacket(theStartPacket);
+}
+
+OSQueueElem*    ReflectorSender::GetKeyFramePacket(OSQueueElem* inStartPacket)
+{
+    // Prefer the most recent key frame at or before the start packet, so the client
+    // still gets a full buffer. If the buffer doesn't reach back to one, use the first
+    // key frame after it. With no key frame at all, fall back to the start packet.
+    if (inStartPacket == NULL)
+        return NULL;
+    
+    OSQueueElem* theKeyFrame = NULL;
+    Bool16 pastStartPacket = false;
+    for (OSQueueIter qIter(&fPacketQueue); !qIter.IsDone(); qIter.Next())
+    {
+        OSQueueElem* elem = qIter.GetCurrent();
+        ReflectorPacket* thePacket = (ReflectorPacket*)elem->GetEnclosingObject();
+        Assert( thePacket );
+        
+        if (elem == inStartPacket)
+            pastStartPacket = true;
+            
+        if (thePacket->IsKeyFrame())
+            theKeyFrame = elem;
+        
+        if (pastStartPacket && (theKeyFrame != NULL))
+            break;
+    }
+    
+    if (theKeyFrame == NULL)
+        return inStartPacket;
+        
+    return theKeyFrame;
+}
+
 void    ReflectorSender::RemoveOldPackets(OSQueue* inFreeQueue)
 {
         
@@ -1174,6 +1441,7 @@ ReflectorSocket::ReflectorSocket()
     fBroadcasterClientSession(NULL), 
     fLastBroadcasterTimeOutRefresh(0), 
     fSleepTime(0),
+    fWakeupTime(0),
     fValidSSRC(0),
     fLastValidSSRCTime(0),
     fFilterSSRCs(true),
@@ -1223,6 +1491,26 @@ void    ReflectorSocket::RemoveSender(ReflectorSender* inSender)
     Assert(err == QTSS_NoErr);
 }
 
+static void RecordIngestLatency(SInt64 inLatenessMSec, SInt64 inCurrentTime)
+{
+    UInt32 theBucket = 0;
+    while ((theBucket < kNumIngestLatencyBuckets - 1) && (inLatenessMSec >= sIngestLatencyBucketLimits[theBucket]))
+        theBucket++;
+    (void)atomic_add(&sIngestLatencyCounts[theBucket], 1);
+    
+    // Every so often, copy the counts to the server's attribute. If two sockets
+    // do this at once the second copy is just redundant.
+    if ((sServer == NULL) || (inCurrentTime < sNextIngestStatsTime))
+        return;
+    sNextIngestStatsTime = inCurrentTime + kIngestStatsIntervalMSec;
+    
+    for (UInt32 x = 0; x < kNumIngestLatencyBuckets; x++)
+    {
+        UInt32 theCount = sIngestLatencyCounts[x];
+        (void)QTSS_SetValue(sServer, sIngestLatencyAttr, x, &theCount, sizeof(theCount));
+    }
+}
+
 SInt64 ReflectorSocket::Run()
 {
     //We want to make sure we can't get idle events WHILE we are inside
@@ -1238,6 +1526,10 @@ SInt64 ReflectorSocket::Run()
     OSMutexLocker locker(this->GetDemuxer()->GetMutex());
     SInt64 theMilliseconds = OS::Milliseconds();
     
+    if ((theEvents & Task::kIdleEvent) && (fWakeupTime > 0))
+        RecordIngestLatency(theMilliseconds - fWakeupTime, theMilliseconds);
+    fWakeupTime = 0;
+    
     //Only check for data on the socket if we've actually been notified to that effect
     if (theEvents & Task::kReadEvent)
         this->GetIncomingData(theMilliseconds);
@@ -1269,7 +1561,10 @@ SInt64 ReflectorSocket::Run()
     
     //For smoothing purposes, the streams can mark when they want to wakeup.
     if (fSleepTime > 0)
+    {
         this->SetIdleTimer(fSleepTime);
+        fWakeupTime = theMilliseconds + fSleepTime;
+    }
 #if DEBUG
     //The debugging check above expects real time.
     fSleepTime += theMilliseconds;
@@ -1412,6 +1707,11 @@ Bool16 ReflectorSocket::ProcessPacket(const SInt64& inMilliseconds,ReflectorPack
             
             if (!(thePacket->IsRTCP()))
             {
+                if (theSender->fStream->GetSyncPointType() != ReflectorStream::kNoSyncPoints)
+                    thePacket->fIsKeyFrame = theSender->fStream->IsKeyFramePacket(&thePacket->fPacketPtr);
+                    
+                theSender->fStream->UpdateReceiveStats(&thePacket->fPacketPtr, inMilliseconds);
+                    
                 // don't check for duplicate packets, they may be needed to keep in sync.
                 // Because this is an RTP packet make sure to atomic add this because
                 // multiple sockets can be adding to this variable simultaneously
@@ -1463,6 +1763,14 @@ Bool16 ReflectorSocket::ProcessPacket(const SInt64& inMilliseconds,ReflectorPack
                 }
             
             }
+            
+            ReflectorTimeShiftBuffer* theTimeShiftBuffer = theSender->fStream->GetTimeShiftBuffer();
+            if (theTimeShiftBuffer != NULL)
+            {
+                // Sync points go into the buffer's index, so a seek lands where a client can start decoding
+                Bool16 isSyncPoint = !thePacket->IsRTCP() && (thePacket->fIsKeyFrame || (theSender->fStream->GetSyncPointType() == ReflectorStream::kNoSyncPoints));
+                theTimeShiftBuffer->AddPacket(&thePacket->fPacketPtr, thePacket->fTimeArrived, thePacket->fStreamCountID, thePacket->IsRTCP(), isSyncPoint);
+            }
              
             //printf("ReflectorSocket::GetIncomingData has packet from time=%qd src addr=%lu src port=%u packetlen=%lu\n",inMilliseconds, theRemoteAddr,theRemotePort,thePacket->fPacketPtr.Len);
             if (0) //turn on / off buffer size checking --  pref can go here if we find we need to adjust this
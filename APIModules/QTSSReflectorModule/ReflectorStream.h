@@ -51,9 +51,11 @@
 #include "OSMutex.h"
 #include "OSQueue.h"
 #include "OSRef.h"
+#include "OSSharedBuffer.h"
 
 #include "RTCPSRPacket.h"
 #include "ReflectorOutput.h"
+#include "ReflectorTimeShift.h"
 #include "atomic.h"
 
 //This will add some printfs that are useful for checking the thinning
@@ -69,18 +71,24 @@ class ReflectorPacket
 {
     public:
     
-        ReflectorPacket() : fQueueElem() { fQueueElem.SetEnclosingObject(this); this->Reset();}
+        ReflectorPacket() : fQueueElem(), fBuffer(NEW OSSharedBuffer(kMaxReflectorPacketSize)) { fQueueElem.SetEnclosingObject(this); this->Reset();}
         void Reset()    { // make packet ready to reuse fQueueElem is always in use
                             fBucketsSeenThisPacket = 0; 
                             fTimeArrived = 0; 
                             //fQueueElem -- should be set to this
-                            fPacketPtr.Set(fPacketData, 0); 
+                            if (fBuffer->IsShared())
+                            {   // a reliable UDP resender still has the old contents, leave them to it
+                                fBuffer->Release();
+                                fBuffer = NEW OSSharedBuffer(kMaxReflectorPacketSize);
+                            }
+                            fPacketPtr.Set(fBuffer->GetData(), 0); 
                             fIsRTCP = false;
                             fStreamCountID = 0;
                             fNeededByOutput = false; 
+                            fIsKeyFrame = false;
                         }
 
-        ~ReflectorPacket() {}
+        ~ReflectorPacket() { fBuffer->Release(); }
         
         void    SetPacketData(char *data, UInt32 len) { Assert(kMaxReflectorPacketSize > len); if (len > 0) memcpy(this->fPacketPtr.Ptr,data,len); this->fPacketPtr.Len = len;}
         Bool16  IsRTCP() { return fIsRTCP; }
@@ -88,6 +96,7 @@ inline  UInt32  GetPacketRTPTime();
 inline  UInt16  GetPacketRTPSeqNum();
 inline  UInt32  GetSSRC(Bool16 isRTCP);
 inline  SInt64  GetPacketNTPTime();
+        Bool16  IsKeyFrame() { return fIsKeyFrame; }
  
  private: 
 
@@ -99,10 +108,11 @@ inline  SInt64  GetPacketNTPTime();
         UInt32      fBucketsSeenThisPacket;
         SInt64      fTimeArrived;
         OSQueueElem fQueueElem;
-        char        fPacketData[kMaxReflectorPacketSize];
+        OSSharedBuffer* fBuffer;    // outputs may hold on to this after the packet is reused
         StrPtrLen   fPacketPtr;
         Bool16      fIsRTCP;
         Bool16      fNeededByOutput; // is this packet still needed for output?
+        Bool16      fIsKeyFrame; // a new output can start decoding at this packet
         UInt64      fStreamCountID;
                 
         friend class ReflectorSender;
@@ -212,6 +222,7 @@ class ReflectorSocket : public IdleTask, public UDPSocket
        // Queue of senders
         OSQueue fSenderQueue;
         SInt64  fSleepTime;
+        SInt64  fWakeupTime;    // when the idle timer set at the end of the last Run should fire
                 
         UInt32  fValidSSRC;
         SInt64  fLastValidSSRCTime;
@@ -274,6 +285,11 @@ class ReflectorSender : public UDPDemuxerTask
     void        RemoveOldPackets(OSQueue* inFreeQueue);
     OSQueueElem* GetClientBufferStartPacketOffset(SInt64 offsetMsec); 
     OSQueueElem* GetClientBufferStartPacket() { return this->GetClientBufferStartPacketOffset(0); };
+    
+    // Where new outputs join the stream. This is the client buffer start point moved
+    // back (or if necessary forward) to the nearest packet a decoder can start on.
+    OSQueueElem* GetNewOutputStartPacket();
+    OSQueueElem* GetKeyFramePacket(OSQueueElem* inStartPacket);
 
     ReflectorStream*    fStream;
     UInt32              fWriteFlag;
@@ -328,7 +344,7 @@ class ReflectorStream
         // Call Register from the Register role, as this object has some QTSS API
         // attributes to setup
         static void Register();
-        static void Initialize(QTSS_ModulePrefsObject inPrefs);
+        static void Initialize(QTSS_ModulePrefsObject inPrefs, QTSS_ServerObject inServer);
         
         //
         // MODIFIERS
@@ -392,11 +408,38 @@ class ReflectorStream
         Bool16                  BufferEnabled()                         { return fEnableBuffer; }
 inline  void                    UpdateBitRate(SInt64 currentTime);
         static UInt32           sOverBufferInMsec;
+        static Float32          sFastStartRate;
         
         void                    IncEyeCount()                           { OSMutexLocker locker(&fBucketMutex); fEyeCount ++; }
         void                    DecEyeCount()                           { OSMutexLocker locker(&fBucketMutex); fEyeCount --; }
         UInt32                  GetEyeCount()                           { OSMutexLocker locker(&fBucketMutex); return fEyeCount; }
 
+        // Sync point detection for new outputs. Decides from the payload name in the
+        // SDP how key frames are recognized, then marks each incoming RTP packet.
+        enum
+        {
+            kNoSyncPoints           = 0,    // every packet is a valid join point (audio, unknown)
+            kFrameStartSyncPoints   = 1,    // join on the packet following an RTP marker bit
+            kH264SyncPoints         = 2,    // join on an SPS or IDR NAL unit
+            kMPEG4VideoSyncPoints   = 3     // join on a VOS, GOV, or I-VOP start code
+        };
+        UInt32                  GetSyncPointType()                      { return fSyncPointType; }
+        
+        // Time-shift. EnableTimeShift starts recording incoming packets so outputs
+        // can play from a point in the past; it does nothing if reflector_timeshift_minutes
+        // is 0 or the buffer can't be created. GetTimeShiftBuffer returns NULL until then.
+        void                        EnableTimeShift();
+        ReflectorTimeShiftBuffer*   GetTimeShiftBuffer()                { return fTimeShiftBuffer; }
+        static UInt32               GetTimeShiftMSec()                  { return sTimeShiftMinutes * 60 * 1000; }
+        
+        // Receive statistics for the incoming RTP stream. When relaying, these
+        // describe the hop between the upstream server and this one.
+        void                    UpdateReceiveStats(StrPtrLen* inPacket, SInt64 inArrivalTime);
+        UInt32                  GetPacketsReceived()                    { return fRTPPacketsReceived; }
+        UInt32                  GetPacketsLost()                        { return fRTPPacketsLost; }
+        UInt32                  GetJitterInMSec()                       { return (UInt32)fJitterInMSec; }
+        Bool16                  IsKeyFramePacket(StrPtrLen* inPacket);
+
     private:
     
          //Sends an RTCP receiver report to the broadcast source
@@ -466,6 +509,17 @@ inline  void                    UpdateBitRate(SInt64 currentTime);
         
         UInt32              fFirst_RTCP_RTP_Time;
         SInt64              fFirst_RTCP_Arrival_Time;
+        
+        UInt32              fSyncPointType;
+        Bool16              fLastPacketHadMarker;
+        
+        UInt32              fRTPPacketsReceived;
+        UInt32              fRTPPacketsLost;
+        UInt16              fHighestSeqNum;
+        Float64             fLastTransitInMSec;
+        Float64             fJitterInMSec;
+        
+        ReflectorTimeShiftBuffer*   fTimeShiftBuffer;
     
         static UInt32       sBucketSize;
         static UInt32       sMaxPacketAgeMSec;
@@ -476,6 +530,10 @@ inline  void                    UpdateBitRate(SInt64 currentTime);
         static UInt32       sBucketDelayInMsec;
         static Bool16       sUsePacketReceiveTime;
         static UInt32       sFirstPacketOffsetMsec;
+        static Bool16       sKeyFrameJoin;
+        static UInt32       sTimeShiftMinutes;
+        static UInt32       sTimeShiftMaxMBytes;
+        static char*        sTimeShiftFolder;
         
         friend class ReflectorSocket;
         friend class ReflectorSender;
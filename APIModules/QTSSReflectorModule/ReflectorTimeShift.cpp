@@ -0,0 +1,454 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       ReflectorTimeShift.cpp
+
+    Contains:   Implementation of the objects defined in ReflectorTimeShift.h
+
+*/
+
+#include "ReflectorTimeShift.h"
+#include "ReflectorSession.h"
+#include "ReflectorOutput.h"
+#include "OSMemory.h"
+#include "OSThread.h"
+#include "OS.h"
+
+#ifndef __Win32__
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ReflectorTimeShiftBuffer::ReflectorTimeShiftBuffer()
+:   fFile(-1),
+    fSegments(NULL),
+    fNumSegments(0),
+    fWriteSegment(0),
+    fMaxAgeMSec(0)
+{
+}
+
+ReflectorTimeShiftBuffer::~ReflectorTimeShiftBuffer()
+{
+#ifndef __Win32__
+    for (UInt32 x = 0; x < fNumSegments; x++)
+    {
+        if (fSegments[x].fData != NULL)
+            (void)::munmap(fSegments[x].fData, kSegmentSize);
+    }
+    if (fFile != -1)
+        ::close(fFile);
+#endif
+    delete [] fSegments;
+}
+
+OS_Error ReflectorTimeShiftBuffer::Open(const char* inFolder, UInt32 inNumSegments, UInt32 inMaxAgeMSec)
+{
+    Assert(fSegments == NULL);
+    if (inNumSegments < 2)
+        return EINVAL;
+
+#ifdef __Win32__
+    // Time-shifting relies on mmap
+    return EINVAL;
+#else
+    char thePath[512];
+    qtss_snprintf(thePath, sizeof(thePath), "%s/timeshift.%lu.%lx", inFolder, (UInt32)::getpid(), (PointerSizedInt)this);
+
+    fFile = ::open(thePath, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fFile == -1)
+        return OSThread::GetErrno();
+
+    // Nobody else needs to see this file, and it should not outlive us
+    (void)::unlink(thePath);
+
+    if (::ftruncate(fFile, (off_t)inNumSegments * kSegmentSize) != 0)
+    {
+        OS_Error theErr = OSThread::GetErrno();
+        ::close(fFile);
+        fFile = -1;
+        return theErr;
+    }
+
+    fSegments = NEW Segment[inNumSegments];
+    ::memset(fSegments, 0, inNumSegments * sizeof(Segment));
+    fNumSegments = inNumSegments;
+    fWriteSegment = 0;
+    fMaxAgeMSec = inMaxAgeMSec;
+    return OS_NoErr;
+#endif
+}
+
+Bool16 ReflectorTimeShiftBuffer::MapSegment(UInt32 inSegment)
+{
+#ifdef __Win32__
+    return false;
+#else
+    // Segments are mapped the first time the writer gets to them and stay
+    // mapped. They are backed by the file, so the kernel is free to write
+    // them out and drop them from memory.
+    Segment* theSegment = &fSegments[inSegment];
+    if (theSegment->fData != NULL)
+        return true;
+
+    void* theData = ::mmap(NULL, kSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fFile, (off_t)inSegment * kSegmentSize);
+    if (theData == MAP_FAILED)
+        return false;
+
+    theSegment->fData = (char*)theData;
+    return true;
+#endif
+}
+
+Bool16 ReflectorTimeShiftBuffer::StartNextSegment()
+{
+    // Move the writer on to the next segment, throwing away the oldest data if
+    // the ring is full. Readers still in that segment notice the new generation.
+    UInt32 theNextSegment = (fWriteSegment + 1) % fNumSegments;
+    if (!this->MapSegment(theNextSegment))
+        return false;
+
+    Segment* theSegment = &fSegments[theNextSegment];
+    theSegment->fUsed = 0;
+    theSegment->fGeneration++;
+    theSegment->fFirstTime = 0;
+    theSegment->fLastTime = 0;
+    theSegment->fNumIndexEntries = 0;
+
+    fWriteSegment = theNextSegment;
+    return true;
+}
+
+void ReflectorTimeShiftBuffer::AddPacket(StrPtrLen* inPacket, SInt64 inArrivalTime, UInt64 inPacketID, Bool16 isRTCP, Bool16 isSyncPoint)
+{
+    if ((fSegments == NULL) || (inPacket->Len == 0) || (inPacket->Len > kMaxPacketSize))
+        return;
+
+    // Records are kept 8 byte aligned
+    UInt32 theRecordLen = (sizeof(RecordHeader) + inPacket->Len + 7) & ~7;
+
+    OSMutexLocker locker(&fMutex);
+
+    Segment* theSegment = &fSegments[fWriteSegment];
+    if (theSegment->fData == NULL)
+    {
+        if (!this->MapSegment(fWriteSegment))
+            return;
+    }
+    else if ((theSegment->fUsed + theRecordLen) > kSegmentSize)
+    {
+        if (!this->StartNextSegment())
+            return;
+        theSegment = &fSegments[fWriteSegment];
+    }
+
+    RecordHeader* theHeader = (RecordHeader*)&theSegment->fData[theSegment->fUsed];
+    theHeader->fArrivalTime = inArrivalTime;
+    theHeader->fPacketID = inPacketID;
+    theHeader->fLen = (UInt16)inPacket->Len;
+    theHeader->fFlags = isRTCP ? kRTCPRecord : 0;
+    theHeader->fReserved = 0;
+    ::memcpy(&theSegment->fData[theSegment->fUsed + sizeof(RecordHeader)], inPacket->Ptr, inPacket->Len);
+
+    if (theSegment->fUsed == 0)
+        theSegment->fFirstTime = inArrivalTime;
+
+    if (isSyncPoint && (theSegment->fNumIndexEntries < kMaxIndexEntries))
+    {
+        UInt32 theNumEntries = theSegment->fNumIndexEntries;
+        if ((theNumEntries == 0) || ((inArrivalTime - theSegment->fIndex[theNumEntries - 1].fTime) >= kIndexIntervalMSec))
+        {
+            theSegment->fIndex[theNumEntries].fTime = inArrivalTime;
+            theSegment->fIndex[theNumEntries].fOffset = theSegment->fUsed;
+            theSegment->fNumIndexEntries++;
+        }
+    }
+
+    theSegment->fUsed += theRecordLen;
+    theSegment->fLastTime = inArrivalTime;
+}
+
+Bool16 ReflectorTimeShiftBuffer::IsExpired(Segment* inSegment, SInt64 inCurrentTime)
+{
+    if (inSegment->fUsed == 0)
+        return true;
+    if ((fMaxAgeMSec > 0) && (inSegment->fLastTime < (inCurrentTime - (SInt64)fMaxAgeMSec)))
+        return true;
+    return false;
+}
+
+UInt32 ReflectorTimeShiftBuffer::GetOldestSegment()
+{
+    // The segment after the writer's is the oldest, unless it is empty or too old
+    SInt64 theCurrentTime = OS::Milliseconds();
+    for (UInt32 x = 1; x < fNumSegments; x++)
+    {
+        UInt32 theSegment = (fWriteSegment + x) % fNumSegments;
+        if (!this->IsExpired(&fSegments[theSegment], theCurrentTime))
+            return theSegment;
+    }
+    return fWriteSegment;
+}
+
+SInt64 ReflectorTimeShiftBuffer::GetOldestTime()
+{
+    if (fSegments == NULL)
+        return 0;
+
+    OSMutexLocker locker(&fMutex);
+    Segment* theSegment = &fSegments[this->GetOldestSegment()];
+    if (theSegment->fUsed == 0)
+        return 0;
+    return theSegment->fFirstTime;
+}
+
+Bool16 ReflectorTimeShiftBuffer::Seek(SInt64 inTime, Position* outPosition)
+{
+    if (fSegments == NULL)
+        return false;
+
+    OSMutexLocker locker(&fMutex);
+
+    UInt32 theSegmentIndex = this->GetOldestSegment();
+    Segment* theSegment = &fSegments[theSegmentIndex];
+    if (theSegment->fUsed == 0)
+        return false;
+
+    // If inTime is before everything we have, start with the oldest packet
+    outPosition->fSegment = theSegmentIndex;
+    outPosition->fGeneration = theSegment->fGeneration;
+    outPosition->fOffset = 0;
+    if (theSegment->fNumIndexEntries > 0)
+        outPosition->fOffset = theSegment->fIndex[0].fOffset;
+
+    // Otherwise use the last sync point at or before inTime
+    for (UInt32 x = 0; x < fNumSegments; x++)
+    {
+        theSegment = &fSegments[theSegmentIndex];
+        if ((theSegment->fUsed > 0) && (theSegment->fFirstTime > inTime))
+            break;
+
+        for (UInt32 y = 0; y < theSegment->fNumIndexEntries; y++)
+        {
+            if (theSegment->fIndex[y].fTime > inTime)
+                break;
+            outPosition->fSegment = theSegmentIndex;
+            outPosition->fGeneration = theSegment->fGeneration;
+            outPosition->fOffset = theSegment->fIndex[y].fOffset;
+        }
+
+        if (theSegmentIndex == fWriteSegment)
+            break;
+        theSegmentIndex = (theSegmentIndex + 1) % fNumSegments;
+    }
+    return true;
+}
+
+Bool16 ReflectorTimeShiftBuffer::GetNextPacket(Position* ioPosition, StrPtrLen* ioPacket, SInt64* outArrivalTime, UInt64* outPacketID, Bool16* outIsRTCP)
+{
+    if (fSegments == NULL)
+        return false;
+
+    OSMutexLocker locker(&fMutex);
+
+    for (UInt32 x = 0; x <= fNumSegments; x++)
+    {
+        Segment* theSegment = &fSegments[ioPosition->fSegment];
+        if (theSegment->fGeneration != ioPosition->fGeneration)
+        {
+            // The writer went all the way around the ring while this reader
+            // wasn't looking. Pick up again with the oldest data we have.
+            ioPosition->fSegment = this->GetOldestSegment();
+            theSegment = &fSegments[ioPosition->fSegment];
+            ioPosition->fGeneration = theSegment->fGeneration;
+            ioPosition->fOffset = 0;
+        }
+
+        if (ioPosition->fOffset >= theSegment->fUsed)
+        {
+            if (ioPosition->fSegment == fWriteSegment)
+                return false; // caught up
+
+            ioPosition->fSegment = (ioPosition->fSegment + 1) % fNumSegments;
+            ioPosition->fGeneration = fSegments[ioPosition->fSegment].fGeneration;
+            ioPosition->fOffset = 0;
+            continue;
+        }
+
+        RecordHeader* theHeader = (RecordHeader*)&theSegment->fData[ioPosition->fOffset];
+        ::memcpy(ioPacket->Ptr, &theSegment->fData[ioPosition->fOffset + sizeof(RecordHeader)], theHeader->fLen);
+        ioPacket->Len = theHeader->fLen;
+        *outArrivalTime = theHeader->fArrivalTime;
+        *outPacketID = theHeader->fPacketID;
+        *outIsRTCP = (theHeader->fFlags & kRTCPRecord) != 0;
+
+        ioPosition->fOffset += (sizeof(RecordHeader) + theHeader->fLen + 7) & ~7;
+        return true;
+    }
+    return false;
+}
+
+
+ReflectorTimeShiftTask::ReflectorTimeShiftTask(ReflectorSession* inSession, ReflectorOutput* inOutput)
+:   fSession(inSession),
+    fOutput(inOutput),
+    fStreams(NULL),
+    fNumStreams(inSession->GetNumStreams()),
+    fTimeShiftMSec(0)
+{
+    this->SetTaskName("ReflectorTimeShiftTask");
+
+    fStreams = NEW StreamState[fNumStreams];
+    for (UInt32 x = 0; x < fNumStreams; x++)
+    {
+        fStreams[x].fPacket.Set(fStreams[x].fPacketBuf, 0);
+        fStreams[x].fArrivalTime = 0;
+        fStreams[x].fPacketID = 0;
+        fStreams[x].fIsRTCP = false;
+        fStreams[x].fHavePacket = false;
+    }
+}
+
+ReflectorTimeShiftTask::~ReflectorTimeShiftTask()
+{
+    delete [] fStreams;
+}
+
+void ReflectorTimeShiftTask::Detach()
+{
+    {
+        OSMutexLocker locker(&fMutex);
+        fOutput = NULL;
+    }
+    this->Signal(Task::kKillEvent);
+}
+
+Bool16 ReflectorTimeShiftTask::ReadPacket(UInt32 inStreamIndex)
+{
+    StreamState* theState = &fStreams[inStreamIndex];
+    ReflectorTimeShiftBuffer* theBuffer = fSession->GetStreamByIndex(inStreamIndex)->GetTimeShiftBuffer();
+
+    theState->fPacket.Set(theState->fPacketBuf, ReflectorTimeShiftBuffer::kMaxPacketSize);
+    theState->fHavePacket = theBuffer->GetNextPacket(&theState->fPosition, &theState->fPacket,
+                                                    &theState->fArrivalTime, &theState->fPacketID, &theState->fIsRTCP);
+    return theState->fHavePacket;
+}
+
+Bool16 ReflectorTimeShiftTask::Seek(SInt64 inTime, SInt64 inBufferDelayMSec)
+{
+    OSMutexLocker locker(&fMutex);
+
+    for (UInt32 x = 0; x < fNumStreams; x++)
+    {
+        ReflectorStream* theStream = fSession->GetStreamByIndex(x);
+        if ((theStream == NULL) || (theStream->GetTimeShiftBuffer() == NULL))
+            return false;
+
+        if (!theStream->GetTimeShiftBuffer()->Seek(inTime, &fStreams[x].fPosition))
+            return false;
+
+        // Start each stream on an RTP packet so the RTP-Info is right.
+        // Sender reports come around again soon enough.
+        while (this->ReadPacket(x) && fStreams[x].fIsRTCP)
+            { }
+
+        if (!fStreams[x].fHavePacket)
+            return false;
+    }
+
+    fTimeShiftMSec = (OS::Milliseconds() - inBufferDelayMSec) - inTime;
+    return true;
+}
+
+Bool16 ReflectorTimeShiftTask::GetFirstPacketInfo(UInt32 inStreamIndex, UInt16* outSeqNum, UInt32* outRTPTime)
+{
+    OSMutexLocker locker(&fMutex);
+
+    if (inStreamIndex >= fNumStreams)
+        return false;
+
+    StreamState* theState = &fStreams[inStreamIndex];
+    if (!theState->fHavePacket || theState->fIsRTCP || (theState->fPacket.Len < 12))
+        return false;
+
+    *outSeqNum = ntohs(((UInt16*)theState->fPacket.Ptr)[1]);
+    *outRTPTime = ntohl(((UInt32*)theState->fPacket.Ptr)[1]);
+    return true;
+}
+
+SInt64 ReflectorTimeShiftTask::Run()
+{
+    OSMutexLocker locker(&fMutex);
+
+    EventFlags theEvents = this->GetEvents();
+    if ((fOutput == NULL) || (theEvents & Task::kKillEvent))
+        return -1;
+
+    SInt64 theCurrentTime = OS::Milliseconds();
+    SInt64 theWakeupTime = kIdleIntervalMSec;
+    UInt32 theNumPacketsWritten = 0;
+
+    for (UInt32 x = 0; x < fNumStreams; x++)
+    {
+        StreamState* theState = &fStreams[x];
+        void* theStreamCookie = fSession->GetStreamByIndex(x)->GetStreamCookie();
+
+        while (theNumPacketsWritten < kMaxPacketsPerRun)
+        {
+            if (!theState->fHavePacket && !this->ReadPacket(x))
+                break; // caught up with the live stream
+
+            // Hand the packet over as if it just arrived, shifted by the same amount as the rest
+            SInt64 theArrivalTime = theState->fArrivalTime + fTimeShiftMSec;
+            if (theArrivalTime > theCurrentTime)
+            {
+                if ((theArrivalTime - theCurrentTime) < theWakeupTime)
+                    theWakeupTime = theArrivalTime - theCurrentTime;
+                break;
+            }
+
+            UInt32 theFlags = (theState->fIsRTCP ? qtssWriteFlagsIsRTCP : qtssWriteFlagsIsRTP) | ReflectorOutput::kTimeShiftedPacket;
+            SInt64 theRetryTime = -1;
+            QTSS_Error theErr = fOutput->WritePacket(&theState->fPacket, theStreamCookie, theFlags, 0,
+                                                    &theRetryTime, &theState->fPacketID, &theArrivalTime);
+            if (theErr == QTSS_WouldBlock)
+            {
+                if ((theRetryTime > 0) && (theRetryTime < theWakeupTime))
+                    theWakeupTime = theRetryTime;
+                break;
+            }
+
+            theState->fHavePacket = false;
+            theNumPacketsWritten++;
+        }
+    }
+
+    if (theNumPacketsWritten == kMaxPacketsPerRun)
+        return 1; // more to do, but let other tasks run first
+
+    return theWakeupTime;
+}
@@ -0,0 +1,195 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       ReflectorTimeShift.h
+
+    Contains:   Time-shift support for reflected live streams.
+
+                ReflectorTimeShiftBuffer keeps the last few minutes of one ReflectorStream's
+                RTP and RTCP packets in a ring of fixed size segments, each a memory mapped
+                piece of a temporary file. A small time index per segment lets a reader
+                find the packet arriving at a given time, on a key frame for video.
+
+                ReflectorTimeShiftTask plays a ReflectorSession back from those buffers to
+                one ReflectorOutput, delayed by a fixed amount, through the same
+                ReflectorOutput::WritePacket path used for live packets.
+
+*/
+
+#ifndef _REFLECTOR_TIME_SHIFT_H_
+#define _REFLECTOR_TIME_SHIFT_H_
+
+#include "OSHeaders.h"
+#include "OSMutex.h"
+#include "StrPtrLen.h"
+#include "Task.h"
+
+class ReflectorSession;
+class ReflectorOutput;
+
+class ReflectorTimeShiftBuffer
+{
+    public:
+
+        // A reader's place in the buffer. If the segment gets reused
+        // underneath a reader, its generation no longer matches.
+        struct Position
+        {
+            Position() : fSegment(0), fGeneration(0), fOffset(0) {}
+            UInt32  fSegment;
+            UInt32  fGeneration;
+            UInt32  fOffset;
+        };
+
+        enum
+        {
+            kSegmentSize        = 1024 * 1024,
+            kIndexIntervalMSec  = 500,      // at most one index entry per interval
+            kMaxIndexEntries    = 256,      // per segment
+            kMaxPacketSize      = 2060      // same as a ReflectorPacket
+        };
+
+        ReflectorTimeShiftBuffer();
+        ~ReflectorTimeShiftBuffer();
+
+        // Creates the backing file in inFolder, sized for inNumSegments segments.
+        // The file is unlinked right away, so it goes away with the buffer.
+        OS_Error    Open(const char* inFolder, UInt32 inNumSegments, UInt32 inMaxAgeMSec);
+
+        // Records a packet. isSyncPoint should be true for packets a client can
+        // start decoding on; only those go into the time index.
+        void        AddPacket(StrPtrLen* inPacket, SInt64 inArrivalTime, UInt64 inPacketID, Bool16 isRTCP, Bool16 isSyncPoint);
+
+        // Finds the last sync point at or before inTime, or the oldest packet in the
+        // buffer if inTime is older than that. Returns false if the buffer is empty.
+        Bool16      Seek(SInt64 inTime, Position* outPosition);
+
+        // Copies out the packet at ioPosition and moves past it. ioPacket->Ptr must point to
+        // kMaxPacketSize bytes. Returns false if the reader has caught up with the writer.
+        Bool16      GetNextPacket(Position* ioPosition, StrPtrLen* ioPacket, SInt64* outArrivalTime, UInt64* outPacketID, Bool16* outIsRTCP);
+
+        // Returns the arrival time of the oldest packet still in the buffer, or 0 if empty.
+        SInt64      GetOldestTime();
+
+    private:
+
+        struct IndexEntry
+        {
+            SInt64  fTime;
+            UInt32  fOffset;
+        };
+
+        struct Segment
+        {
+            char*       fData;          // mapped when the writer first gets to this segment
+            UInt32      fUsed;
+            UInt32      fGeneration;
+            SInt64      fFirstTime;
+            SInt64      fLastTime;
+            UInt32      fNumIndexEntries;
+            IndexEntry  fIndex[kMaxIndexEntries];
+        };
+
+        struct RecordHeader
+        {
+            SInt64  fArrivalTime;
+            UInt64  fPacketID;
+            UInt16  fLen;
+            UInt16  fFlags;
+            UInt32  fReserved;
+        };
+
+        enum
+        {
+            kRTCPRecord     = 0x0001
+        };
+
+        Bool16      MapSegment(UInt32 inSegment);
+        Bool16      StartNextSegment();
+        Bool16      IsExpired(Segment* inSegment, SInt64 inCurrentTime);
+        UInt32      GetOldestSegment();
+
+        OSMutex     fMutex;
+        int         fFile;
+        Segment*    fSegments;
+        UInt32      fNumSegments;
+        UInt32      fWriteSegment;
+        UInt32      fMaxAgeMSec;
+};
+
+class ReflectorTimeShiftTask : public Task
+{
+    public:
+
+        ReflectorTimeShiftTask(ReflectorSession* inSession, ReflectorOutput* inOutput);
+        virtual ~ReflectorTimeShiftTask();
+
+        // Positions every stream at inTime (milliseconds since 1970). Packets are then
+        // handed to the output as if they had arrived inBufferDelayMSec ago, the same
+        // lead a new live output gets from the reflector's buffer.
+        // Returns false if any stream has nothing buffered for that time.
+        Bool16  Seek(SInt64 inTime, SInt64 inBufferDelayMSec);
+
+        // The RTP sequence number and timestamp the given stream will start with
+        Bool16  GetFirstPacketInfo(UInt32 inStreamIndex, UInt16* outSeqNum, UInt32* outRTPTime);
+
+        // The time of the packets currently being played out
+        SInt64  GetPlayPosition(SInt64 inCurrentTime, SInt64 inBufferDelayMSec) { return inCurrentTime - fTimeShiftMSec - inBufferDelayMSec; }
+
+        // Call instead of deleting. The task stops writing to the output and goes away.
+        void    Detach();
+
+        virtual SInt64 Run();
+
+    private:
+
+        struct StreamState
+        {
+            ReflectorTimeShiftBuffer::Position fPosition;
+            char        fPacketBuf[ReflectorTimeShiftBuffer::kMaxPacketSize];
+            StrPtrLen   fPacket;
+            SInt64      fArrivalTime;
+            UInt64      fPacketID;
+            Bool16      fIsRTCP;
+            Bool16      fHavePacket;
+        };
+
+        enum
+        {
+            kIdleIntervalMSec   = 20,   // how often to look for new packets once caught up
+            kMaxPacketsPerRun   = 200
+        };
+
+        Bool16  ReadPacket(UInt32 inStreamIndex);
+
+        OSMutex             fMutex;
+        ReflectorSession*   fSession;
+        ReflectorOutput*    fOutput;
+        StreamState*        fStreams;
+        UInt32              fNumStreams;
+        SInt64              fTimeShiftMSec;
+};
+
+#endif //_REFLECTOR_TIME_SHIFT_H_
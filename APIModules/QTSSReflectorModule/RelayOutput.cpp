@@ -39,6 +39,7 @@
 
 static StrPtrLen    sUDPDestStr("udp_destination");
 static StrPtrLen    sAnnouncedDestStr("announced_destination");
+static StrPtrLen    sRelayTreeDestStr("relay_tree");
 
 // STATIC DATA
 OSQueue RelayOutput::sRelayOutputQueue;
@@ -57,6 +58,7 @@ QTSS_AttributeID            RelayOutput::sOutputCurPacketsPerSec        =   qtss
 QTSS_AttributeID            RelayOutput::sOutputCurBitsPerSec       =   qtssIllegalAttrID;
 QTSS_AttributeID            RelayOutput::sOutputTotalPacketsSent        =   qtssIllegalAttrID;
 QTSS_AttributeID            RelayOutput::sOutputTotalBytesSent      =   qtssIllegalAttrID;
+QTSS_AttributeID            RelayOutput::sOutputTreeDepth       =   qtssIllegalAttrID;
 
 static char*                    sOutputTypeName     = "output_type";
 static char*                    sOutputDestAddrName     = "output_dest_addr";
@@ -70,6 +72,7 @@ static char*                    sOutputCurPacketsPerSecName = "output_cur_packet
 static char*                    sOutputCurBitsPerSecName    = "output_cur_bitspersec";
 static char*                    sOutputTotalPacketsSentName = "output_total_packets_sent";
 static char*                    sOutputTotalBytesSentName   = "output_total_bytes_sent";
+static char*                    sOutputTreeDepthName        = "output_tree_depth";
 
 void RelayOutput::Register()
 {
@@ -109,6 +112,9 @@ void RelayOutput::Register()
     
     (void)QTSS_AddStaticAttribute(qtssRelayOutputObjectType, sOutputTotalBytesSentName, NULL, qtssAttrDataTypeUInt64);
     (void)QTSS_IDForAttr(qtssRelayOutputObjectType, sOutputTotalBytesSentName, &sOutputTotalBytesSent); // total bytes
+    
+    (void)QTSS_AddStaticAttribute(qtssRelayOutputObjectType, sOutputTreeDepthName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssRelayOutputObjectType, sOutputTreeDepthName, &sOutputTreeDepth);   // relay tree depth
 
 }
 
@@ -166,6 +172,13 @@ RelayOutput::RelayOutput(SourceInfo* inInfo, UInt32 inWhichOutput, RelaySession*
             fOutputInfo.fPortArray[y] = (UInt16) (fOutputInfo.fBasePort + (y * 2) );
     }
     
+    // Copy the children of this server if this is a relay tree output
+    if (fOutputInfo.fFanOutAddrArray != NULL)
+    {
+        fOutputInfo.fFanOutAddrArray = NEW UInt32[fOutputInfo.fNumFanOutAddrs];//copy constructor doesn't do this
+        ::memcpy(fOutputInfo.fFanOutAddrArray, inInfo->GetOutputInfo(inWhichOutput)->fFanOutAddrArray, fOutputInfo.fNumFanOutAddrs * sizeof(UInt32));
+    }
+    
     OS_Error err = BindSocket();
     if (err != OS_NoErr)
     {
@@ -225,6 +238,7 @@ RelayOutput::RelayOutput(SourceInfo* inInfo, UInt32 inWhichOutput, RelaySession*
     // Write the Output HTML
     // Looks like: Relaying to: 229.49.52.102, Ports: 16898 16900 Time to live: 15
     static StrPtrLen sHTMLStart("Relaying to: ");
+    static StrPtrLen sAddrSeparator(" ");
     static StrPtrLen sPorts(", Ports: ");
     static StrPtrLen sTimeToLive(" Time to live: ");
     static StrPtrLen sHTMLEnd("<BR>");
@@ -239,6 +253,15 @@ RelayOutput::RelayOutput(SourceInfo* inInfo, UInt32 inWhichOutput, RelaySession*
     // Begin writing the HTML
     fFormatter.Put(sHTMLStart);
     fFormatter.Put(theIPAddr);
+    for (UInt32 z = 1; z < fOutputInfo.fNumFanOutAddrs; z++)
+    {
+        // The other children of a relay tree output
+        theIPAddr.Set(theIPAddrBuf, 20);
+        theAddr.s_addr = htonl(fOutputInfo.fFanOutAddrArray[z]);
+        SocketUtils::ConvertAddrToString(theAddr, &theIPAddr);
+        fFormatter.Put(sAddrSeparator);
+        fFormatter.Put(theIPAddr);
+    }
     fFormatter.Put(sPorts);
     
     for (UInt32 y = 0; y < fNumStreams; y++)
@@ -355,7 +378,7 @@ Bool16  RelayOutput::Equal(SourceInfo* inInfo)
     return false;
 }
 
-QTSS_Error  RelayOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 /*packetLatenessInMSec*/, SInt64* /*timeToSendThisPacketAgain*/, UInt64* packetIDPtr, SInt64* /*arrivalTimeMSec*/ )
+QTSS_Error  RelayOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 /*packetLatenessInMSec*/, SInt64* /*timeToSendThisPacketAgain*/, UInt64* packetIDPtr, SInt64* /*arrivalTimeMSec*/, OSSharedBuffer* /*inSharedBuffer*/ )
 {
 
     if (!fValid || fDoingAnnounce)
@@ -373,12 +396,25 @@ QTSS_Error  RelayOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCookie,
             if (inFlags & qtssWriteFlagsIsRTCP)
                 theDestPort++;
             
-            (void)fOutputSocket.SendTo(fOutputInfo.fDestAddr, theDestPort, 
+            if (fOutputInfo.fFanOutAddrArray == NULL)
+            {
+                (void)fOutputSocket.SendTo(fOutputInfo.fDestAddr, theDestPort, 
                                             inPacket->Ptr, inPacket->Len);
 
-            // Update our totals
-            fTotalPacketsSent++;
-            fTotalBytesSent += inPacket->Len;
+                // Update our totals
+                fTotalPacketsSent++;
+                fTotalBytesSent += inPacket->Len;
+                break;
+            }
+            
+            // A relay tree output sends to all of this server's children from one socket,
+            // so the stream lookup and statistics are done once per packet, not per child,
+            // and where the platform allows the children share one send call.
+            (void)fOutputSocket.SendToMany(fOutputInfo.fFanOutAddrArray, fOutputInfo.fNumFanOutAddrs,
+                                            theDestPort, inPacket->Ptr, inPacket->Len);
+
+            fTotalPacketsSent += fOutputInfo.fNumFanOutAddrs;
+            fTotalBytesSent += inPacket->Len * fOutputInfo.fNumFanOutAddrs;
             break;
         }
     }
@@ -402,6 +438,8 @@ QTSS_Error  RelayOutput::WritePacket(StrPtrLen* inPacket, void* inStreamCookie,
         fLastUpdateTime = curTime;
         fLastPackets = fTotalPacketsSent;
         fLastBytes = fTotalBytesSent;
+        
+        fRelaySession->UpdateSourceStats();
     }
     
     return QTSS_NoErr;
@@ -516,7 +554,15 @@ void RelayOutput::SetupRelayOutputObject(RTSPOutputInfo* inRTSPInfo)
     theErr = QTSS_CreateObjectValue (fRelaySessionObject , RelaySession::sRelayOutputObject, qtssRelayOutputObjectType, &outIndex, &fRelayOutputObject);
     Assert(theErr == QTSS_NoErr);
     
-    if ((inRTSPInfo == NULL) || !inRTSPInfo->fIsAnnounced)          // output type
+    if (fOutputInfo.fFanOutAddrArray != NULL)                       // output type
+    {
+        theErr = QTSS_SetValue (fRelayOutputObject, sOutputType, 0, (void*)sRelayTreeDestStr.Ptr, sRelayTreeDestStr.Len);
+        Assert(theErr == QTSS_NoErr);
+        
+        theErr = QTSS_SetValue (fRelayOutputObject, sOutputTreeDepth, 0, &fOutputInfo.fTreeDepth, sizeof(fOutputInfo.fTreeDepth)); // tree depth
+        Assert(theErr == QTSS_NoErr);
+    }
+    else if ((inRTSPInfo == NULL) || !inRTSPInfo->fIsAnnounced)
     {
         theErr = QTSS_SetValue (fRelayOutputObject, sOutputType, 0, (void*)sUDPDestStr.Ptr, sUDPDestStr.Len);
         Assert(theErr == QTSS_NoErr);
@@ -543,6 +589,16 @@ void RelayOutput::SetupRelayOutputObject(RTSPOutputInfo* inRTSPInfo)
     theErr = QTSS_SetValue (fRelayOutputObject, sOutputDestAddr, 0, (void*)theIPAddr.Ptr, theIPAddr.Len);
     Assert(theErr == QTSS_NoErr);
     
+    for (UInt32 addrIndex = 1; addrIndex < fOutputInfo.fNumFanOutAddrs; addrIndex++) // other relay tree children
+    {
+        theIPAddr.Set(theIPAddrBuf, 20);
+        theDestAddr.s_addr = htonl(fOutputInfo.fFanOutAddrArray[addrIndex]);
+        SocketUtils::ConvertAddrToString(theDestAddr, &theIPAddr);
+        
+        theErr = QTSS_SetValue (fRelayOutputObject, sOutputDestAddr, addrIndex, (void*)theIPAddr.Ptr, theIPAddr.Len);
+        Assert(theErr == QTSS_NoErr);
+    }
+    
     struct in_addr theLocalAddr;        // output local address
     theLocalAddr.s_addr = htonl(fOutputInfo.fLocalAddr);
     SocketUtils::ConvertAddrToString(theLocalAddr, &theIPAddr); 
@@ -62,7 +62,7 @@ class RelayOutput : public ReflectorOutput
         OS_Error BindSocket();
         
         // Writes the packet directly to a UDP socket
-        virtual QTSS_Error  WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec,  SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTime);
+        virtual QTSS_Error  WritePacket(StrPtrLen* inPacket, void* inStreamCookie, UInt32 inFlags, SInt64 packetLatenessInMSec,  SInt64* timeToSendThisPacketAgain, UInt64* packetIDPtr, SInt64* arrivalTime, OSSharedBuffer* inSharedBuffer = NULL);
         
         virtual Bool16              IsUDP() { return true; }
         
@@ -168,6 +168,7 @@ class RelayOutput : public ReflectorOutput
         static QTSS_AttributeID         sOutputCurBitsPerSec;
         static QTSS_AttributeID         sOutputTotalPacketsSent;
         static QTSS_AttributeID         sOutputTotalBytesSent;
+        static QTSS_AttributeID         sOutputTreeDepth;
 
 
 
@@ -53,6 +53,9 @@ static char*        sSourceURLName              = "source_url";
 static char*        sSourceUsernameName         = "source_username";
 static char*        sSourcePasswordName         = "source_password";
 static char*        sSourceTTLName              = "source_ttl";
+static char*        sSourcePacketsReceivedName  = "source_packets_received";
+static char*        sSourcePacketsLostName      = "source_packets_lost";
+static char*        sSourceJitterName           = "source_jitter_msec";
 static char*        sRelayOutputObjectName          = "relay_output";
 
 QTSS_Object     RelaySession::relayModuleAttributesObject;
@@ -69,6 +72,9 @@ QTSS_AttributeID    RelaySession::sSourceURL            =   qtssIllegalAttrID;
 QTSS_AttributeID    RelaySession::sSourceUsername       =   qtssIllegalAttrID;
 QTSS_AttributeID    RelaySession::sSourcePassword       =   qtssIllegalAttrID;
 QTSS_AttributeID    RelaySession::sSourceTTL            =   qtssIllegalAttrID;
+QTSS_AttributeID    RelaySession::sSourcePacketsReceived    =   qtssIllegalAttrID;
+QTSS_AttributeID    RelaySession::sSourcePacketsLost    =   qtssIllegalAttrID;
+QTSS_AttributeID    RelaySession::sSourceJitter         =   qtssIllegalAttrID;
 QTSS_AttributeID    RelaySession::sRelayOutputObject    =   qtssIllegalAttrID;
 
 char            RelaySession::sRelayUserAgent[20] = "";
@@ -111,6 +117,15 @@ void RelaySession::Register()
     (void)QTSS_AddStaticAttribute(qtssRelaySessionObjectType, sSourceTTLName, NULL, qtssAttrDataTypeUInt16);
     (void)QTSS_IDForAttr(qtssRelaySessionObjectType, sSourceTTLName, &sSourceTTL);                  // ttl
     
+    (void)QTSS_AddStaticAttribute(qtssRelaySessionObjectType, sSourcePacketsReceivedName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssRelaySessionObjectType, sSourcePacketsReceivedName, &sSourcePacketsReceived); // packets received
+    
+    (void)QTSS_AddStaticAttribute(qtssRelaySessionObjectType, sSourcePacketsLostName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssRelaySessionObjectType, sSourcePacketsLostName, &sSourcePacketsLost); // packets lost
+    
+    (void)QTSS_AddStaticAttribute(qtssRelaySessionObjectType, sSourceJitterName, NULL, qtssAttrDataTypeUInt32);
+    (void)QTSS_IDForAttr(qtssRelaySessionObjectType, sSourceJitterName, &sSourceJitter);           // jitter
+    
     (void)QTSS_AddStaticAttribute(qtssRelaySessionObjectType, sRelayOutputObjectName, NULL, qtssAttrDataTypeQTSS_Object);
     (void)QTSS_IDForAttr(qtssRelaySessionObjectType, sRelayOutputObjectName, &sRelayOutputObject);  // relay output
         
@@ -237,6 +252,15 @@ QTSS_Error RelaySession::SetupRelaySession(SourceInfo* inInfo)
         theErr = QTSS_SetValue (fRelaySessionObject, sSourceTTL, 0, &ttl, sizeof(ttl)); // source ttl
         Assert(theErr == QTSS_NoErr);
         
+        theErr = QTSS_SetValuePtr (fRelaySessionObject, sSourcePacketsReceived, &fSourcePacketsReceived, sizeof(fSourcePacketsReceived));
+        Assert(theErr == QTSS_NoErr);
+        
+        theErr = QTSS_SetValuePtr (fRelaySessionObject, sSourcePacketsLost, &fSourcePacketsLost, sizeof(fSourcePacketsLost));
+        Assert(theErr == QTSS_NoErr);
+        
+        theErr = QTSS_SetValuePtr (fRelaySessionObject, sSourceJitter, &fSourceJitterInMSec, sizeof(fSourceJitterInMSec));
+        Assert(theErr == QTSS_NoErr);
+        
         theErr = QTSS_UnlockObject(relayModuleAttributesObject);
         Assert(theErr == QTSS_NoErr);
         
@@ -261,9 +285,25 @@ RelaySession::~RelaySession()
     }
 }
 
-
-
-
-
-
-
+void RelaySession::UpdateSourceStats()
+{
+    UInt32 thePacketsReceived = 0;
+    UInt32 thePacketsLost = 0;
+    UInt32 theJitter = 0;
+    
+    for (UInt32 x = 0; x < this->GetNumStreams(); x++)
+    {
+        ReflectorStream* theStream = this->GetStreamByIndex(x);
+        if (theStream == NULL)
+            continue;
+            
+        thePacketsReceived += theStream->GetPacketsReceived();
+        thePacketsLost += theStream->GetPacketsLost();
+        if (theStream->GetJitterInMSec() > theJitter)
+            theJitter = theStream->GetJitterInMSec(); // report the worst stream
+    }
+    
+    fSourcePacketsReceived = thePacketsReceived;
+    fSourcePacketsLost = thePacketsLost;
+    fSourceJitterInMSec = theJitter;
+}
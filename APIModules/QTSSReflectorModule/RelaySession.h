@@ -52,12 +52,18 @@ class RelaySession : public ReflectorSession
         // Call Initialize in the Relay Module's Initialize Role
         static void Initialize(QTSS_Object inAttrObject);
         
-        RelaySession(StrPtrLen* inSourceID, SourceInfo* inInfo = NULL):ReflectorSession(inSourceID, inInfo){};
+        RelaySession(StrPtrLen* inSourceID, SourceInfo* inInfo = NULL):ReflectorSession(inSourceID, inInfo),
+            fSourcePacketsReceived(0), fSourcePacketsLost(0), fSourceJitterInMSec(0) {};
         ~RelaySession();
          
         QTSS_Error SetupRelaySession(SourceInfo* inInfo);
         
         QTSS_Object GetRelaySessionObject() { return fRelaySessionObject; }
+        
+        // Totals up the receive statistics of all the incoming streams. For a node
+        // in a relay tree these describe the hop from its parent.
+        void        UpdateSourceStats();
+        
         static QTSS_AttributeID     sRelayOutputObject;
 
         static char         sRelayUserAgent[20];
@@ -66,6 +72,10 @@ class RelaySession : public ReflectorSession
         
         QTSS_Object                 fRelaySessionObject;
         
+        UInt32                      fSourcePacketsReceived;
+        UInt32                      fSourcePacketsLost;
+        UInt32                      fSourceJitterInMSec;
+        
         // gets set in the initialize method
         static QTSS_Object          relayModuleAttributesObject;
         
@@ -82,6 +92,9 @@ class RelaySession : public ReflectorSession
         static QTSS_AttributeID     sSourceUsername;
         static QTSS_AttributeID     sSourcePassword;
         static QTSS_AttributeID     sSourceTTL;
+        static QTSS_AttributeID     sSourcePacketsReceived;
+        static QTSS_AttributeID     sSourcePacketsLost;
+        static QTSS_AttributeID     sSourceJitter;
                 
                 
 };
@@ -102,7 +102,8 @@ enum
     qtssWriteFlagsIsRTP             = 0x00000001,
     qtssWriteFlagsIsRTCP            = 0x00000002,   
     qtssWriteFlagsWriteBurstBegin   = 0x00000004,
-    qtssWriteFlagsBufferData        = 0x00000008
+    qtssWriteFlagsBufferData        = 0x00000008,
+    qtssWriteFlagsSharedPacket      = 0x00000010    // inBuffer is a QTSS_SharedPacketStruct
 };
 typedef UInt32 QTSS_WriteFlags;
 
@@ -430,8 +431,10 @@ enum
     qtssRTPStrSvrRTPPort            = 36,   //read      //UInt16            // Port the server is sending RTP packets from for this stream
     qtssRTPStrClientRTPPort         = 37,   //read      //UInt16            // Port the server is sending RTP packets to for this stream
     qtssRTPStrNetworkMode           = 38,   //read      //QTSS_RTPNetworkMode // unicast or multicast
+    qtssRTPStrRoundTripTimeInMsec   = 39,   //read      //UInt32            // Round trip time to the client, from the last receiver report (or reliable UDP acks). 0 if unknown.
+    qtssRTPStrCurPacketDelayInMsec  = 40,   //read      //SInt32            // How late the last RTP packet written was, compared to its transmit time. Negative if early.
 
-    qtssRTPStrNumParams             = 39
+    qtssRTPStrNumParams             = 41
 
 };
 typedef UInt32 QTSS_RTPStreamAttributes;
@@ -635,7 +638,19 @@ enum
     qtssSvrServerPlatform           = 39,   //read      /char array //Platform (OS) of the server
     qtssSvrRTSPServerComment        = 40,   //read      /char array //RTSP comment for the server header
     
-    qtssSvrNumParams                = 41
+    qtssSvrMemorySizeClasses        = 41,   //read      //UInt32    //Indexed. Block sizes the server's memory allocator rounds small allocations up to. Empty if the allocator has no size classes.
+    qtssSvrMemoryBytesInUse         = 42,   //read      //UInt64    //Indexed. Bytes allocated and not yet freed in each of qtssSvrMemorySizeClasses, followed by bytes in blocks too big for any class.
+    qtssSvrMemoryThreadCacheHitPercent = 43,//read      //Float32   //Indexed. For each thread, % of its allocations served from its own cache of freed blocks.
+    qtssSvrObjectPoolHighWaterMark  = 44,   //read      //UInt32    //Indexed. Most RTSP sessions (0), RTP sessions (1) and RTP streams (2) ever allocated at once.
+    qtssSvrObjectPoolHitPercent     = 45,   //read      //Float32   //Indexed, same order. % of those objects created in memory recycled from one that went away.
+    qtssSvrTaskLatencyInMsec        = 46,   //read      //UInt32    //How far behind schedule the task threads are running, smoothed.
+    qtssSvrNumRejectedConnections   = 47,   //read      //UInt32    //RTSP connections turned away at accept time because the server was overloaded.
+    qtssSvrNumUDPSegmentedSends     = 48,   //read      //UInt64    //Segmented UDP sends that carried more than one RTP packet.
+    qtssSvrNumUDPSegmentsSent       = 49,   //read      //UInt64    //RTP packets sent by those. Divide by qtssSvrNumUDPSegmentedSends for packets per send.
+    qtssSvrSendWakeupsPerSec        = 50,   //read      //UInt32    //Times per second playing RTP sessions woke up to send packets.
+    qtssSvrWastedSendWakeupsPerSec  = 51,   //read      //UInt32    //How many of those didn't send any.
+    
+    qtssSvrNumParams                = 52
 };
 typedef UInt32 QTSS_ServerAttributes;
 
@@ -732,8 +747,13 @@ enum
 	qtssPrefsPidFile						= 67,	//"pid_file" //Char Array //path to pid file
     qtssPrefsCloseLogsOnWrite               = 68,   // "force_logs_close_on_write" //Bool16 // force log files to close after each write.
     qtssPrefsRTSPPlayInfoFullURL            = 69,   // "enable_rtsp_play_info_full_url" //Bool16 // put the full url in the rtp-info header of the PLAY response.
+    qtssPrefsOverloadTaskLatencyInMsec      = 70,   // "overload_task_latency" //UInt32 // turn new RTSP connections away while the task threads run this far behind. 0 means no limit.
+    qtssPrefsOverloadQueuedTasks            = 71,   // "overload_queued_tasks" //UInt32 // turn new RTSP connections away while this many tasks are waiting to run. 0 means no limit.
+    qtssPrefsKernelPacingWindowInMsec       = 72,   // "kernel_pacing_window" //UInt32 // on Linux, hand UDP packets due this far ahead to the kernel with SO_TXTIME send times (needs the fq qdisc). 0 means off.
+    qtssPrefsEnableUDPSegmentation          = 73,   // "enable_udp_segmentation" //Bool16 // on Linux, send runs of same size RTP packets to a client in one UDP_SEGMENT call.
+    qtssPrefsEnableRTCPMux                  = 74,   // "enable_rtcp_mux" //Bool16 // accept rtcp-mux (RFC 5761) in SETUP, so RTCP shares the RTP port.
 
-    qtssPrefsNumParams                      = 70
+    qtssPrefsNumParams                      = 75
 };
 
 typedef UInt32 QTSS_PrefsAttributes;
@@ -919,6 +939,8 @@ enum
     
     //RTCP-specific
     QTSS_RTCPProcess_Role =          FOUR_CHARS_TO_INT('r', 't', 'c', 'p'), //rtcp //Process all RTCP packets sent to the server
+    QTSS_RTCPReport_Role =           FOUR_CHARS_TO_INT('r', 't', 'c', 'r'), //rtcr //Only RTCP packets with a receiver report or client status in them,
+                                        //after the stream's stats are updated. Gets the same params as QTSS_RTCPProcess_Role.
 
     //File system roles
     QTSS_OpenFilePreProcess_Role =  FOUR_CHARS_TO_INT('o', 'p', 'p', 'r'),  //oppr
@@ -1127,6 +1149,15 @@ typedef struct
     QTSS_TimeVal                    suggestedWakeupTime;
 } QTSS_PacketStruct;
 
+// Write this with qtssWriteFlagsSharedPacket when the packet data lives in an
+// OSSharedBuffer. If the server needs to hold on to the packet, for instance to
+// retransmit it over reliable UDP, it takes a reference instead of a copy.
+typedef struct
+{
+    QTSS_PacketStruct               packet;
+    void*                           sharedBuffer;   // OSSharedBuffer*
+} QTSS_SharedPacketStruct;
+
 
 /********************************************************************/
 // ENTRYPOINTS & FUNCTION TYPEDEFS
@@ -1160,6 +1191,16 @@ QTSS_Error _stublibrary_main(void* inPrivateArgs, QTSS_DispatchFuncPtr inDispatc
 void*   QTSS_New(FourCharCode inMemoryIdentifier, UInt32 inSize);
 void    QTSS_Delete(void* inMemory);
 
+/********************************************************************/
+//  QTSS_NewRequestMemory
+//
+//  Allocates memory that is freed by the server along with inRequest, once
+//  the request has been processed. Don't pass it to QTSS_Delete. This is
+//  cheaper than QTSS_New for buffers that don't outlive the request.
+//
+//  Returns NULL if inRequest is NULL.
+void*   QTSS_NewRequestMemory(QTSS_RTSPRequestObject inRequest, UInt32 inSize);
+
 /********************************************************************/
 //  QTSS_Milliseconds
 //
@@ -73,6 +73,11 @@ void            QTSS_Delete(void* inMemory)
     (sCallbacks->addr [kDeleteCallback]) (inMemory);
 }
 
+void*           QTSS_NewRequestMemory(QTSS_RTSPRequestObject inRequest, UInt32 inSize)
+{
+    return (void *) ((QTSS_CallbackPtrProcPtr) sCallbacks->addr [kNewRequestMemoryCallback]) (inRequest, inSize);
+}
+
 SInt64          QTSS_Milliseconds(void)
 {
     SInt64 outMilliseconds = 0;
@@ -135,6 +135,10 @@ SOURCE=.\OS.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\OSArena.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\OSBufferPool.cpp
 # End Source File
 # Begin Source File
@@ -195,6 +199,10 @@ SOURCE=.\StringFormatter.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\StringLookupTable.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\StringParser.cpp
 # End Source File
 # Begin Source File
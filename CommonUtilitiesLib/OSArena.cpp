@@ -0,0 +1,97 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       OSArena.cpp
+
+    Contains:   implements OSArena class
+
+
+*/
+
+#include "OSArena.h"
+#include "OSMemory.h"
+
+OSArena::OSArena(char* inFirstBlock, UInt32 inFirstBlockSize)
+:   fFirstBlock(inFirstBlock),
+    fFirstBlockSize(inFirstBlock != NULL ? inFirstBlockSize : 0),
+    fCurrent(inFirstBlock),
+    fEnd(inFirstBlock + fFirstBlockSize),
+    fOverflowBlocks(NULL),
+    fBytesAllocated(0)
+{}
+
+void* OSArena::Alloc(UInt32 inSize)
+{
+    UInt32 theSize = Align(inSize);
+    if ((fCurrent == NULL) || ((UInt32)(fEnd - fCurrent) < theSize))
+    {
+        // Doesn't fit. Start a new block, big enough for this allocation if it
+        // is bigger than a normal block. Whatever is left in the old one is wasted.
+        UInt32 theBlockSize = kOverflowBlockSize;
+        if (theSize > theBlockSize - sizeof(BlockHeader))
+            theBlockSize = theSize + sizeof(BlockHeader);
+
+        BlockHeader* theBlock = (BlockHeader*)NEW char[theBlockSize];
+        theBlock->fNext = fOverflowBlocks;
+        theBlock->fSize = theBlockSize;
+        fOverflowBlocks = theBlock;
+
+        fCurrent = (char*)(theBlock + 1);
+        fEnd = (char*)theBlock + theBlockSize;
+    }
+
+    void* theMem = fCurrent;
+    fCurrent += theSize;
+    fBytesAllocated += theSize;
+    return theMem;
+}
+
+void OSArena::Release(void* inPtr, UInt32 inSize)
+{
+    UInt32 theSize = Align(inSize);
+    if ((inPtr != NULL) && ((char*)inPtr + theSize == fCurrent))
+    {
+        fCurrent = (char*)inPtr;
+        fBytesAllocated -= theSize;
+    }
+}
+
+void OSArena::Reset()
+{
+    this->FreeOverflowBlocks();
+    fCurrent = fFirstBlock;
+    fEnd = fFirstBlock + fFirstBlockSize;
+    fBytesAllocated = 0;
+}
+
+void OSArena::FreeOverflowBlocks()
+{
+    while (fOverflowBlocks != NULL)
+    {
+        BlockHeader* theNext = fOverflowBlocks->fNext;
+        delete [] (char*)fOverflowBlocks;
+        fOverflowBlocks = theNext;
+    }
+}
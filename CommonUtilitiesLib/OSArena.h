@@ -0,0 +1,90 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       OSArena.h
+
+    Contains:   A bump pointer allocator for memory that all goes away at once, such
+                as everything allocated while handling one RTSP request.
+
+                Allocations come out of a caller supplied first block, usually a member
+                array of the owning object, and then out of overflow blocks allocated
+                as needed. Nothing is freed individually. Reset() frees the overflow
+                blocks and starts over at the beginning of the first block.
+
+*/
+
+#ifndef __OSARENA_H__
+#define __OSARENA_H__
+
+#include "OSHeaders.h"
+
+class OSArena
+{
+    public:
+
+        // inFirstBlock may be NULL. If it isn't, it must be 8 byte aligned
+        // and must outlive the arena.
+        OSArena(char* inFirstBlock, UInt32 inFirstBlockSize);
+        ~OSArena() { this->FreeOverflowBlocks(); }
+
+        // Returns inSize bytes, 8 byte aligned. Never returns NULL.
+        void*   Alloc(UInt32 inSize);
+
+        // Gives the memory back if it was the last thing allocated, so a
+        // temporary buffer doesn't use up space. Otherwise does nothing.
+        void    Release(void* inPtr, UInt32 inSize);
+
+        // Frees everything allocated so far
+        void    Reset();
+
+        UInt32  GetBytesAllocated()     { return fBytesAllocated; }
+
+    private:
+
+        enum
+        {
+            kAlignment          = 8,
+            kOverflowBlockSize  = 4096
+        };
+
+        struct BlockHeader
+        {
+            BlockHeader*    fNext;
+            UInt32          fSize;
+            UInt32          fPad;   // keeps the data after the header aligned
+        };
+
+        static UInt32   Align(UInt32 inSize)  { return (inSize + kAlignment - 1) & ~(kAlignment - 1); }
+        void            FreeOverflowBlocks();
+
+        char*           fFirstBlock;
+        UInt32          fFirstBlockSize;
+        char*           fCurrent;       // next free byte in the current block
+        char*           fEnd;           // end of the current block
+        BlockHeader*    fOverflowBlocks;// most recent first
+        UInt32          fBytesAllocated;
+};
+
+#endif // __OSARENA_H__
@@ -37,6 +37,10 @@
 void*   OSBufferPool::Get()
 {
     OSMutexLocker locker(&fMutex);
+    fNumGets++;
+    if (++fNumBuffersInUse > fHighWaterMark)
+        fHighWaterMark = fNumBuffersInUse;
+        
     if (fQueue.GetLength() == 0)
     {
         fTotNumBuffers++;
@@ -50,11 +54,19 @@ void*   OSBufferPool::Get()
 
         return theNewBuf + sizeof(OSQueueElem);
     }
+    fNumReuses++;
     return fQueue.DeQueue()->GetEnclosingObject();
 }
 
 void OSBufferPool::Put(void* inBuffer)
 {
     OSMutexLocker locker(&fMutex);
+    fNumBuffersInUse--;
+    if ((fMaxFreeBuffers != 0) && (fQueue.GetLength() >= fMaxFreeBuffers))
+    {
+        fTotNumBuffers--;
+        delete [] ((char*)inBuffer - sizeof(OSQueueElem));
+        return;
+    }
     fQueue.EnQueue((OSQueueElem*)((char*)inBuffer - sizeof(OSQueueElem)));
 }
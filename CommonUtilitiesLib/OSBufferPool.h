@@ -41,7 +41,11 @@ class OSBufferPool
 {
     public:
     
-        OSBufferPool(UInt32 inBufferSize) : fBufSize(inBufferSize), fTotNumBuffers(0) {}
+        // If inMaxFreeBuffers isn't 0, buffers put back while that many are already
+        // waiting in the pool are freed instead of kept.
+        OSBufferPool(UInt32 inBufferSize, UInt32 inMaxFreeBuffers = 0)
+        :   fBufSize(inBufferSize), fTotNumBuffers(0), fMaxFreeBuffers(inMaxFreeBuffers),
+            fNumBuffersInUse(0), fHighWaterMark(0), fNumGets(0), fNumReuses(0) {}
         
         //
         // This object currently *does not* clean up for itself when
@@ -52,6 +56,13 @@ class OSBufferPool
         // ACCESSORS
         UInt32  GetTotalNumBuffers() { return fTotNumBuffers; }
         UInt32  GetNumAvailableBuffers() { return fQueue.GetLength(); }
+        UInt32  GetBufferSize()         { return fBufSize; }
+        
+        // Most buffers ever out of the pool at once
+        UInt32  GetHighWaterMark()      { return fHighWaterMark; }
+        
+        // % of Gets that reused a buffer instead of allocating one
+        Float32 GetHitPercent()         { return (fNumGets == 0) ? 0 : (Float32)(((Float64)fNumReuses * 100) / fNumGets); }
         
         //
         // All these functions are thread-safe
@@ -71,6 +82,11 @@ class OSBufferPool
         OSQueue fQueue;
         UInt32  fBufSize;
         UInt32  fTotNumBuffers;
+        UInt32  fMaxFreeBuffers;
+        UInt32  fNumBuffersInUse;
+        UInt32  fHighWaterMark;
+        UInt64  fNumGets;
+        UInt64  fNumReuses;
 };
 
 #endif //__OS_BUFFER_POOL_H__
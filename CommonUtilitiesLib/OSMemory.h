@@ -78,6 +78,26 @@ class OSMemory
         //the server exits with
         static void SetMemoryError(SInt32 inErr);
         
+        //
+        // THREAD CACHE STATS
+        //
+        // With MEMORY_THREAD_CACHE on, small blocks are rounded up to one of kNumSizeClasses
+        // sizes, and each thread keeps freed blocks of each size to hand out again.
+        // Without it, these report no size classes and no threads.
+        enum
+        {
+            kNumSizeClasses = 16
+        };
+        
+        // Byte size of each class, or 0 if the cache isn't built in
+        static UInt32   GetSizeClassSize(UInt32 inClass);
+        
+        // outBytesInUse gets kNumSizeClasses + 1 values: bytes handed out and not
+        // yet freed for each class, then for blocks too big for any class.
+        // outHitPercent gets the share of allocations each thread served from its own
+        // cache, for up to ioNumThreads threads. ioNumThreads is set to the number filled in.
+        static void     GetThreadCacheStats(UInt64* outBytesInUse, Float32* outHitPercent, UInt32* ioNumThreads);
+        
 #if MEMORY_DEBUGGING
     private:
             
@@ -0,0 +1,69 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       OSSharedBuffer.h
+
+    Contains:   A reference counted block of memory, for packet data that more than
+                one object may hold on to, such as a reflected packet that several
+                reliable UDP clients might still have to retransmit.
+
+                A new buffer has one reference, held by whoever created it. The buffer
+                is deleted when the last reference is released.
+
+*/
+
+#ifndef __OSSHAREDBUFFER_H__
+#define __OSSHAREDBUFFER_H__
+
+#include "OSHeaders.h"
+#include "OSMemory.h"
+#include "atomic.h"
+
+class OSSharedBuffer
+{
+    public:
+    
+        OSSharedBuffer(UInt32 inSize) : fRefCount(1), fSize(inSize) { fData = NEW char[inSize]; }
+        
+        void    Retain()    { (void)atomic_add(&fRefCount, 1); }
+        void    Release()   { if (atomic_sub(&fRefCount, 1) == 0) delete this; }
+        
+        // True if anyone besides the caller holds a reference. Only meaningful
+        // to a holder that knows no one else will take a new reference meanwhile.
+        Bool16  IsShared()  { return fRefCount > 1; }
+        
+        char*   GetData()   { return fData; }
+        UInt32  GetSize()   { return fSize; }
+        
+    private:
+    
+        ~OSSharedBuffer()   { delete [] fData; }
+        
+        unsigned int    fRefCount;
+        UInt32          fSize;
+        char*           fData;
+};
+
+#endif //__OSSHAREDBUFFER_H__
@@ -40,6 +40,11 @@
 #include <sys/uio.h>
 #include <unistd.h>
 #include <netinet/tcp.h>
+#include <sys/ioctl.h>
+
+#if __linux__
+#include <linux/sockios.h>
+#endif
 
 #endif
 
@@ -123,6 +128,34 @@ OS_Error    Socket::SetSocketRcvBufSize(UInt32 inNewSize)
     return OS_NoErr;
 }
 
+UInt32  Socket::GetSendBufferSpace()
+{
+#ifndef USE_NETLOG
+#if defined(__Win32__) || defined(__MacOSX__) || defined(__sgi__) || defined(__osf__) || defined(__hpux__)
+    // missing from some platform includes
+    typedef int socklen_t;
+#endif
+#endif
+    int bufSize = 0;
+    socklen_t optLen = sizeof(bufSize);
+    if (::getsockopt(fFileDesc, SOL_SOCKET, SO_SNDBUF, (char*)&bufSize, &optLen) == -1)
+        return 0;
+        
+    int queued = 0;
+#if __linux__
+    if (::ioctl(fFileDesc, SIOCOUTQ, &queued) == -1)
+        queued = 0;
+#elif __MacOSX__
+    optLen = sizeof(queued);
+    if (::getsockopt(fFileDesc, SOL_SOCKET, SO_NWRITE, (char*)&queued, &optLen) == -1)
+        queued = 0;
+#endif
+
+    if (queued >= bufSize)
+        return 0;
+    return (UInt32)(bufSize - queued);
+}
+
 
 OS_Error Socket::Bind(UInt32 addr, UInt16 port)
 {
@@ -74,6 +74,12 @@ class Socket : public EventContext
         // Returns an error if the socket buffer size is too big
         OS_Error        SetSocketRcvBufSize(UInt32 inNewSize);
         
+        //
+        // Roughly how many more bytes the kernel will take before a send would
+        // block. Where the amount already queued can't be found out, this is the
+        // whole send buffer size. Returns 0 if the socket isn't open.
+        UInt32          GetSendBufferSpace();
+        
         //Send
         //Returns: QTSS_FileNotOpen, QTSS_NoErr, or POSIX errorcode.
         OS_Error    Send(const char* inData, const UInt32 inLength, UInt32* outLengthSent);
@@ -0,0 +1,226 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       StringLookupTable.cpp
+
+    Contains:   implements StringLookupTable class
+
+
+*/
+
+#include "StringLookupTable.h"
+#include "MyAssert.h"
+
+StringLookupTable::StringLookupTable(StrPtrLen* inStrings, UInt32 inNumStrings, Bool16 inIgnoreCase)
+:   fStrings(inStrings),
+    fNumStrings(inNumStrings),
+    fIgnoreCase(inIgnoreCase),
+    fSeed(0),
+    fMask(0),
+    fSlots(NULL)
+{
+    Assert(inNumStrings < kEmptySlot);
+
+    // Start with a table about 4 times the number of strings, which usually
+    // finds a seed within the first few tries. Grow it if no seed works.
+    UInt32 theTableSize = 16;
+    while (theTableSize < inNumStrings * 4)
+        theTableSize <<= 1;
+
+    for ( ; theTableSize <= kMaxTableSize; theTableSize <<= 1)
+    {
+        for (UInt32 theSeed = 1; theSeed <= kMaxSeedTries; theSeed++)
+        {
+            if (this->Build(theTableSize, theSeed))
+                return;
+        }
+    }
+
+    // Only happens if the array has the same string in it twice. Lookups still
+    // work, they just walk the array.
+    Assert(0);
+}
+
+StringLookupTable::~StringLookupTable()
+{
+    delete [] fSlots;
+}
+
+Bool16 StringLookupTable::Build(UInt32 inTableSize, UInt32 inSeed)
+{
+    // This can run at static init time, before OSMemory is set up, so use plain new
+    if (fSlots == NULL || fMask + 1 != inTableSize)
+    {
+        delete [] fSlots;
+        fSlots = new UInt16[inTableSize];
+    }
+    for (UInt32 x = 0; x < inTableSize; x++)
+        fSlots[x] = kEmptySlot;
+
+    fMask = inTableSize - 1;
+    for (UInt32 theIndex = 0; theIndex < fNumStrings; theIndex++)
+    {
+        UInt32 theSlot = this->Hash(fStrings[theIndex], inSeed) & fMask;
+        if (fSlots[theSlot] != kEmptySlot)
+        {
+            if (inTableSize == kMaxTableSize && inSeed == kMaxSeedTries)
+            {
+                delete [] fSlots;
+                fSlots = NULL;
+            }
+            return false;
+        }
+        fSlots[theSlot] = (UInt16)theIndex;
+    }
+
+    fSeed = inSeed;
+    return true;
+}
+
+UInt32 StringLookupTable::Hash(const StrPtrLen& inString, UInt32 inSeed) const
+{
+    // FNV-1a. When ignoring case, setting bit 5 folds upper case letters onto
+    // lower case ones. It folds a few other characters together as well, but
+    // that only costs an extra compare, never a wrong answer.
+    UInt32 theHash = 2166136261U ^ (inSeed * 16777619U);
+    UInt8 theFold = fIgnoreCase ? 0x20 : 0;
+
+    UInt8* theChar = (UInt8*)inString.Ptr;
+    UInt8* theEnd = theChar + inString.Len;
+    for ( ; theChar < theEnd; theChar++)
+    {
+        theHash ^= (UInt32)(*theChar | theFold);
+        theHash *= 16777619U;
+    }
+    return theHash ^ (theHash >> 16);
+}
+
+UInt32 StringLookupTable::Find(const StrPtrLen& inString) const
+{
+    if (inString.Len == 0)
+        return fNumStrings;
+
+    if (fSlots == NULL)
+    {
+        for (UInt32 theIndex = 0; theIndex < fNumStrings; theIndex++)
+        {
+            if (fIgnoreCase ? fStrings[theIndex].EqualIgnoreCase(inString) : fStrings[theIndex].Equal(inString))
+                return theIndex;
+        }
+        return fNumStrings;
+    }
+
+    UInt16 theIndex = fSlots[this->Hash(inString, fSeed) & fMask];
+    if (theIndex == kEmptySlot)
+        return fNumStrings;
+
+    StrPtrLen& theString = fStrings[theIndex];
+    if (theString.Len != inString.Len)
+        return fNumStrings;
+    if (fIgnoreCase ? theString.EqualIgnoreCase(inString) : theString.Equal(inString))
+        return theIndex;
+    return fNumStrings;
+}
+
+#if STRINGLOOKUPTABLETESTING
+Bool16 StringLookupTable::Test()
+{
+    static StrPtrLen sMethods[] =
+    {
+        StrPtrLen("DESCRIBE"),
+        StrPtrLen("SETUP"),
+        StrPtrLen("TEARDOWN"),
+        StrPtrLen("PLAY"),
+        StrPtrLen("PAUSE"),
+        StrPtrLen("OPTIONS"),
+        StrPtrLen("ANNOUNCE"),
+        StrPtrLen("GET_PARAMETER"),
+        StrPtrLen("SET_PARAMETER"),
+        StrPtrLen("REDIRECT"),
+        StrPtrLen("RECORD")
+    };
+    const UInt32 kNumMethods = sizeof(sMethods) / sizeof(StrPtrLen);
+    
+    StringLookupTable theExact(sMethods, kNumMethods, false);
+    StringLookupTable theIgnoreCase(sMethods, kNumMethods, true);
+    if ((theExact.fSlots == NULL) || (theIgnoreCase.fSlots == NULL))
+        return false;
+        
+    for (UInt32 x = 0; x < kNumMethods; x++)
+    {
+        if (theExact.Find(sMethods[x]) != x)
+            return false;
+        if (theIgnoreCase.Find(sMethods[x]) != x)
+            return false;
+    }
+    
+    StrPtrLen theLower("teardown");
+    if (theExact.Find(theLower) != kNumMethods)
+        return false;
+    if (theIgnoreCase.Find(theLower) != 2)
+        return false;
+        
+    // Same length, prefixes, longer strings and the empty string aren't in the table
+    StrPtrLen theMisses[] = { StrPtrLen("PLAZ"), StrPtrLen("PLA"), StrPtrLen("PLAYS"), StrPtrLen("SET_PARAMETERS"), StrPtrLen("") };
+    for (UInt32 y = 0; y < sizeof(theMisses) / sizeof(StrPtrLen); y++)
+    {
+        if (theExact.Find(theMisses[y]) != kNumMethods)
+            return false;
+        if (theIgnoreCase.Find(theMisses[y]) != kNumMethods)
+            return false;
+    }
+    
+    // The case fold in the hash also puts '@' on '`'. The compare still tells them apart.
+    static StrPtrLen sFolded[] = { StrPtrLen("a@b") };
+    StringLookupTable theFolded(sFolded, 1, true);
+    StrPtrLen theFoldedMiss("A`B");
+    StrPtrLen theFoldedHit("A@B");
+    if ((theFolded.Find(theFoldedMiss) != 1) || (theFolded.Find(theFoldedHit) != 0))
+        return false;
+    
+    // A table big enough to need a few table sizes and seeds
+    const UInt32 kNumBig = 500;
+    static char sBigBuffer[kNumBig][8];
+    static StrPtrLen sBig[kNumBig];
+    for (UInt32 z = 0; z < kNumBig; z++)
+    {
+        ::sprintf(sBigBuffer[z], "h%lu", z);
+        sBig[z].Set(sBigBuffer[z]);
+    }
+    StringLookupTable theBig(sBig, kNumBig, true);
+    if (theBig.fSlots == NULL)
+        return false;
+    for (UInt32 a = 0; a < kNumBig; a++)
+    {
+        if (theBig.Find(sBig[a]) != a)
+            return false;
+    }
+    StrPtrLen theBigMiss("h500");
+    if (theBig.Find(theBigMiss) != kNumBig)
+        return false;
+    
+    return true;
+}
+#endif
@@ -0,0 +1,84 @@
+/*
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * Copyright (c) 1999-2003 Apple Computer, Inc.  All Rights Reserved.
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ *
+ */
+/*
+    File:       StringLookupTable.h
+
+    Contains:   Maps a string to its index in a fixed array of strings, such as the
+                RTSP or HTTP method and header names.
+
+                The table is a perfect hash: when it is built, a hash seed is picked
+                so that no two strings in the array land in the same slot. A lookup
+                is then one pass over the string to hash it and at most one compare.
+
+*/
+
+#ifndef __STRINGLOOKUPTABLE_H__
+#define __STRINGLOOKUPTABLE_H__
+
+#include "OSHeaders.h"
+#include "StrPtrLen.h"
+
+#define STRINGLOOKUPTABLETESTING 0
+
+class StringLookupTable
+{
+    public:
+
+        // inStrings is not copied, so it must outlive the table. If inIgnoreCase
+        // is true, lookups match the way StrPtrLen::EqualIgnoreCase does.
+        //
+        // Tables are usually file statics, so this may run before main. It
+        // doesn't use anything that needs to be initialized first.
+        StringLookupTable(StrPtrLen* inStrings, UInt32 inNumStrings, Bool16 inIgnoreCase);
+        ~StringLookupTable();
+
+        // Returns the index of inString in the array, or inNumStrings if it isn't there.
+        UInt32  Find(const StrPtrLen& inString) const;
+
+#if STRINGLOOKUPTABLETESTING
+        static Bool16   Test();
+#endif
+
+    private:
+
+        enum
+        {
+            kEmptySlot      = 0xFFFF,
+            kMaxSeedTries   = 4096,     // per table size
+            kMaxTableSize   = 65536
+        };
+
+        UInt32  Hash(const StrPtrLen& inString, UInt32 inSeed) const;
+        Bool16  Build(UInt32 inTableSize, UInt32 inSeed);
+
+        StrPtrLen*  fStrings;
+        UInt32      fNumStrings;
+        Bool16      fIgnoreCase;
+        UInt32      fSeed;
+        UInt32      fMask;
+        UInt16*     fSlots;     // NULL if no perfect hash was found, lookups are then linear
+};
+
+#endif // __STRINGLOOKUPTABLE_H__
@@ -31,6 +31,7 @@
     
 */
 
+#include <string.h>
 #include "StringParser.h"
 
 UInt8 StringParser::sNonWordMask[] =
@@ -223,8 +224,9 @@ void StringParser::ConsumeUntil(StrPtrLen* outString, char inStop)
 
     char *originalStartGet = fStartGet;
 
-    while ((fStartGet < fEndGet) && (*fStartGet != inStop))
-        AdvanceMark();
+    // memchr is usually the fastest scan the platform has
+    char* theStop = (char*)::memchr(fStartGet, inStop, fEndGet - fStartGet);
+    this->AdvanceTo(theStop == NULL ? fEndGet : theStop);
         
     if (outString != NULL)
     {
@@ -240,8 +242,19 @@ void StringParser::ConsumeUntil(StrPtrLen* outString, UInt8 *inMask)
         
     char *originalStartGet = fStartGet;
 
-    while ((fStartGet < fEndGet) && (!inMask[*fStartGet]))
-        AdvanceMark();
+    // Scan with a plain pointer, a few bytes per pass, and only
+    // go back over the data for line numbers if we may have crossed a line.
+    UInt8* theStop = (UInt8*)fStartGet;
+    UInt8* theEnd = (UInt8*)fEndGet;
+    while ((theEnd - theStop >= 4) && !inMask[theStop[0]] && !inMask[theStop[1]] && !inMask[theStop[2]] && !inMask[theStop[3]])
+        theStop += 4;
+    while ((theStop < theEnd) && (!inMask[*theStop]))
+        theStop++;
+
+    if (inMask['\r'] && inMask['\n'])
+        fStartGet = (char*)theStop;
+    else
+        this->AdvanceTo((char*)theStop);
 
     if (outString != NULL)
     {
@@ -266,10 +279,7 @@ void StringParser::ConsumeLength(StrPtrLen* spl, SInt32 inLength)
         spl->Len = inLength;
     }
     if (inLength > 0)
-    {
-        for (short i=0; i<inLength; i++)
-            AdvanceMark();
-    }
+        this->AdvanceTo(fStartGet + inLength);
     else
         fStartGet += inLength;  // ***may mess up line number if we back up too much
 }
@@ -415,6 +425,19 @@ void StringParser::AdvanceMark()
     fStartGet++;
 }
 
+void StringParser::AdvanceTo(char* inNewStartGet)
+{
+    Assert((inNewStartGet >= fStartGet) && (inNewStartGet <= fEndGet));
+
+    // Same line counting as AdvanceMark, for a run of characters
+    for (char* theChar = fStartGet; theChar < inNewStartGet; theChar++)
+    {
+        if ((*theChar == '\n') || ((*theChar == '\r') && ((theChar + 1 == fEndGet) || (theChar[1] != '\n'))))
+            fCurLineNumber++;
+    }
+    fStartGet = inNewStartGet;
+}
+
 #if STRINGPARSERTESTING
 Bool16 StringParser::Test()
 {
@@ -429,13 +452,87 @@ Bool16 StringParser::Test()
     if (theInt != 0)
         return false;
     victim.ConsumeWord(&rtsp);
-    if ((rtsp.len != 4) && (strncmp(rtsp.Ptr, "RTSP", 4) != 0))
+    if ((rtsp.Len != 4) || (strncmp(rtsp.Ptr, "RTSP", 4) != 0))
         return false;
         
-    victim.ConsumeWhiteSpace();
+    victim.ConsumeWhitespace();
     theInt = victim.ConsumeInteger();
     if (theInt != 200)
         return false;
+    
+    //
+    // ConsumeUntil(char) finds the stop char with memchr and counts the lines it skips
+    StrPtrLen theToken;
+    victim.ConsumeUntil(&theToken, ':');
+    if ((theToken.Len != 17) || (strncmp(theToken.Ptr, " OK\r\nContent-Type", 17) != 0))
+        return false;
+    if (victim.GetCurrentLineNumber() != 2)
+        return false;
+    
+    // The EOL mask stops on the EOL itself, so no lines go by until it is consumed
+    victim.Expect(':');
+    victim.ConsumeUntil(&theToken, sEOLMask);
+    if ((theToken.Len != 8) || (strncmp(theToken.Ptr, " MeowMix", 8) != 0) || (victim.GetCurrentLineNumber() != 2))
+        return false;
+    if (!victim.ExpectEOL() || (victim.GetCurrentLineNumber() != 3))
+        return false;
+        
+    // The whitespace mask doesn't stop on \r or \n, so the lines it skips are counted
+    victim.ConsumeWhitespace();
+    if ((victim.GetCurrentLineNumber() != 4) || (victim.ConsumeInteger() != 3450))
+        return false;
+        
+    // Running off the end stops at the end
+    victim.ConsumeUntil(&theToken, 'x');
+    if ((theToken.Len != 0) || (victim.GetDataRemaining() != 0))
+        return false;
+    
+    //
+    // The mask scan goes 4 bytes at a time, so try a stop at each offset around that
+    static char* string2 = "abcdefghij";
+    StrPtrLen theLetters(string2, strlen(string2));
+    for (UInt32 theStopOffset = 0; theStopOffset < 10; theStopOffset++)
+    {
+        UInt8 theMask[256];
+        ::memset(theMask, 0, sizeof(theMask));
+        theMask[(UInt8)string2[theStopOffset]] = 1;
+        
+        StringParser theLetterParser(&theLetters);
+        theLetterParser.ConsumeUntil(&theToken, theMask);
+        if ((theToken.Len != theStopOffset) || (theLetterParser.PeekFast() != string2[theStopOffset]))
+            return false;
+    }
+    
+    // High-bit characters index the mask as unsigned bytes. Each EOL form
+    // counts as one line when a mask that doesn't stop on them skips over them.
+    static char* string3 = "caf\xE9\xFF\r\nb\rc\nd 42";
+    StrPtrLen theHighBits(string3, strlen(string3));
+    StringParser theHighBitParser(&theHighBits);
+    theHighBitParser.ConsumeUntilDigit(&theToken);
+    if ((theToken.Len != 13) || (theHighBitParser.GetCurrentLineNumber() != 4) || (theHighBitParser.ConsumeInteger() != 42))
+        return false;
+        
+    //
+    // ConsumeLength moves in one step, counts the lines it skips, and stops at the end
+    StringParser theLengthParser(&theString);
+    theLengthParser.ConsumeLength(&theToken, 13);
+    if ((theToken.Len != 13) || (theLengthParser.GetCurrentLineNumber() != 2))
+        return false;
+    theLengthParser.ConsumeLength(&theToken, 1000);
+    if ((theToken.Len != theString.Len - 13) || (theLengthParser.GetDataRemaining() != 0) || (theLengthParser.GetCurrentLineNumber() != 4))
+        return false;
+        
+    //
+    // Starting at an offset picks up where an earlier parser left off
+    StringParser theOffsetParser(&theString, 13, 2);
+    theOffsetParser.ConsumeWord(&theToken);
+    if ((theToken.Len != 12) || (strncmp(theToken.Ptr, "Content-Type", 12) != 0))
+        return false;
+    if ((theOffsetParser.GetDataParsedLen() != 25) || (theOffsetParser.GetCurrentLineNumber() != 2))
+        return false;
+    theOffsetParser.GetThruEOL(NULL);
+    if (theOffsetParser.GetCurrentLineNumber() != 3)
+        return false;
         
     return true;
 }
@@ -50,6 +50,14 @@ class StringParser
                 fEndGet(inStream == NULL ? NULL : inStream->Ptr + inStream->Len),
                 fCurLineNumber(1),
                 fStream(inStream) {}
+        
+        // Starts parsing inStartOffset bytes into the stream, without looking at the
+        // bytes skipped. The caller says what line the parser is on at that point.
+        StringParser(StrPtrLen *inStream, UInt32 inStartOffset, int inCurLineNumber)
+            :   fStartGet(inStream->Ptr + inStartOffset),
+                fEndGet(inStream->Ptr + inStream->Len),
+                fCurLineNumber(inCurLineNumber),
+                fStream(inStream) { Assert(inStartOffset <= inStream->Len); }
         ~StringParser() {}
         
         // Built-in masks for common stop conditions
@@ -140,6 +148,7 @@ class StringParser
     private:
 
         void        AdvanceMark();
+        void        AdvanceTo(char* inNewStartGet);   // moves fStartGet forward, keeping the line count
         
         //built in masks for some common stop conditions
         static UInt8 sNonWordMask[];
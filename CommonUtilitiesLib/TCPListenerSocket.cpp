@@ -124,6 +124,17 @@ void TCPListenerSocket::ProcessEvent(int /*eventBits*/)
                 continue;
             }
         }
+        
+        StrPtrLen* theRejectResponse = this->GetRejectResponse(ntohl(addr.sin_addr.s_addr));
+        if (theRejectResponse != NULL)
+        {
+            //the socket's send buffer is empty, so this short write won't block
+            (void)::send(osSocket, theRejectResponse->Ptr, theRejectResponse->Len, 0);
+            close(osSocket);
+            this->SetIdleTimer(kTimeBetweenRejectsInMsec);
+            return;//don't modwatch, Run will pick up the listen queue again.
+        }
+        
         if ((theTask = this->GetSessionTask(&theSocket)) == NULL)
             //this should be a disconnect. do an ioctl call?
             close(osSocket);
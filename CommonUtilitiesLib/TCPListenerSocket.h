@@ -62,6 +62,12 @@ class TCPListenerSocket : public TCPSocket, public IdleTask
         //derived object must implement a way of getting tasks & sockets to this object 
         virtual Task*   GetSessionTask(TCPSocket** outSocket) = 0;
         
+        //derived object may turn a new connection away before a session task is made
+        //for it, by returning a canned response to send it. The connection then gets
+        //closed, and the listener stops accepting for a moment, leaving the rest of
+        //the listen queue waiting in the kernel.
+        virtual StrPtrLen*  GetRejectResponse(UInt32 /*inRemoteAddr*/) { return NULL; }
+        
         virtual SInt64  Run();
             
     private:
@@ -69,6 +75,7 @@ class TCPListenerSocket : public TCPSocket, public IdleTask
         enum
         {
             kTimeBetweenAcceptsInMsec = 1000,   //UInt32
+            kTimeBetweenRejectsInMsec = 100,    //UInt32
             kListenQueueLength = 128            //UInt32
         };
 
@@ -41,7 +41,7 @@ unsigned int    Task::sThreadPicker = 0;
 OSMutexRW       TaskThreadPool::sMutexRW;
 
 Task::Task()
-:   fEvents(0), fUseThisThread(NULL), fWriteLock(false), fTimerHeapElem(), fTaskQueueElem()
+:   fEvents(0), fUseThisThread(NULL), fDefaultThread(NULL), fWriteLock(false), fTimerHeapElem(), fTaskQueueElem()
 {
 #if DEBUG
     fInRunCount = 0;
@@ -88,6 +88,11 @@ void Task::Signal(EventFlags events)
             if (TASK_DEBUG) qtss_printf("Task::Signal enque TaskName=%s fUseThisThread=%lu q elem=%lu enclosing=%lu\n", fTaskName, (UInt32) fUseThisThread, (UInt32) &fTaskQueueElem, (UInt32) this);
             fUseThisThread->fTaskQueue.EnQueue(&fTaskQueueElem);
         }
+        else if (fDefaultThread != NULL)
+        {
+            if (TASK_DEBUG) qtss_printf("Task::Signal enque TaskName=%s fDefaultThread=%lu q elem=%lu enclosing=%lu\n", fTaskName, (UInt32) fDefaultThread, (UInt32) &fTaskQueueElem, (UInt32) this);
+            fDefaultThread->fTaskQueue.EnQueue(&fTaskQueueElem);
+        }
         else
         {
             //find a thread to put this task on
@@ -278,6 +283,8 @@ Task* TaskThread::WaitForTask()
 
 TaskThread** TaskThreadPool::sTaskThreadArray = NULL;
 UInt32       TaskThreadPool::sNumTaskThreads = 0;
+TaskThread** TaskThreadPool::sDedicatedThreadArray = NULL;
+UInt32       TaskThreadPool::sNumDedicatedThreads = 0;
 
 Bool16 TaskThreadPool::AddThreads(UInt32 numToAdd)
 {
@@ -293,21 +300,60 @@ Bool16 TaskThreadPool::AddThreads(UInt32 numToAdd)
     return true;
 }
 
+Bool16 TaskThreadPool::AddDedicatedThreads(UInt32 numToAdd)
+{
+    Assert(sDedicatedThreadArray == NULL);
+    if (sDedicatedThreadArray != NULL)
+        return false;
+        
+    sDedicatedThreadArray = new TaskThread*[numToAdd];
+        
+    for (UInt32 x = 0; x < numToAdd; x++)
+    {
+        sDedicatedThreadArray[x] = NEW TaskThread();
+        sDedicatedThreadArray[x]->Start();
+    }
+    sNumDedicatedThreads = numToAdd;
+    return true;
+}
+
+TaskThread* TaskThreadPool::GetDedicatedThread(UInt32 inIndex)
+{
+    if (sNumDedicatedThreads == 0)
+        return NULL;
+    return sDedicatedThreadArray[inIndex % sNumDedicatedThreads];
+}
+
+UInt32 TaskThreadPool::GetNumQueuedTasks()
+{
+    UInt32 theNumTasks = 0;
+    for (UInt32 x = 0; x < sNumTaskThreads; x++)
+        theNumTasks += sTaskThreadArray[x]->fTaskQueue.GetQueue()->GetLength();
+    return theNumTasks;
+}
+
 void TaskThreadPool::RemoveThreads()
 {
     //Tell all the threads to stop
     for (UInt32 x = 0; x < sNumTaskThreads; x++)
         sTaskThreadArray[x]->SendStopRequest();
+    for (UInt32 a = 0; a < sNumDedicatedThreads; a++)
+        sDedicatedThreadArray[a]->SendStopRequest();
 
     //Because any (or all) threads may be blocked on the queue, cycle through
     //all the threads, signalling each one
     for (UInt32 y = 0; y < sNumTaskThreads; y++)
         sTaskThreadArray[y]->fTaskQueue.GetCond()->Signal();
+    for (UInt32 b = 0; b < sNumDedicatedThreads; b++)
+        sDedicatedThreadArray[b]->fTaskQueue.GetCond()->Signal();
     
     //Ok, now wait for the selected threads to terminate, deleting them and removing
     //them from the queue.
     for (UInt32 z = 0; z < sNumTaskThreads; z++)
         delete sTaskThreadArray[z];
+    for (UInt32 c = 0; c < sNumDedicatedThreads; c++)
+        delete sDedicatedThreadArray[c];
     
     sNumTaskThreads = 0;
+    sNumDedicatedThreads = 0;
 }
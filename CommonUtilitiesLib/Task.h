@@ -95,6 +95,14 @@ class Task
         
         //Send an event to this task.
         void                    Signal(EventFlags eventFlags);
+        
+        // SetDefaultThread
+        //
+        // Normally each Signal puts the task on the next thread in the pool. A task
+        // given a default thread always runs on that thread instead (unless ForceSameThread
+        // says otherwise). Use with TaskThreadPool::GetDedicatedThread to keep busy tasks
+        // off the shared threads. Pass NULL to go back to the shared pool.
+        void                    SetDefaultThread(TaskThread* inThread) { fDefaultThread = inThread; }
         void                    GlobalUnlock();     
 
 		char            fTaskName[48];
@@ -135,6 +143,7 @@ class Task
         
         EventFlags      fEvents;
         TaskThread*     fUseThisThread;
+        TaskThread*     fDefaultThread;
         Bool16          fWriteLock;
 
 #if DEBUG
@@ -192,6 +201,19 @@ public:
 
     //Adds some threads to the pool
     static Bool16               AddThreads(UInt32 numToAdd);
+    
+    //Adds threads that tasks are never assigned to round-robin. A task only runs on one
+    //of these if it asks to with Task::SetDefaultThread. Can only be called once.
+    static Bool16               AddDedicatedThreads(UInt32 numToAdd);
+    static UInt32               GetNumDedicatedThreads() { return sNumDedicatedThreads; }
+    
+    //Returns dedicated thread inIndex modulo the number of dedicated threads, or NULL if there aren't any
+    static TaskThread*          GetDedicatedThread(UInt32 inIndex);
+    
+    //Number of signalled tasks waiting for a round-robin thread to pick them up.
+    //Not locked, so it is only a snapshot.
+    static UInt32               GetNumQueuedTasks();
+    
     //returns num actually removed (this call is non-blocking)
     static void RemoveThreads();
     
@@ -199,6 +221,8 @@ private:
 
     static TaskThread**     sTaskThreadArray;
     static UInt32           sNumTaskThreads;
+    static TaskThread**     sDedicatedThreadArray;
+    static UInt32           sNumDedicatedThreads;
     static OSMutexRW        sMutexRW;
     
     friend class Task;
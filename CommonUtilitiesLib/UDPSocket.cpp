@@ -46,18 +46,30 @@
 #include <socketbits.h>
 #endif
 #endif
+
+#if __linux__
+#include <time.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#endif
+#endif
+
+#if __linux__ && defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 14)))
+#define HAVE_SENDMMSG 1
 #endif
 
 #include <errno.h>
 #include "UDPSocket.h"
 #include "OSMemory.h"
+#include "OS.h"
 
 #ifdef USE_NETLOG
 #include <netlog.h>
 #endif
 
 UDPSocket::UDPSocket(Task* inTask, UInt32 inSocketType)
-: Socket(inTask, inSocketType), fDemuxer(NULL)
+: Socket(inTask, inSocketType), fDemuxer(NULL), fTransmitTimeEnabled(false), fSegmentationEnabled(false)
 {
     if (inSocketType & kWantsDemuxer)
         fDemuxer = NEW UDPDemuxer();
@@ -89,6 +101,231 @@ UDPSocket::SendTo(UInt32 inRemoteAddr, UInt16 inRemotePort, void* inBuffer, UInt
     return OS_NoErr;
 }
 
+OS_Error
+UDPSocket::SendToMany(UInt32* inRemoteAddrs, UInt32 inNumAddrs, UInt16 inRemotePort, void* inBuffer, UInt32 inLength)
+{
+    Assert(inRemoteAddrs != NULL);
+    Assert(inBuffer != NULL);
+    
+    OS_Error theErr = OS_NoErr;
+    UInt32 theAddrIndex = 0;
+
+#if HAVE_SENDMMSG
+    struct sockaddr_in  theRemoteAddrs[kMaxSendToMany];
+    struct mmsghdr      theMsgs[kMaxSendToMany];
+    
+    struct iovec theVec;
+    theVec.iov_base = inBuffer;
+    theVec.iov_len = inLength;
+    
+    while (theAddrIndex < inNumAddrs)
+    {
+        UInt32 theCount = inNumAddrs - theAddrIndex;
+        if (theCount > kMaxSendToMany)
+            theCount = kMaxSendToMany;
+        
+        ::memset(theMsgs, 0, theCount * sizeof(struct mmsghdr));
+        for (UInt32 x = 0; x < theCount; x++)
+        {
+            theRemoteAddrs[x].sin_family = AF_INET;
+            theRemoteAddrs[x].sin_port = htons(inRemotePort);
+            theRemoteAddrs[x].sin_addr.s_addr = htonl(inRemoteAddrs[theAddrIndex + x]);
+            
+            theMsgs[x].msg_hdr.msg_name = &theRemoteAddrs[x];
+            theMsgs[x].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            theMsgs[x].msg_hdr.msg_iov = &theVec;
+            theMsgs[x].msg_hdr.msg_iovlen = 1;
+        }
+        
+        //
+        // sendmmsg stops at the first send that fails and returns how many went
+        // out before it, so an error here is always for the first one in this batch.
+        int theNumSent = ::sendmmsg(fFileDesc, theMsgs, theCount, 0);
+        if (theNumSent == -1)
+        {
+            OS_Error theSendErr = (OS_Error)OSThread::GetErrno();
+            if (theSendErr == ENOSYS)
+                break; // kernel is older than the C library, use sendto for the rest
+                
+            if (theErr == OS_NoErr)
+                theErr = theSendErr;
+            theNumSent = 1;
+        }
+        theAddrIndex += theNumSent;
+    }
+#endif
+
+    for ( ; theAddrIndex < inNumAddrs; theAddrIndex++)
+    {
+        OS_Error theSendErr = this->SendTo(inRemoteAddrs[theAddrIndex], inRemotePort, inBuffer, inLength);
+        if (theErr == OS_NoErr)
+            theErr = theSendErr;
+    }
+    return theErr;
+}
+
+OS_Error
+UDPSocket::SendTo(UInt32 inRemoteAddr, UInt16 inRemotePort, void* inBuffer, UInt32 inLength, SInt64 inSendTime)
+{
+    SInt64 theDelay = 0;
+    if (fTransmitTimeEnabled)
+        theDelay = inSendTime - OS::Milliseconds();
+    if (theDelay <= 0)
+        return this->SendTo(inRemoteAddr, inRemotePort, inBuffer, inLength);
+
+#if __linux__ && defined(SO_TXTIME)
+    Assert(inBuffer != NULL);
+    
+    struct sockaddr_in  theRemoteAddr;
+    theRemoteAddr.sin_family = AF_INET;
+    theRemoteAddr.sin_port = htons(inRemotePort);
+    theRemoteAddr.sin_addr.s_addr = htonl(inRemoteAddr);
+
+    // The socket's clock is CLOCK_MONOTONIC, which OS::Milliseconds isn't
+    // based on, so go by how far off the send time is.
+    struct timespec theNow;
+    ::clock_gettime(CLOCK_MONOTONIC, &theNow);
+    UInt64 theTxTime = ((UInt64)theNow.tv_sec * 1000000000) + theNow.tv_nsec + ((UInt64)theDelay * 1000000);
+
+    struct iovec theVec;
+    theVec.iov_base = inBuffer;
+    theVec.iov_len = inLength;
+    
+    char theControl[CMSG_SPACE(sizeof(theTxTime))];
+    ::memset(theControl, 0, sizeof(theControl));
+    
+    struct msghdr theMsg;
+    ::memset(&theMsg, 0, sizeof(theMsg));
+    theMsg.msg_name = &theRemoteAddr;
+    theMsg.msg_namelen = sizeof(theRemoteAddr);
+    theMsg.msg_iov = &theVec;
+    theMsg.msg_iovlen = 1;
+    theMsg.msg_control = theControl;
+    theMsg.msg_controllen = sizeof(theControl);
+    
+    struct cmsghdr* theCmsg = CMSG_FIRSTHDR(&theMsg);
+    theCmsg->cmsg_level = SOL_SOCKET;
+    theCmsg->cmsg_type = SCM_TXTIME;
+    theCmsg->cmsg_len = CMSG_LEN(sizeof(theTxTime));
+    ::memcpy(CMSG_DATA(theCmsg), &theTxTime, sizeof(theTxTime));
+
+    if (::sendmsg(fFileDesc, &theMsg, 0) == -1)
+        return (OS_Error)OSThread::GetErrno();
+    return OS_NoErr;
+#else
+    return this->SendTo(inRemoteAddr, inRemotePort, inBuffer, inLength);
+#endif
+}
+
+OS_Error UDPSocket::EnableTransmitTime()
+{
+#if __linux__ && defined(SO_TXTIME)
+    struct sock_txtime theTxTime;
+    theTxTime.clockid = CLOCK_MONOTONIC;
+    theTxTime.flags = 0;
+    if (::setsockopt(fFileDesc, SOL_SOCKET, SO_TXTIME, (char*)&theTxTime, sizeof(theTxTime)) == -1)
+        return (OS_Error)OSThread::GetErrno();
+    fTransmitTimeEnabled = true;
+    return OS_NoErr;
+#else
+    return (OS_Error)EINVAL;
+#endif
+}
+
+OS_Error
+UDPSocket::SendSegmentsTo(UInt32 inRemoteAddr, UInt16 inRemotePort, void* inBuffer, UInt32 inLength, UInt16 inSegmentSize,
+                            Bool16* outSegmented)
+{
+    Assert(inBuffer != NULL);
+    Assert(inSegmentSize > 0);
+    
+    if (outSegmented != NULL)
+        *outSegmented = false;
+    
+    if (inLength <= inSegmentSize)
+        return this->SendTo(inRemoteAddr, inRemotePort, inBuffer, inLength);
+
+#if __linux__ && defined(UDP_SEGMENT)
+    if (fSegmentationEnabled && (inLength <= kMaxSegmentedSize))
+    {
+        struct sockaddr_in  theRemoteAddr;
+        theRemoteAddr.sin_family = AF_INET;
+        theRemoteAddr.sin_port = htons(inRemotePort);
+        theRemoteAddr.sin_addr.s_addr = htonl(inRemoteAddr);
+
+        struct iovec theVec;
+        theVec.iov_base = inBuffer;
+        theVec.iov_len = inLength;
+        
+        char theControl[CMSG_SPACE(sizeof(inSegmentSize))];
+        ::memset(theControl, 0, sizeof(theControl));
+        
+        struct msghdr theMsg;
+        ::memset(&theMsg, 0, sizeof(theMsg));
+        theMsg.msg_name = &theRemoteAddr;
+        theMsg.msg_namelen = sizeof(theRemoteAddr);
+        theMsg.msg_iov = &theVec;
+        theMsg.msg_iovlen = 1;
+        theMsg.msg_control = theControl;
+        theMsg.msg_controllen = sizeof(theControl);
+        
+        struct cmsghdr* theCmsg = CMSG_FIRSTHDR(&theMsg);
+        theCmsg->cmsg_level = IPPROTO_UDP;
+        theCmsg->cmsg_type = UDP_SEGMENT;
+        theCmsg->cmsg_len = CMSG_LEN(sizeof(inSegmentSize));
+        ::memcpy(CMSG_DATA(theCmsg), &inSegmentSize, sizeof(inSegmentSize));
+
+        if (::sendmsg(fFileDesc, &theMsg, 0) != -1)
+        {
+            if (outSegmented != NULL)
+                *outSegmented = true;
+            return OS_NoErr;
+        }
+        
+        //
+        // EINVAL means this send didn't fit the route's MTU, so just send these
+        // one at a time. If the device can't take segmented sends at all (EIO
+        // comes back when it has no checksum offload), stop trying on this socket.
+        OS_Error theErr = (OS_Error)OSThread::GetErrno();
+        if ((theErr == EIO) || (theErr == ENOPROTOOPT))
+            fSegmentationEnabled = false;
+        else if (theErr != EINVAL)
+            return theErr;
+    }
+#endif
+
+    OS_Error theErr = OS_NoErr;
+    char* theSegment = (char*)inBuffer;
+    char* theEnd = theSegment + inLength;
+    for ( ; theSegment < theEnd; theSegment += inSegmentSize)
+    {
+        UInt32 theLen = inSegmentSize;
+        if (theLen > (UInt32)(theEnd - theSegment))
+            theLen = (UInt32)(theEnd - theSegment);
+        
+        OS_Error theSendErr = this->SendTo(inRemoteAddr, inRemotePort, theSegment, theLen);
+        if (theErr == OS_NoErr)
+            theErr = theSendErr;
+    }
+    return theErr;
+}
+
+OS_Error UDPSocket::EnableSegmentation()
+{
+#if __linux__ && defined(UDP_SEGMENT)
+    //
+    // Older kernels don't know the option at all
+    int theSegmentSize = 0;
+    socklen_t theLen = sizeof(theSegmentSize);
+    if (::getsockopt(fFileDesc, IPPROTO_UDP, UDP_SEGMENT, (char*)&theSegmentSize, &theLen) == -1)
+        return (OS_Error)OSThread::GetErrno();
+    fSegmentationEnabled = true;
+    return OS_NoErr;
+#else
+    return (OS_Error)EINVAL;
+#endif
+}
+
 OS_Error UDPSocket::RecvFrom(UInt32* outRemoteAddr, UInt16* outRemotePort,
                             void* ioBuffer, UInt32 inBufLen, UInt32* outRecvLen)
 {
@@ -70,6 +70,44 @@ class   UDPSocket : public Socket
         //returns an ERRNO
         OS_Error        SendTo(UInt32 inRemoteAddr, UInt16 inRemotePort,
                                     void* inBuffer, UInt32 inLength);
+        
+        //Sends the same packet to each of inNumAddrs addresses. On Linux this is one
+        //sendmmsg per kMaxSendToMany addresses, elsewhere one SendTo per address.
+        //Returns the first ERRNO hit; a failed send doesn't stop the others.
+        OS_Error        SendToMany(UInt32* inRemoteAddrs, UInt32 inNumAddrs, UInt16 inRemotePort,
+                                    void* inBuffer, UInt32 inLength);
+        
+        //Same, but the packet isn't to leave the host before inSendTime (an OS::Milliseconds
+        //time). Unless transmit times are enabled on this socket, it goes right away.
+        OS_Error        SendTo(UInt32 inRemoteAddr, UInt16 inRemotePort,
+                                    void* inBuffer, UInt32 inLength, SInt64 inSendTime);
+        
+        //Lets the kernel hold packets until their send time (SO_TXTIME on Linux; the fq
+        //qdisc on the outgoing interface does the holding). Returns an error where unsupported.
+        OS_Error        EnableTransmitTime();
+        Bool16          IsTransmitTimeEnabled() { return fTransmitTimeEnabled; }
+        
+        //Sends inBuffer as a run of datagrams inSegmentSize bytes long (the last one
+        //may be shorter) in one call, letting the kernel or the NIC split it up
+        //(UDP_SEGMENT on Linux). Where segmentation is off or fails, or inLength is
+        //over kMaxSegmentedSize, each datagram goes out with its own SendTo. Returns
+        //the first ERRNO hit. If outSegmented is passed in, it is set to whether the
+        //datagrams went out in one segmented send.
+        OS_Error        SendSegmentsTo(UInt32 inRemoteAddr, UInt16 inRemotePort,
+                                    void* inBuffer, UInt32 inLength, UInt16 inSegmentSize,
+                                    Bool16* outSegmented = NULL);
+        
+        //Returns an error if the kernel can't segment UDP sends on this socket.
+        OS_Error        EnableSegmentation();
+        Bool16          IsSegmentationEnabled() { return fSegmentationEnabled; }
+        
+        enum
+        {
+            kMaxSegments        = 64,           //the kernel's limit per send
+            kMaxSegmentSize     = 1472,         //segments can't be IP fragmented, so keep them to an ethernet MTU
+            kMaxSegmentedSize   = 65000,        //a segmented send is still one UDP datagram to the kernel
+            kMaxSendToMany      = 32            //addresses per sendmmsg in SendToMany
+        };
                         
         OS_Error        RecvFrom(UInt32* outRemoteAddr, UInt16* outRemotePort,
                                         void* ioBuffer, UInt32 inBufLen, UInt32* outRecvLen);
@@ -83,6 +121,8 @@ class   UDPSocket : public Socket
     
         UDPDemuxer* fDemuxer;
         struct sockaddr_in  fMsgAddr;
+        Bool16      fTransmitTimeEnabled;
+        Bool16      fSegmentationEnabled;
 };
 #endif // __UDPSOCKET_H__
 
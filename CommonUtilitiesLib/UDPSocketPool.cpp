@@ -47,10 +47,13 @@ UDPSocketPair* UDPSocketPool::GetUDPSocketPair(UInt32 inIPAddr, UInt16 inPort,
                 ((inPort == 0) || (theElem->fSocketA->GetLocalPort() == inPort)))
             {
                 //check to make sure this source IP & port is not already in the demuxer.
-                //If not, we can return this socket pair.
-                if ((theElem->fSocketB->GetDemuxer() == NULL) ||
+                //If not, we can return this socket pair. Streams multiplexing RTP and
+                //RTCP on one port register with socket A's demuxer, so check that too.
+                if (((theElem->fSocketA->GetDemuxer() == NULL) ||
+                    (!theElem->fSocketA->GetDemuxer()->AddrInMap(inSrcIPAddr, inSrcPort))) &&
+                    ((theElem->fSocketB->GetDemuxer() == NULL) ||
                     ((!theElem->fSocketB->GetDemuxer()->AddrInMap(0, 0)) &&
-                    (!theElem->fSocketB->GetDemuxer()->AddrInMap(inSrcIPAddr, inSrcPort))))
+                    (!theElem->fSocketB->GetDemuxer()->AddrInMap(inSrcIPAddr, inSrcPort)))))
                 {
                     theElem->fRefCount++;
                     return theElem;
@@ -36,32 +36,13 @@ StrPtrLen HTTPProtocol::sMethods[] =
     StrPtrLen("CONNECT"),
 };
 
+// Tables are built at static init time, so each has to come after the array it indexes.
+// Methods are case sensitive, headers are not.
+StringLookupTable HTTPProtocol::sMethodTable(HTTPProtocol::sMethods, httpNumMethods, false);
+
 HTTPMethod HTTPProtocol::GetMethod(const StrPtrLen* inMethodStr)
 {
-    HTTPMethod theMethod = httpIllegalMethod;
-
-    if (inMethodStr->Len == 0)
-            return httpIllegalMethod;
-
-    switch((inMethodStr->Ptr)[0])
-        {
-        case 'G':       theMethod = httpGetMethod; break;
-        case 'H':       theMethod = httpHeadMethod; break;
-        case 'P':       theMethod = httpPostMethod; break;  // Most likely POST and not PUT
-        case 'O':       theMethod = httpOptionsMethod; break;
-        case 'D':       theMethod = httpDeleteMethod; break;
-        case 'T':       theMethod = httpTraceMethod; break;
-        case 'C':       theMethod = httpConnectMethod; break;
-        }
-
-    if ( (theMethod != httpIllegalMethod) && (inMethodStr->Equal(sMethods[theMethod])) )
-            return theMethod;
-
-    // Check for remaining methods (Only PUT method is left)
-    if ( inMethodStr->Equal(sMethods[httpPutMethod]) )
-            return httpPutMethod;
-
-    return httpIllegalMethod;
+    return sMethodTable.Find(*inMethodStr);
 }
 
 StrPtrLen HTTPProtocol::sHeaders[] =
@@ -124,38 +105,11 @@ StrPtrLen HTTPProtocol::sHeaders[] =
     StrPtrLen(" ,")
 };
 
+StringLookupTable HTTPProtocol::sHeaderTable(HTTPProtocol::sHeaders, httpNumHeaders, true);
+
 HTTPHeader HTTPProtocol::GetHeader(const StrPtrLen* inHeaderStr)
 {
-    if (inHeaderStr->Len == 0)
-            return httpIllegalHeader;
-
-    HTTPHeader theHeader = httpIllegalHeader;
-
-    //chances are this is one of our selected "VIP" headers. so check for this.
-    switch((inHeaderStr->Ptr)[0])
-        {
-        case 'C':       case 'c':       theHeader = httpConnectionHeader; break;
-        case 'S':       case 's':       theHeader = httpServerHeader; break;
-        case 'D':       case 'd':       theHeader = httpDateHeader; break;
-        case 'A':       case 'a':       theHeader = httpAuthorizationHeader; break;
-        case 'W':       case 'w':       theHeader = httpWWWAuthenticateHeader; break;
-        case 'I':       case 'i':       theHeader = httpIfModifiedSinceHeader; break;
-        case 'E':       case 'e':       theHeader = httpExpiresHeader; break;
-        case 'L':       case 'l':       theHeader = httpLastModifiedHeader; break;
-        // Added this to optimize for HTTP tunnelling in the server (Not really a VIP header)
-        case 'X':       case 'x':       theHeader = httpSessionCookieHeader; break;
-        }
-
-    if ((theHeader != httpIllegalHeader) && 
-            (inHeaderStr->EqualIgnoreCase(sHeaders[theHeader].Ptr, sHeaders[theHeader].Len)))
-            return theHeader;
-
-    //If this isn't one of our VIP headers, go through the remaining request headers, trying
-    //to find the right one.
-    for (SInt32 x = httpNumVIPHeaders; x < httpNumHeaders; x++)
-            if (inHeaderStr->EqualIgnoreCase(sHeaders[x].Ptr, sHeaders[x].Len))
-                return x;
-    return httpIllegalHeader;
+    return sHeaderTable.Find(*inHeaderStr);
 }
 
 StrPtrLen HTTPProtocol::sStatusCodeStrings[] =
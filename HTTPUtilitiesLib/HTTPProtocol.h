@@ -27,6 +27,7 @@
 
 #include "OSHeaders.h"
 #include "StrPtrLen.h"
+#include "StringLookupTable.h"
 
 // Versions
 enum
@@ -196,6 +197,8 @@ public:
 private:
     static StrPtrLen                        sMethods[];
     static StrPtrLen                        sHeaders[];
+    static StringLookupTable                sMethodTable;
+    static StringLookupTable                sHeaderTable;
     static StrPtrLen                        sStatusCodeStrings[];
     static StrPtrLen                        sStatusCodeAsStrings[];
     static SInt32                           sStatusCodes[];
@@ -34,6 +34,15 @@
 #include <string.h>
 #include "OSMemory.h"
 
+// The thread cache sits under the non-debugging New and Delete. It needs pthread
+// keys and a mutex that works before any constructors run, so it's POSIX only.
+#if MEMORY_THREAD_CACHE && !MEMORY_DEBUGGING && !defined(__Win32__)
+#define USE_THREAD_CACHE 1
+#include <pthread.h>
+#else
+#define USE_THREAD_CACHE 0
+#endif
+
 #if MEMORY_DEBUGGING
 
 OSQueue OSMemory::sMemoryQueue;
@@ -90,10 +99,284 @@ void OSMemory::SetMemoryError(SInt32 inErr)
     sMemoryErr = inErr;
 }
 
+#if USE_THREAD_CACHE
+
+//
+// THREAD CACHE
+//
+// Every block carries a small header saying which size class it belongs to. A freed
+// small block goes on the freeing thread's list for its class, and the next
+// allocation of that class on that thread takes it straight back off. When a
+// thread's list gets long, half of it moves to a shared depot, and threads that
+// run dry refill from the depot before going to malloc. The depot itself is capped;
+// blocks past the cap go back to malloc so an idle server doesn't hold on to a peak's
+// worth of memory.
+
+enum
+{
+    kLargeBlock         = OSMemory::kNumSizeClasses,    // size class for blocks malloc'd directly
+    kMaxSmallSize       = 4096,
+    kBatchSize          = 32,                           // blocks moved to or from the depot at once
+    kMaxThreadBlocks    = 2 * kBatchSize,               // per class, per thread
+    kMaxDepotBytes      = 1024 * 1024                   // per class
+};
+
+static const UInt32 sClassSizes[OSMemory::kNumSizeClasses] =
+    { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096 };
+
+// Keeps the returned memory as aligned as malloc's
+struct BlockHeader
+{
+    UInt32  fSizeClass;
+    UInt32  fSize;          // only used for large blocks
+    UInt32  fPad[2];
+};
+
+// A free block is linked through its first word
+struct FreeBlock
+{
+    FreeBlock*  fNext;
+};
+
+struct ThreadCache
+{
+    FreeBlock*      fFree[OSMemory::kNumSizeClasses];
+    UInt32          fNumFree[OSMemory::kNumSizeClasses];
+    UInt64          fBytesAllocated[OSMemory::kNumSizeClasses + 1];
+    UInt64          fBytesFreed[OSMemory::kNumSizeClasses + 1];
+    UInt64          fHits;
+    UInt64          fMisses;
+    ThreadCache*    fNextCache;
+};
+
+static pthread_once_t   sCacheOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t    sCacheKey;
+static pthread_mutex_t  sDepotMutex = PTHREAD_MUTEX_INITIALIZER;    // protects everything below
+static FreeBlock*       sDepotFree[OSMemory::kNumSizeClasses];
+static UInt32           sDepotNumFree[OSMemory::kNumSizeClasses];
+static ThreadCache*     sCacheList = NULL;
+static UInt64           sExitedBytesAllocated[OSMemory::kNumSizeClasses + 1];
+static UInt64           sExitedBytesFreed[OSMemory::kNumSizeClasses + 1];
+static UInt8            sClassForSize[(kMaxSmallSize / 16) + 1];    // indexed by (size + 15) / 16
+
+static void ReleaseThreadCache(void* inCache);
+
+static void InitThreadCache()
+{
+    UInt32 theClass = 0;
+    for (UInt32 x = 0; x <= kMaxSmallSize / 16; x++)
+    {
+        while (sClassSizes[theClass] < x * 16)
+            theClass++;
+        sClassForSize[x] = (UInt8)theClass;
+    }
+    (void)pthread_key_create(&sCacheKey, ReleaseThreadCache);
+}
+
+static ThreadCache* GetThreadCache()
+{
+    (void)pthread_once(&sCacheOnce, InitThreadCache);
+    ThreadCache* theCache = (ThreadCache*)pthread_getspecific(sCacheKey);
+    if (theCache != NULL)
+        return theCache;
+        
+    theCache = (ThreadCache*)malloc(sizeof(ThreadCache));
+    if (theCache == NULL)
+        ::exit(sMemoryErr);
+    ::memset(theCache, 0, sizeof(ThreadCache));
+    (void)pthread_setspecific(sCacheKey, theCache);
+
+    pthread_mutex_lock(&sDepotMutex);
+    theCache->fNextCache = sCacheList;
+    sCacheList = theCache;
+    pthread_mutex_unlock(&sDepotMutex);
+    return theCache;
+}
+
+// Moves up to inNumBlocks blocks of one class from the thread's list to the depot.
+// Must be called with sDepotMutex held.
+static void MoveToDepot(ThreadCache* inCache, UInt32 inClass, UInt32 inNumBlocks)
+{
+    while ((inNumBlocks-- > 0) && (inCache->fFree[inClass] != NULL))
+    {
+        FreeBlock* theBlock = inCache->fFree[inClass];
+        inCache->fFree[inClass] = theBlock->fNext;
+        inCache->fNumFree[inClass]--;
+        
+        if ((sDepotNumFree[inClass] + 1) * sClassSizes[inClass] > kMaxDepotBytes)
+            free(((BlockHeader*)theBlock) - 1);
+        else
+        {
+            theBlock->fNext = sDepotFree[inClass];
+            sDepotFree[inClass] = theBlock;
+            sDepotNumFree[inClass]++;
+        }
+    }
+}
+
+// Called by pthreads when a thread exits
+static void ReleaseThreadCache(void* inCache)
+{
+    ThreadCache* theCache = (ThreadCache*)inCache;
+    pthread_mutex_lock(&sDepotMutex);
+    
+    for (UInt32 theClass = 0; theClass < OSMemory::kNumSizeClasses; theClass++)
+        MoveToDepot(theCache, theClass, theCache->fNumFree[theClass]);
+        
+    for (UInt32 x = 0; x <= OSMemory::kNumSizeClasses; x++)
+    {
+        sExitedBytesAllocated[x] += theCache->fBytesAllocated[x];
+        sExitedBytesFreed[x] += theCache->fBytesFreed[x];
+    }
+    
+    for (ThreadCache** theLink = &sCacheList; *theLink != NULL; theLink = &(*theLink)->fNextCache)
+    {
+        if (*theLink == theCache)
+        {
+            *theLink = theCache->fNextCache;
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock(&sDepotMutex);
+    free(theCache);
+}
+
+static void* ThreadCacheNew(size_t inSize)
+{
+    ThreadCache* theCache = GetThreadCache();
+    BlockHeader* theHeader = NULL;
+    
+    if (inSize > kMaxSmallSize)
+    {
+        theHeader = (BlockHeader*)malloc(inSize + sizeof(BlockHeader));
+        if (theHeader == NULL)
+            ::exit(sMemoryErr);
+        theHeader->fSizeClass = kLargeBlock;
+        theHeader->fSize = inSize;
+        theCache->fBytesAllocated[kLargeBlock] += inSize;
+        return theHeader + 1;
+    }
+    
+    UInt32 theClass = sClassForSize[(inSize + 15) >> 4];
+    if (theCache->fFree[theClass] != NULL)
+        theCache->fHits++;
+    else
+    {
+        theCache->fMisses++;
+        
+        // Refill from the depot
+        pthread_mutex_lock(&sDepotMutex);
+        for (UInt32 x = 0; (x < kBatchSize) && (sDepotFree[theClass] != NULL); x++)
+        {
+            FreeBlock* theBlock = sDepotFree[theClass];
+            sDepotFree[theClass] = theBlock->fNext;
+            sDepotNumFree[theClass]--;
+            theBlock->fNext = theCache->fFree[theClass];
+            theCache->fFree[theClass] = theBlock;
+            theCache->fNumFree[theClass]++;
+        }
+        pthread_mutex_unlock(&sDepotMutex);
+    }
+    
+    FreeBlock* theBlock = theCache->fFree[theClass];
+    if (theBlock != NULL)
+    {
+        theCache->fFree[theClass] = theBlock->fNext;
+        theCache->fNumFree[theClass]--;
+        theHeader = ((BlockHeader*)theBlock) - 1;
+    }
+    else
+    {
+        theHeader = (BlockHeader*)malloc(sClassSizes[theClass] + sizeof(BlockHeader));
+        if (theHeader == NULL)
+            ::exit(sMemoryErr);
+        theHeader->fSizeClass = theClass;
+    }
+    
+    theCache->fBytesAllocated[theClass] += sClassSizes[theClass];
+    return theHeader + 1;
+}
+
+static void ThreadCacheDelete(void* inMemory)
+{
+    ThreadCache* theCache = GetThreadCache();
+    BlockHeader* theHeader = ((BlockHeader*)inMemory) - 1;
+    UInt32 theClass = theHeader->fSizeClass;
+    
+    if (theClass == kLargeBlock)
+    {
+        theCache->fBytesFreed[kLargeBlock] += theHeader->fSize;
+        free(theHeader);
+        return;
+    }
+    
+    Assert(theClass < OSMemory::kNumSizeClasses);
+    theCache->fBytesFreed[theClass] += sClassSizes[theClass];
+    
+    FreeBlock* theBlock = (FreeBlock*)inMemory;
+    theBlock->fNext = theCache->fFree[theClass];
+    theCache->fFree[theClass] = theBlock;
+    theCache->fNumFree[theClass]++;
+    
+    // Blocks freed on a different thread than they were allocated on would pile up
+    // here, so hand half of them to the depot for other threads to use.
+    if (theCache->fNumFree[theClass] > kMaxThreadBlocks)
+    {
+        pthread_mutex_lock(&sDepotMutex);
+        MoveToDepot(theCache, theClass, kBatchSize);
+        pthread_mutex_unlock(&sDepotMutex);
+    }
+}
+
+#endif //USE_THREAD_CACHE
+
+UInt32 OSMemory::GetSizeClassSize(UInt32 inClass)
+{
+#if USE_THREAD_CACHE
+    Assert(inClass < kNumSizeClasses);
+    return sClassSizes[inClass];
+#else
+    return 0;
+#endif
+}
+
+void OSMemory::GetThreadCacheStats(UInt64* outBytesInUse, Float32* outHitPercent, UInt32* ioNumThreads)
+{
+#if USE_THREAD_CACHE
+    // The per-thread counters are read without stopping their threads, so
+    // the totals are only as good as a snapshot can be.
+    pthread_mutex_lock(&sDepotMutex);
+    for (UInt32 x = 0; x <= kNumSizeClasses; x++)
+        outBytesInUse[x] = sExitedBytesAllocated[x] - sExitedBytesFreed[x];
+        
+    UInt32 theNumThreads = 0;
+    for (ThreadCache* theCache = sCacheList; theCache != NULL; theCache = theCache->fNextCache)
+    {
+        for (UInt32 y = 0; y <= kNumSizeClasses; y++)
+            outBytesInUse[y] += theCache->fBytesAllocated[y] - theCache->fBytesFreed[y];
+            
+        if (theNumThreads < *ioNumThreads)
+        {
+            UInt64 theTotal = theCache->fHits + theCache->fMisses;
+            outHitPercent[theNumThreads++] = (theTotal == 0) ? 0 : (Float32)((theCache->fHits * 100.0) / theTotal);
+        }
+    }
+    pthread_mutex_unlock(&sDepotMutex);
+    *ioNumThreads = theNumThreads;
+#else
+    for (UInt32 x = 0; x <= kNumSizeClasses; x++)
+        outBytesInUse[x] = 0;
+    *ioNumThreads = 0;
+#endif
+}
+
 void*   OSMemory::New(size_t inSize)
 {
 #if MEMORY_DEBUGGING
     return OSMemory::DebugNew(inSize, __FILE__, __LINE__, false);
+#elif USE_THREAD_CACHE
+    return ThreadCacheNew(inSize);
 #else
     void *m = malloc(inSize);
     if (m == NULL)
@@ -108,6 +391,8 @@ void    OSMemory::Delete(void* inMemory)
         return;
 #if MEMORY_DEBUGGING
     OSMemory::DebugDelete(inMemory);
+#elif USE_THREAD_CACHE
+    ThreadCacheDelete(inMemory);
 #else
     free(inMemory);
 #endif
@@ -27,6 +27,7 @@
 #define DEBUG 0
 #define ASSERT 1
 #define MEMORY_DEBUGGING  0 //enable this to turn on really fancy debugging of memory leaks, etc...
+#define MEMORY_THREAD_CACHE 0 //enable this to have OSMemory keep per-thread caches of small blocks (POSIX only)
 #define QTFILE_MEMORY_DEBUGGING 0
 
 #if __MacOSX__
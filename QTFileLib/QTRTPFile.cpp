@@ -818,6 +818,43 @@ void QTRTPFile::SetTrackRTPMetaInfo(UInt32 TrackID, RTPMetaInfoPacket::FieldID*
     fDropRepeatPackets = false; //force repeat packets on meta info connections.
 }
 
+// -------------------------------------
+// Track continuation, for switching to another file mid-stream
+UInt32 QTRTPFile::GetTrackTimestampOffset(UInt32 TrackID)
+{
+    // General vars
+    RTPTrackListEntry   *trackEntry;
+    
+    
+    //
+    // Find this track.
+    if( !this->FindTrackEntry(TrackID, &trackEntry) )
+        return 0;
+    
+    return trackEntry->BaseTimestampRandomOffset + trackEntry->FileTimestampRandomOffset;
+}
+
+void QTRTPFile::SetTrackContinuation(UInt32 TrackID, UInt16 inNextSeqNum, UInt32 inTimestampOffset)
+{
+    // General vars
+    RTPTrackListEntry   *trackEntry;
+    
+    
+    //
+    // Find this track.
+    if( !this->FindTrackEntry(TrackID, &trackEntry) )
+        return;
+    
+    //
+    // The offsets in the file itself can't be changed, so pick base offsets
+    // that add up to what we want. The first packet after a seek gets
+    // LastSequenceNumber + 1, plus the offsets.
+    trackEntry->BaseSequenceNumberRandomOffset = (UInt16)(inNextSeqNum - 1 - trackEntry->FileSequenceNumberRandomOffset);
+    trackEntry->BaseTimestampRandomOffset = inTimestampOffset - trackEntry->FileTimestampRandomOffset;
+    trackEntry->LastSequenceNumber = 0;
+    trackEntry->SequenceNumberAdditive = 0;
+}
+
 // -------------------------------------
 //  BytesPerSecond
 UInt32 QTRTPFile::GetBytesPerSecond(void)
@@ -1212,6 +1249,29 @@ Float64 QTRTPFile::GetFirstPacketTransmitTime()
     return firstPacketTime;
 }
 
+Bool16 QTRTPFile::IsLastPacketSyncSampleStart(Float64* outSampleTime)
+{
+    // General vars
+    RTPTrackListEntry   *trackEntry = fLastPacketTrack;
+    UInt32              sampleMediaTime;
+    
+    
+    if( (trackEntry == NULL) || (trackEntry->CurPacketNumber != 1) )
+        return false;
+        
+    if( !trackEntry->HintTrack->IsSyncSample(trackEntry->CurSampleNumber, 0) )
+        return false;
+        
+    //
+    // Figure out what time this sample is at, the same way Seek does.
+    if( !trackEntry->HintTrack->GetSampleMediaTime(trackEntry->CurSampleNumber, &sampleMediaTime, &trackEntry->HTCB->fsttsSTCB) )
+        return false;
+        
+    sampleMediaTime += trackEntry->HintTrack->GetFirstEditMediaTime();
+    *outSampleTime = (Float64)sampleMediaTime * trackEntry->HintTrack->GetTimeScaleRecip();
+    return true;
+}
+
 UInt16 QTRTPFile::GetNextTrackSequenceNumber(UInt32 trackID)
 {
     // General vars
@@ -209,6 +209,15 @@ public:
             };
             
             void SetTrackQualityLevel(RTPTrackListEntry* inEntry, UInt32 inNewLevel);
+
+            //
+            // For switching a client between copies of a movie encoded at different
+            // bitrates. GetTrackTimestampOffset returns what this file adds to the
+            // track's RTP timestamps. SetTrackContinuation makes the track's packets,
+            // starting with the next Seek, carry on from inNextSeqNum and use
+            // inTimestampOffset, so the client sees the same stream.
+            UInt32      GetTrackTimestampOffset(UInt32 TrackID);
+            void        SetTrackContinuation(UInt32 TrackID, UInt16 inNextSeqNum, UInt32 inTimestampOffset);
     //
     // Packet functions
             ErrorCode   Seek(Float64 Time, Float64 MaxBackupTime = 3.0);
@@ -219,6 +228,11 @@ public:
             Float64     GetActualSeekTime()     { return fSeekTime; }
             Float64     GetFirstPacketTransmitTime();
             RTPTrackListEntry* GetLastPacketTrack() { return fLastPacketTrack; }
+            
+            //
+            // Returns true if the packet last returned by GetNextPacket is the first
+            // packet of a sync sample, along with the time of that sample in the movie.
+            Bool16      IsLastPacketSyncSampleStart(Float64* outSampleTime);
             UInt32      GetNumSkippedSamples() { return fNumSkippedSamples; }
                         
             UInt16      GetNextTrackSequenceNumber(UInt32 TrackID);
@@ -94,6 +94,32 @@ Bool16 RTCPReceiverPacket::ParseReceiverReport(UInt8* inPacketBuffer, UInt32 inP
     return true;
 }
 
+void RTCPReceiverPacket::GetCumulativeStats(UInt32* outFractionLostPackets, UInt32* outTotalLostPackets, UInt32* outJitter)
+{
+    float avgFractionLost = 0;
+    float avgJitter = 0;
+    UInt32 totalLostPackets = 0;
+    
+    int theReportCount = this->GetReportCount();
+    for (short i = 0; i < theReportCount; i++)
+    {
+        UInt8* theReport = fRTCPReceiverReportArray + this->RecordOffset(i);
+        UInt32 theLossInfo = ntohl(*(UInt32*)&theReport[kFractionLostOffset]);
+        
+        avgFractionLost += (UInt8)((theLossInfo & kFractionLostMask) >> kFractionLostShift);
+        avgFractionLost /= (i+1);
+        
+        avgJitter += ntohl(*(UInt32*)&theReport[kJitterOffset]);
+        avgJitter /= (i + 1);
+        
+        totalLostPackets += theLossInfo & kTotalLostPacketsMask;
+    }
+    
+    *outFractionLostPackets = (UInt32)avgFractionLost;
+    *outTotalLostPackets = totalLostPackets;
+    *outJitter = (UInt32)avgJitter;
+}
+
 UInt32 RTCPReceiverPacket::GetCumulativeFractionLostPackets()
 {
     float avgFractionLost = 0;
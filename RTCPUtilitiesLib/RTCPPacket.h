@@ -149,6 +149,9 @@ public:
     UInt32 GetCumulativeFractionLostPackets();
     UInt32 GetCumulativeTotalLostPackets();
     UInt32 GetCumulativeJitter();
+    
+    // All three of the above in one pass over the report blocks
+    void GetCumulativeStats(UInt32* outFractionLostPackets, UInt32* outTotalLostPackets, UInt32* outJitter);
 
     Bool16 IsValidPacket();
     
@@ -57,6 +57,7 @@ ClientSession::ClientSession(   UInt32 inAddr, UInt16 inPort, char* inURL,
     fClient(NULL),
     fTimeoutTask(this, kIdleTimeoutInMsec),
 
+    fRTCPMux(inClientType == kRTSPRTCPMuxClientType),
     fDurationInSec(inDurationInSec - inStartPlayTimeInSec),
     fStartPlayTimeInSec(inStartPlayTimeInSec),
     fRTCPIntervalInSec(inRTCPIntervalInSec),
@@ -92,6 +93,7 @@ ClientSession::ClientSession(   UInt32 inAddr, UInt16 inPort, char* inURL,
     switch (inClientType)
     {
         case kRTSPUDPClientType:
+        case kRTSPRTCPMuxClientType:
         {
             fControlType = kRawRTSPControlType;
             fTransportType = kUDPTransportType;
@@ -277,7 +279,12 @@ SInt64 ClientSession::Run()
             case kSendingSetup:
             {
                 // The SETUP request is different depending on whether we are interleaving or not
-                if (fTransportType == kUDPTransportType)
+                if ((fTransportType == kUDPTransportType) && fRTCPMux)
+                {
+                    theErr = fClient->SendRTCPMuxSetup(fSDPParser.GetStreamInfo(fNumSetups)->fTrackID,
+                                                fUDPSocketArray[fNumSetups*2]->GetLocalPort());
+                }
+                else if (fTransportType == kUDPTransportType)
                 {
                     theErr = fClient->SendUDPSetup(fSDPParser.GetStreamInfo(fNumSetups)->fTrackID,
                                                 fUDPSocketArray[fNumSetups*2]->GetLocalPort());
@@ -306,10 +313,19 @@ SInt64 ClientSession::Run()
                         theErr = ENOTCONN; // Exit the state machine
                         break;
                     }
+                    else if (fRTCPMux && !fClient->IsRTCPMux())
+                    {
+                        // The server has to agree to rtcp-mux, or it will send RTCP to a port we aren't reading
+                        fDeathReason = kRTCPMuxRefused;
+                        fState = kDone;
+                        break;
+                    }
                     else
                     {
-                        // Record the server port for RTCPs.
-                        fStats[fNumSetups].fDestRTCPPort = fClient->GetServerPort() + 1;
+                        // Record the server port for RTCPs. With rtcp-mux, that's the RTP port.
+                        fStats[fNumSetups].fDestRTCPPort = fClient->GetServerPort();
+                        if (!fRTCPMux)
+                            fStats[fNumSetups].fDestRTCPPort++;
                         
                         fNumSetups++;
                         if (fNumSetups == fSDPParser.GetNumStreams())
@@ -578,6 +594,10 @@ OS_Error    ClientSession::ReadMediaData()
             
             theTrackID = fSDPParser.GetStreamInfo(theUDPSockIndex >> 1)->fTrackID;
             isRTCP = (theUDPSockIndex & 1);
+            
+            // With rtcp-mux, tell the two apart by the RTCP packet types (RFC 5761)
+            if (fRTCPMux && (theLength > 1))
+                isRTCP = ((UInt8)thePacketBuf[1] >= 192) && ((UInt8)thePacketBuf[1] <= 223);
             thePacket = &thePacketBuf[0];
         }
         
@@ -814,7 +834,7 @@ void ClientSession::AckPackets(UInt32 inTrackIndex, UInt16 inCurSeqNum, Bool16 i
     
     // Send the packet
     Assert(fStats[inTrackIndex].fDestRTCPPort != 0);
-    fUDPSocketArray[(inTrackIndex*2)+1]->SendTo(fSocket->GetHostAddr(), fStats[inTrackIndex].fDestRTCPPort, theRRBuffer,
+    fUDPSocketArray[this->GetRTCPSocketIndex(inTrackIndex)]->SendTo(fSocket->GetHostAddr(), fStats[inTrackIndex].fDestRTCPPort, theRRBuffer,
                                                 (theWriter - theWriterStart) * sizeof(UInt32));
 
     //
@@ -893,7 +913,7 @@ OS_Error ClientSession::SendReceiverReport(UInt32 inTrackID)
     if (fUDPSocketArray != NULL)
     {
         Assert(fStats[inTrackID].fDestRTCPPort != 0);
-        fUDPSocketArray[(inTrackID*2)+1]->SendTo(fSocket->GetHostAddr(), fStats[inTrackID].fDestRTCPPort, theRRBuffer,
+        fUDPSocketArray[this->GetRTCPSocketIndex(inTrackID)]->SendTo(fSocket->GetHostAddr(), fStats[inTrackID].fDestRTCPPort, theRRBuffer,
                                                             (theWriter - theWriterStart) * sizeof(UInt32));
     }
     else
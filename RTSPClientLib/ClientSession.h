@@ -49,7 +49,8 @@ class ClientSession : public Task
             kRTSPTCPClientType          = 1,
             kRTSPHTTPClientType         = 2,
             kRTSPHTTPDropPostClientType = 3,
-            kRTSPReliableUDPClientType  = 4
+            kRTSPReliableUDPClientType  = 4,
+            kRTSPRTCPMuxClientType      = 5     // UDP, with RTCP on the RTP port
         };
         typedef UInt32 ClientType;
     
@@ -97,7 +98,8 @@ class ClientSession : public Task
             kBadSDP             = 3,    // Server sent back some bad SDP
             kSessionTimedout    = 4,    // Server not responding
             kConnectionFailed   = 5,    // Couldn't connect at all.
-            kDiedWhilePlaying   = 6     // Connection was forceably closed while playing the movie
+            kDiedWhilePlaying   = 6,    // Connection was forceably closed while playing the movie
+            kRTCPMuxRefused     = 7     // Asked for rtcp-mux, but the SETUP response didn't have it
         };
         
         //
@@ -165,6 +167,9 @@ class ClientSession : public Task
         };
         typedef UInt32 TransportType;
         
+        // With rtcp-mux, RTCP goes out from the track's RTP socket
+        UInt32  GetRTCPSocketIndex(UInt32 inTrackIndex) { return fRTCPMux ? (inTrackIndex * 2) : (inTrackIndex * 2) + 1; }
+        
         ClientSocket*   fSocket;    // Connection object
         RTSPClient*     fClient;    // Manages the client connection
         SDPSourceInfo   fSDPParser; // Parses the SDP in the DESCRIBE response
@@ -172,6 +177,7 @@ class ClientSession : public Task
         
         ControlType     fControlType;
         TransportType   fTransportType;
+        Bool16          fRTCPMux;
         UInt32          fDurationInSec;
         UInt32          fStartPlayTimeInSec;
         UInt32          fRTCPIntervalInSec;
@@ -821,6 +821,7 @@ RTSPClient::RTSPClient(ClientSocket* inSocket, Bool16 verbosePrinting, char* inU
     fStatus(0),
     fSessionID(sEmptyString),
     fServerPort(0),
+    fRTCPMux(false),
     fContentLength(0),
     fSetupHeaders(NULL),
     fNumChannelElements(kMinNumChannelElements),
@@ -1047,6 +1048,18 @@ OS_Error RTSPClient::SendUDPSetup(UInt32 inTrackID, UInt16 inClientPort)
     return this->DoTransaction();
 }
 
+OS_Error RTSPClient::SendRTCPMuxSetup(UInt32 inTrackID, UInt16 inClientPort)
+{
+    fSetupTrackID = inTrackID; // Needed when SETUP response is received.
+    
+    if (!fTransactionStarted)
+    {
+        qtss_sprintf(fMethod,"%s","SETUP");
+        qtss_sprintf(fSendBuffer, "SETUP %s/%s=%lu RTSP/1.0\r\nCSeq: %lu\r\n%sTransport: RTP/AVP;unicast;client_port=%u;rtcp-mux\r\n%sUser-agent: %s\r\n\r\n", fURL.Ptr,fControlID, inTrackID, fCSeq, fSessionID.Ptr, inClientPort, fSetupHeaders, fUserAgent);
+    }
+    return this->DoTransaction();
+}
+
 OS_Error RTSPClient::SendTCPSetup(UInt32 inTrackID, UInt16 inClientRTPid, UInt16 inClientRTCPid)
 {
     fSetupTrackID = inTrackID; // Needed when SETUP response is received.
@@ -1535,6 +1548,7 @@ OS_Error RTSPClient::ReceiveResponse()
 
             // Zero out fields that will change with every RTSP response
             fServerPort = 0;
+            fRTCPMux = false;
             fStatus = 0;
             fContentLength = 0;
         
@@ -1625,6 +1639,7 @@ OS_Error RTSPClient::ReceiveResponse()
                     {
                         static StrPtrLen sServerPort("server_port");
                         static StrPtrLen sInterleaved("interleaved");
+                        static StrPtrLen sRTCPMux("rtcp-mux");
 
                         theTransportParser.GetThru(&theSubHeader, ';');
                         if (theSubHeader.NumEqualIgnoreCase(sServerPort.Ptr, sServerPort.Len))
@@ -1635,6 +1650,8 @@ OS_Error RTSPClient::ReceiveResponse()
                         }
                         else if (theSubHeader.NumEqualIgnoreCase(sInterleaved.Ptr, sInterleaved.Len))
                             this->ParseInterleaveSubHeader(&theSubHeader);                          
+                        else if (theSubHeader.EqualIgnoreCase(sRTCPMux.Ptr, sRTCPMux.Len))
+                            fRTCPMux = true;
                     }
                 }
                 else if (theKey.NumEqualIgnoreCase(sRTPInfoHeader.Ptr, sRTPInfoHeader.Len))
@@ -242,6 +242,8 @@ class RTSPClient
         
         OS_Error    SendReliableUDPSetup(UInt32 inTrackID, UInt16 inClientPort);
         OS_Error    SendUDPSetup(UInt32 inTrackID, UInt16 inClientPort);
+        // Asks for RTP and RTCP on the one client port (rtcp-mux)
+        OS_Error    SendRTCPMuxSetup(UInt32 inTrackID, UInt16 inClientPort);
         OS_Error    SendTCPSetup(UInt32 inTrackID, UInt16 inClientRTPid, UInt16 inClientRTCPid);
         OS_Error    SendPlay(UInt32 inStartPlayTimeInSec, Float32 inSpeed = 1);
         OS_Error    SendPacketRangePlay(char* inPacketRangeHeader, Float32 inSpeed = 1);
@@ -289,6 +291,7 @@ class RTSPClient
         UInt32      GetStatus()             { return fStatus; }
         StrPtrLen*  GetSessionID()          { return &fSessionID; }
         UInt16      GetServerPort()         { return fServerPort; }
+        Bool16      IsRTCPMux()             { return fRTCPMux; } // the SETUP response had rtcp-mux
         UInt32      GetContentLength()      { return fContentLength; }
         char*       GetContentBody()        { return fRecvContentBuffer; }
         ClientSocket*   GetSocket()         { return fSocket; }
@@ -353,6 +356,7 @@ class RTSPClient
         UInt32      fStatus;
         StrPtrLen   fSessionID;
         UInt16      fServerPort;
+        Bool16      fRTCPMux;
         UInt32      fContentLength;
         StrPtrLen   fRTPInfoHeader;
         
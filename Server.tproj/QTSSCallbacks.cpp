@@ -64,6 +64,15 @@ void    QTSSCallbacks::QTSS_Delete(void* inMemory)
     OSMemory::Delete(inMemory);
 }
 
+void*   QTSSCallbacks::QTSS_NewRequestMemory(QTSS_RTSPRequestObject inRequest, UInt32 inSize)
+{
+    RTSPRequestInterface* theRequest = (RTSPRequestInterface*)inRequest;
+    if (theRequest == NULL)
+        return NULL;
+        
+    return theRequest->GetArena()->Alloc(inSize);
+}
+
 void    QTSSCallbacks::QTSS_Milliseconds(SInt64* outMilliseconds)
 {
     if (outMilliseconds != NULL)
@@ -44,6 +44,7 @@ class QTSSCallbacks
         
         static void*    QTSS_New(FourCharCode inMemoryIdentifier, UInt32 inSize);
         static void     QTSS_Delete(void* inMemory);
+        static void*    QTSS_NewRequestMemory(QTSS_RTSPRequestObject inRequest, UInt32 inSize);
         
         
         // TIME ROUTINES
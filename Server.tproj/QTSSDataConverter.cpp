@@ -279,26 +279,30 @@ QTSS_Error QTSSDataConverter::ConvertCHexStringToBytes(  char* inValueAsString,
     return QTSS_NoErr;
 }
 
-char* QTSSDataConverter::ConvertBytesToCHexString( void* inValue, const UInt32 inValueLen)
+void QTSSDataConverter::ConvertBytesToCHexString( void* inValue, const UInt32 inValueLen, char* outString)
 {
     UInt8* theDataPtr = (UInt8*) inValue;
+    UInt8 temp;
+    UInt32 count = 0;
+    for (count = 0; count < inValueLen; count++)
+    {
+        temp = *theDataPtr++;
+        *outString++ = kHEXChars[temp >> 4];
+        *outString++ = kHEXChars[temp & 0xF];
+    }
+}
+
+char* QTSSDataConverter::ConvertBytesToCHexString( void* inValue, const UInt32 inValueLen)
+{
     UInt32 len = inValueLen *2;
     
     char *theString = NEW char[len+1];
-    char *resultStr = theString;
     if (theString != NULL)
     {
-        UInt8 temp;
-        UInt32 count = 0;
-        for (count = 0; count < inValueLen; count++)
-        {
-            temp = *theDataPtr++;
-            *theString++ = kHEXChars[temp >> 4];
-            *theString++ = kHEXChars[temp & 0xF];
-        }
-        *theString = 0;
+        ConvertBytesToCHexString(inValue, inValueLen, theString);
+        theString[len] = 0;
     }
-    return resultStr;
+    return theString;
 }
                                             
 char* QTSSDataConverter::ValueToString( void* inValue,
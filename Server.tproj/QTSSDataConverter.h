@@ -66,6 +66,10 @@ class QTSSDataConverter
                                             const UInt32 inValueLen,
                                             const QTSS_AttrDataType inType);
         
+        // Converts inValueLen bytes to hex in high to low order, writing
+        // exactly inValueLen * 2 chars to outString (no NULL terminator).
+        static void ConvertBytesToCHexString( void* inValue, const UInt32 inValueLen, char* outString);
+        
 private:
 
         // Takes a pointer to buffer and converts to hex in high to low order
@@ -46,7 +46,7 @@
 
 QTSSDictionary::QTSSDictionary(QTSSDictionaryMap* inMap, OSMutex* inMutex) 
 :   fAttributes(NULL), fInstanceAttrs(NULL), fInstanceArraySize(0),
-    fMap(inMap), fInstanceMap(NULL), fMutexP(inMutex), fMyMutex(false), fLocked(false)
+    fMap(inMap), fInstanceMap(NULL), fMutexP(inMutex), fMyMutex(false), fLocked(false), fArena(NULL)
 {
     if (fMap != NULL)
         fAttributes = NEW DictValueElement[inMap->GetNumAttrs()];
@@ -163,6 +163,27 @@ QTSS_Error QTSSDictionary::GetValuePtr(QTSS_AttributeID inAttrID, UInt32 inIndex
 QTSS_Error QTSSDictionary::GetValue(QTSS_AttributeID inAttrID, UInt32 inIndex,
                                             void* ioValueBuffer, UInt32* ioValueLen)
 {
+    // Most reads on the packet path are of fixed size attributes that the server
+    // owns: read only to modules, and kept in a member of the object (set up with SetVal).
+    // Their storage never moves and the server updates those members without taking
+    // fMutexP, so the mutex doesn't add anything. Copy them out directly.
+    if ((inIndex == 0) && (fMap != NULL) && !QTSSDictionaryMap::IsInstanceAttrID(inAttrID))
+    {
+        SInt32 theMapIndex = fMap->ConvertAttrIDToArrayIndex(inAttrID);
+        if ((theMapIndex >= 0) && fMap->IsFixedSize(theMapIndex) && !fMap->IsWriteable(theMapIndex)
+            && !fMap->IsRemoved(theMapIndex) && (fMap->GetAttrFunction(theMapIndex) == NULL)
+            && !fAttributes[theMapIndex].fAllocatedInternally && (fAttributes[theMapIndex].fNumAttributes == 1))
+        {
+            StrPtrLen* theValue = &fAttributes[theMapIndex].fAttributeData;
+            if (theValue->Len == 0)
+                return QTSS_ValueNotFound;
+            if ((ioValueBuffer != NULL) && (theValue->Len <= *ioValueLen))
+                ::memcpy(ioValueBuffer, theValue->Ptr, theValue->Len);
+            *ioValueLen = theValue->Len;
+            return QTSS_NoErr;
+        }
+    }
+
     // If there is a mutex, lock it and get a pointer to the proper attribute
     OSMutexLocker locker(fMutexP);
 
@@ -331,7 +352,8 @@ QTSS_Error QTSSDictionary::SetValue(QTSS_AttributeID inAttrID, UInt32 inIndex,
                         char* temp = NEW char[tempStringLen + 1];
                         ::memcpy(temp, theAttrs[theMapIndex].fAttributeData.Ptr, tempStringLen);
                         temp[tempStringLen] = '\0';
-                        delete [] theAttrs[theMapIndex].fAttributeData.Ptr;
+                        if (theAttrs[theMapIndex].fAllocatedInternally)
+                            delete [] theAttrs[theMapIndex].fAttributeData.Ptr;
                         
             //char* temp = theAttrs[theMapIndex].fAttributeData.Ptr;
             
@@ -340,7 +362,7 @@ QTSS_Error QTSSDictionary::SetValue(QTSS_AttributeID inAttrID, UInt32 inIndex,
             theAttrs[theMapIndex].fAttributeData.Len = sizeof(char*);
             // store off original string as first value in array
             *(char**)theAttrs[theMapIndex].fAttributeData.Ptr = temp;
-                        // question: why isn't theAttrs[theMapIndex].fAllocatedInternally set to true?
+            theAttrs[theMapIndex].fAllocatedInternally = true;
         }
     }
     else
@@ -366,7 +388,11 @@ QTSS_Error QTSSDictionary::SetValue(QTSS_AttributeID inAttrID, UInt32 inIndex,
             theLen = attrLen;   // most attributes are single valued, so allocate just enough space
         else
             theLen = 2 * (attrLen * (inIndex + 1));// Allocate twice as much as we need
-        char* theNewBuffer = NEW char[theLen];
+        char* theNewBuffer = NULL;
+        if (fArena != NULL)
+            theNewBuffer = (char*)fArena->Alloc(theLen);
+        else
+            theNewBuffer = NEW char[theLen];
         if (inIndex > 0)
         {
             // Copy out the old attribute data
@@ -382,7 +408,7 @@ QTSS_Error QTSSDictionary::SetValue(QTSS_AttributeID inAttrID, UInt32 inIndex,
         // Finally, update this attribute structure with all the new values.
         theAttrs[theMapIndex].fAttributeData.Ptr = theNewBuffer;
         theAttrs[theMapIndex].fAllocatedLen = theLen;
-        theAttrs[theMapIndex].fAllocatedInternally = true;
+        theAttrs[theMapIndex].fAllocatedInternally = (fArena == NULL);
     }
         
     // At this point, we should always have enough space to write what we want
@@ -543,8 +569,10 @@ QTSS_Error QTSSDictionary::RemoveValue(QTSS_AttributeID inAttrID, UInt32 inIndex
     {
         // we only have one string left, so we don't need the extra pointer
         char* str = *(char**)(theAttrs[theMapIndex].fAttributeData.Ptr);
-        delete theAttrs[theMapIndex].fAttributeData.Ptr;
+        if (theAttrs[theMapIndex].fAllocatedInternally)
+            delete theAttrs[theMapIndex].fAttributeData.Ptr;
         theAttrs[theMapIndex].fAttributeData.Ptr = str;
+        theAttrs[theMapIndex].fAllocatedInternally = true;
         theAttrs[theMapIndex].fAttributeData.Len = strlen(str);
         theAttrs[theMapIndex].fAllocatedLen = strlen(str);
     }
@@ -859,12 +887,43 @@ void QTSSDictionaryMap::Initialize()
 }
 
 QTSSDictionaryMap::QTSSDictionaryMap(UInt32 inNumReservedAttrs, UInt32 inFlags)
-:   fNextAvailableID(inNumReservedAttrs), fNumValidAttrs(inNumReservedAttrs),fAttrArraySize(inNumReservedAttrs), fFlags(inFlags)
+:   fNextAvailableID(inNumReservedAttrs), fNumValidAttrs(inNumReservedAttrs),fAttrArraySize(inNumReservedAttrs),
+    fNameBuckets(NULL), fNumNameBuckets(0), fFlags(inFlags)
 {
     if (fAttrArraySize < kMinArraySize)
         fAttrArraySize = kMinArraySize;
     fAttrArray = NEW QTSSAttrInfoDict*[fAttrArraySize];
     ::memset(fAttrArray, 0, sizeof(QTSSAttrInfoDict*) * fAttrArraySize);
+    fAttrFlags = NEW AttrFlags[fAttrArraySize];
+    ::memset(fAttrFlags, 0, sizeof(AttrFlags) * fAttrArraySize);
+    this->RebuildNameIndex(fAttrArraySize);
+}
+
+void QTSSDictionaryMap::UpdateAttrFlags(UInt32 inIndex)
+{
+    QTSSAttrInfoDict::AttrInfo* theInfo = &fAttrArray[inIndex]->fAttrInfo;
+    fAttrFlags[inIndex].fFuncPtr = theInfo->fFuncPtr;
+    fAttrFlags[inIndex].fAttrDataType = theInfo->fAttrDataType;
+    fAttrFlags[inIndex].fAttrPermission = theInfo->fAttrPermission;
+    
+    switch (theInfo->fAttrDataType)
+    {
+        case qtssAttrDataTypeBool16:
+        case qtssAttrDataTypeSInt16:
+        case qtssAttrDataTypeUInt16:
+        case qtssAttrDataTypeSInt32:
+        case qtssAttrDataTypeUInt32:
+        case qtssAttrDataTypeSInt64:
+        case qtssAttrDataTypeUInt64:
+        case qtssAttrDataTypeFloat32:
+        case qtssAttrDataTypeFloat64:
+        case qtssAttrDataTypeTimeVal:
+            fAttrFlags[inIndex].fIsFixedSize = true;
+            break;
+        default:
+            fAttrFlags[inIndex].fIsFixedSize = false;
+            break;
+    }
 }
 
 QTSS_Error QTSSDictionaryMap::AddAttribute( const char* inAttrName,
@@ -887,6 +946,7 @@ QTSS_Error QTSSDictionaryMap::AddAttribute( const char* inAttrName,
                     this->UnRemoveAttribute(attrID); 
                     fAttrArray[count]->fAttrInfo.fFuncPtr = inFuncPtr; // reset
                     fAttrArray[count]->fAttrInfo.fAttrPermission = inPermission;// reset
+                    this->UpdateAttrFlags(count);
                     return QTSS_NoErr; // nothing left to do. It is re-added.
                 }
                 
@@ -915,6 +975,15 @@ QTSS_Error QTSSDictionaryMap::AddAttribute( const char* inAttrName,
             delete [] fAttrArray;
         }
         fAttrArray = theNewArray;
+        
+        AttrFlags* theNewFlags = NEW AttrFlags[theNewArraySize];
+        ::memset(theNewFlags, 0, sizeof(AttrFlags) * theNewArraySize);
+        if (fAttrFlags != NULL)
+        {
+            ::memcpy(theNewFlags, fAttrFlags, sizeof(AttrFlags) * fAttrArraySize);
+            delete [] fAttrFlags;
+        }
+        fAttrFlags = theNewFlags;
         fAttrArraySize = theNewArraySize;
     }
     
@@ -950,6 +1019,14 @@ void QTSSDictionaryMap::SetAttribute(   QTSS_AttributeID inID,
     fAttrArray[theIndex]->fAttrInfo.fFuncPtr = inFuncPtr;
     fAttrArray[theIndex]->fAttrInfo.fAttrDataType = inDataType; 
     fAttrArray[theIndex]->fAttrInfo.fAttrPermission = inPermission;
+    this->UpdateAttrFlags(theIndex);
+    
+    // Keep the buckets from getting long as modules add attributes
+    fAttrFlags[theIndex].fNameHash = QTSSDictionaryMap::HashAttrName(inAttrName);
+    if (fAttrArraySize > fNumNameBuckets * 2)
+        this->RebuildNameIndex(fAttrArraySize);
+    else
+        this->AddToNameIndex(theIndex);
     
     fAttrArray[theIndex]->SetVal(qtssAttrName, &fAttrArray[theIndex]->fAttrInfo.fAttrName[0], theNameLen);
     fAttrArray[theIndex]->SetVal(qtssAttrID, &fAttrArray[theIndex]->fID, sizeof(fAttrArray[theIndex]->fID));
@@ -987,6 +1064,7 @@ QTSS_Error  QTSSDictionaryMap::RemoveAttribute(QTSS_AttributeID inAttrID)
     // Don't actually touch the attribute or anything. Just flag the
     // it as removed.
     fAttrArray[theIndex]->fAttrInfo.fAttrPermission |= qtssPrivateAttrModeRemoved;
+    this->UpdateAttrFlags(theIndex);
     fNumValidAttrs--;
     Assert(fNumValidAttrs < 1000000);
     return QTSS_NoErr;
@@ -1002,6 +1080,7 @@ QTSS_Error  QTSSDictionaryMap::UnRemoveAttribute(QTSS_AttributeID inAttrID)
         return QTSS_AttrDoesntExist;
         
     fAttrArray[theIndex]->fAttrInfo.fAttrPermission &= ~qtssPrivateAttrModeRemoved;
+    this->UpdateAttrFlags(theIndex);
     
     fNumValidAttrs++;
     return QTSS_NoErr;
@@ -1013,9 +1092,10 @@ QTSS_Error  QTSSDictionaryMap::GetAttrInfoByName(const char* inAttrName, QTSSAtt
     if (outAttrInfoObject == NULL)
         return QTSS_BadArgument;
 
-    for (UInt32 count = 0; count < fNextAvailableID; count++)
+    UInt32 theHash = QTSSDictionaryMap::HashAttrName(inAttrName);
+    for (SInt32 count = fNameBuckets[theHash & (fNumNameBuckets - 1)]; count != -1; count = fAttrFlags[count].fNextByName)
     {
-        if (::strcmp(&fAttrArray[count]->fAttrInfo.fAttrName[0], inAttrName) == 0)
+        if ((fAttrFlags[count].fNameHash == theHash) && (::strcmp(&fAttrArray[count]->fAttrInfo.fAttrName[0], inAttrName) == 0))
         {
             if ((fAttrArray[count]->fAttrInfo.fAttrPermission & qtssPrivateAttrModeRemoved) && (!returnRemovedAttr))
                 continue;
@@ -1027,6 +1107,43 @@ QTSS_Error  QTSSDictionaryMap::GetAttrInfoByName(const char* inAttrName, QTSSAtt
     return QTSS_AttrDoesntExist;
 }
 
+UInt32 QTSSDictionaryMap::HashAttrName(const char* inAttrName)
+{
+    UInt32 theHash = 0;
+    for (UInt8* theChar = (UInt8*)inAttrName; *theChar != '\0'; theChar++)
+        theHash = (theHash * 31) + *theChar;
+    return theHash;
+}
+
+void QTSSDictionaryMap::AddToNameIndex(UInt32 inIndex)
+{
+    SInt32* theLink = &fNameBuckets[fAttrFlags[inIndex].fNameHash & (fNumNameBuckets - 1)];
+    while ((*theLink != -1) && ((UInt32)*theLink < inIndex))
+        theLink = &fAttrFlags[*theLink].fNextByName;
+        
+    fAttrFlags[inIndex].fNextByName = *theLink;
+    *theLink = (SInt32)inIndex;
+}
+
+void QTSSDictionaryMap::RebuildNameIndex(UInt32 inNumBuckets)
+{
+    fNumNameBuckets = 16;
+    while (fNumNameBuckets < inNumBuckets)
+        fNumNameBuckets <<= 1;
+        
+    delete [] fNameBuckets;
+    fNameBuckets = NEW SInt32[fNumNameBuckets];
+    for (UInt32 x = 0; x < fNumNameBuckets; x++)
+        fNameBuckets[x] = -1;
+        
+    // Reserved attributes that haven't been set up yet aren't in the index
+    for (UInt32 y = 0; y < fNextAvailableID; y++)
+    {
+        if (fAttrArray[y] != NULL)
+            this->AddToNameIndex(y);
+    }
+}
+
 QTSS_Error  QTSSDictionaryMap::GetAttrInfoByID(QTSS_AttributeID inID, QTSSAttrInfoDict** outAttrInfoObject)
 {
     if (outAttrInfoObject == NULL)
@@ -1127,3 +1244,113 @@ QTSS_ObjectType QTSSDictionaryMap::CreateNewMap()
     
     return result;
 }
+
+#if __DICTIONARY_TESTING__
+static QTSS_AttributeID GetTestAttrID(QTSSAttrInfoDict* inAttrInfo)
+{
+    QTSS_AttributeID theID = qtssIllegalAttrID;
+    UInt32 theLen = sizeof(theID);
+    (void)inAttrInfo->GetValue(qtssAttrID, 0, &theID, &theLen);
+    return theID;
+}
+
+void QTSSDictionary::Test()
+{
+    // QTSSDictionaryMap::Initialize() must have set up the attribute info map first
+    QTSSDictionaryMap theMap(0, QTSSDictionaryMap::kAllowRemoval | QTSSDictionaryMap::kInstanceAttrsAllowed);
+    QTSS_AttrPermission thePerm = qtssAttrModeRead | qtssAttrModeWrite | qtssAttrModeDelete;
+    char theName[QTSS_MAX_ATTRIBUTE_NAME_SIZE + 1];
+    QTSS_AttributeID theID = qtssIllegalAttrID;
+    QTSSAttrInfoDict* theAttrInfo = NULL;
+    QTSS_Error theErr = QTSS_NoErr;
+    
+    //
+    // Enough attributes to grow the map, and rebuild the name index, a few times
+    for (UInt32 x = 0; x < 100; x++)
+    {
+        qtss_sprintf(theName, "TestAttr%lu", x);
+        theErr = theMap.AddAttribute(theName, NULL, qtssAttrDataTypeUInt32, thePerm);
+        Assert(theErr == QTSS_NoErr);
+    }
+    for (UInt32 y = 0; y < 100; y++)
+    {
+        qtss_sprintf(theName, "TestAttr%lu", y);
+        theErr = theMap.GetAttrID(theName, &theID);
+        Assert(theErr == QTSS_NoErr);
+        Assert(theID == y);
+    }
+    theErr = theMap.GetAttrID("TestAttr100", &theID);
+    Assert(theErr == QTSS_AttrDoesntExist);
+    theErr = theMap.AddAttribute("TestAttr5", NULL, qtssAttrDataTypeUInt32, thePerm);
+    Assert(theErr == QTSS_AttrNameExists);
+    
+    //
+    // A removed attribute is only found when asked for
+    theErr = theMap.RemoveAttribute(5);
+    Assert(theErr == QTSS_NoErr);
+    theErr = theMap.GetAttrID("TestAttr5", &theID);
+    Assert(theErr == QTSS_AttrDoesntExist);
+    theErr = theMap.GetAttrInfoByName("TestAttr5", &theAttrInfo, true);
+    Assert(theErr == QTSS_NoErr);
+    Assert(GetTestAttrID(theAttrInfo) == 5);
+    
+    //
+    // Adding the name back with another type makes a second attribute with that name.
+    // Lookups find the new one, and the removed one still comes first when asked for.
+    theErr = theMap.AddAttribute("TestAttr5", NULL, qtssAttrDataTypeCharArray, thePerm);
+    Assert(theErr == QTSS_NoErr);
+    theErr = theMap.GetAttrID("TestAttr5", &theID);
+    Assert(theErr == QTSS_NoErr);
+    Assert(theID == 100);
+    theErr = theMap.GetAttrInfoByName("TestAttr5", &theAttrInfo, true);
+    Assert(theErr == QTSS_NoErr);
+    Assert(GetTestAttrID(theAttrInfo) == 5);
+    
+    //
+    // With both removed, adding it back with the first type reuses the first one
+    theErr = theMap.RemoveAttribute(100);
+    Assert(theErr == QTSS_NoErr);
+    theErr = theMap.AddAttribute("TestAttr5", NULL, qtssAttrDataTypeUInt32, thePerm);
+    Assert(theErr == QTSS_NoErr);
+    theErr = theMap.GetAttrID("TestAttr5", &theID);
+    Assert(theErr == QTSS_NoErr);
+    Assert(theID == 5);
+    Assert(theMap.GetNumAttrs() == 101);
+    
+    //
+    // Instance attributes get their own map, but can't reuse a name from the static one
+    QTSSDictionary theDict(&theMap);
+    theErr = theDict.AddInstanceAttribute("TestAttr7", NULL, qtssAttrDataTypeUInt32, thePerm);
+    Assert(theErr == QTSS_AttrNameExists);
+    for (UInt32 z = 0; z < 40; z++)
+    {
+        qtss_sprintf(theName, "TestInstance%lu", z);
+        theErr = theDict.AddInstanceAttribute(theName, NULL, qtssAttrDataTypeUInt32, thePerm);
+        Assert(theErr == QTSS_NoErr);
+    }
+    for (UInt32 a = 0; a < 40; a++)
+    {
+        qtss_sprintf(theName, "TestInstance%lu", a);
+        theErr = theDict.GetAttrInfoByName(theName, &theAttrInfo);
+        Assert(theErr == QTSS_NoErr);
+        Assert(GetTestAttrID(theAttrInfo) == (a | 0x80000000));
+    }
+    theErr = theDict.GetAttrInfoByName("TestAttr7", &theAttrInfo);
+    Assert(theErr == QTSS_NoErr);
+    Assert(GetTestAttrID(theAttrInfo) == 7);
+    
+    theErr = theDict.RemoveInstanceAttribute(3 | 0x80000000);
+    Assert(theErr == QTSS_NoErr);
+    theErr = theDict.GetAttrInfoByName("TestInstance3", &theAttrInfo);
+    Assert(theErr == QTSS_AttrDoesntExist);
+    
+    theErr = theDict.AddInstanceAttribute("TestInstance3", NULL, qtssAttrDataTypeCharArray, thePerm);
+    Assert(theErr == QTSS_NoErr);
+    theErr = theDict.GetAttrInfoByName("TestInstance3", &theAttrInfo);
+    Assert(theErr == QTSS_NoErr);
+    Assert(GetTestAttrID(theAttrInfo) == (40 | 0x80000000));
+    theErr = theDict.GetInstanceDictMap()->GetAttrInfoByName("TestInstance3", &theAttrInfo, true);
+    Assert(theErr == QTSS_NoErr);
+    Assert(GetTestAttrID(theAttrInfo) == (3 | 0x80000000));
+}
+#endif
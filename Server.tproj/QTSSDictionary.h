@@ -43,6 +43,7 @@
 #include "QTSS.h"
 #include "OSHeaders.h"
 #include "OSMutex.h"
+#include "OSArena.h"
 #include "StrPtrLen.h"
 #include "MyAssert.h"
 #include "QTSSStream.h"
@@ -171,6 +172,10 @@ class QTSSDictionary : public QTSSStream
 
         // Call this if you want to assign empty storage to an attribute
         void    SetEmptyVal(QTSS_AttributeID inAttrID, void* inBuf, UInt32 inBufLen);
+
+        // Values copied in by SetValue come out of inArena from now on instead of
+        // being allocated and deleted one at a time. The arena must outlive the dictionary.
+        void    SetArena(OSArena* inArena)  { fArena = inArena; }
         
 #if __DICTIONARY_TESTING__
         static void Test(); // API test for these objects
@@ -214,6 +219,7 @@ class QTSSDictionary : public QTSSStream
         OSMutex*            fMutexP;
 		Bool16				fMyMutex;
 		Bool16				fLocked;
+        OSArena*            fArena;
         
         void DeleteAttributeData(DictValueElement* inDictValues, UInt32 inNumValues);
 };
@@ -271,7 +277,7 @@ class QTSSDictionaryMap
         // CONSTRUCTOR / DESTRUCTOR
         
         QTSSDictionaryMap(UInt32 inNumReservedAttrs, UInt32 inFlags = kNoFlags);
-        ~QTSSDictionaryMap(){ delete fAttrArray; }
+        ~QTSSDictionaryMap(){ delete fAttrArray; delete [] fAttrFlags; delete [] fNameBuckets; }
 
         //
         // QTSS API CALLS
@@ -317,20 +323,26 @@ class QTSSDictionaryMap
         UInt32          GetNumAttrs()           { return fNextAvailableID; }
         UInt32          GetNumNonRemovedAttrs() { return fNumValidAttrs; }
         
+        // These read from fAttrFlags, so a Get or SetValue doesn't have to touch the
+        // attribute's QTSSAttrInfoDict.
         Bool16                  IsPreemptiveSafe(UInt32 inIndex) 
-            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrArray[inIndex]->fAttrInfo.fAttrPermission & qtssAttrModePreempSafe); }
+            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrFlags[inIndex].fAttrPermission & qtssAttrModePreempSafe); }
 
         Bool16                  IsWriteable(UInt32 inIndex) 
-            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrArray[inIndex]->fAttrInfo.fAttrPermission & qtssAttrModeWrite); }
+            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrFlags[inIndex].fAttrPermission & qtssAttrModeWrite); }
 		
 		Bool16                  IsCacheable(UInt32 inIndex) 
-            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrArray[inIndex]->fAttrInfo.fAttrPermission & qtssAttrModeCacheable); }
+            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrFlags[inIndex].fAttrPermission & qtssAttrModeCacheable); }
 
         Bool16                  IsRemoved(UInt32 inIndex) 
-            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrArray[inIndex]->fAttrInfo.fAttrPermission & qtssPrivateAttrModeRemoved) ; }
+            { Assert(inIndex < fNextAvailableID); return (Bool16) (fAttrFlags[inIndex].fAttrPermission & qtssPrivateAttrModeRemoved) ; }
+
+        // True for attributes whose value always has the same size, like a UInt32 or an SInt64
+        Bool16                  IsFixedSize(UInt32 inIndex)
+            { Assert(inIndex < fNextAvailableID); return fAttrFlags[inIndex].fIsFixedSize; }
 
         QTSS_AttrFunctionPtr    GetAttrFunction(UInt32 inIndex)
-            { Assert(inIndex < fNextAvailableID); return fAttrArray[inIndex]->fAttrInfo.fFuncPtr; }
+            { Assert(inIndex < fNextAvailableID); return fAttrFlags[inIndex].fFuncPtr; }
             
         char*                   GetAttrName(UInt32 inIndex)
             { Assert(inIndex < fNextAvailableID); return fAttrArray[inIndex]->fAttrInfo.fAttrName; }
@@ -339,7 +351,7 @@ class QTSSDictionaryMap
             { Assert(inIndex < fNextAvailableID); return fAttrArray[inIndex]->fID; }
 
         QTSS_AttrDataType       GetAttrType(UInt32 inIndex)
-            { Assert(inIndex < fNextAvailableID); return fAttrArray[inIndex]->fAttrInfo.fAttrDataType; }
+            { Assert(inIndex < fNextAvailableID); return fAttrFlags[inIndex].fAttrDataType; }
         
         Bool16                  InstanceAttrsAllowed() { return (Bool16) (fFlags & kInstanceAttrsAllowed); }
         Bool16                  CompleteFunctionsAllowed() { return (Bool16) (fFlags & kCompleteFunctionsAllowed) ; }
@@ -409,10 +421,35 @@ class QTSSDictionaryMap
             kMinArraySize = 20
         };
 
+        // A copy of the parts of each attribute's info that every Get and SetValue
+        // checks, kept in one array next to each other. Also holds the attribute's
+        // link in the name index.
+        struct AttrFlags
+        {
+            QTSS_AttrFunctionPtr    fFuncPtr;
+            QTSS_AttrDataType       fAttrDataType;
+            QTSS_AttrPermission     fAttrPermission;
+            Bool16                  fIsFixedSize;
+            UInt32                  fNameHash;
+            SInt32                  fNextByName;    // next attribute in the same name bucket, or -1
+        };
+
+        // Call after changing anything in fAttrArray[inIndex]->fAttrInfo
+        void                            UpdateAttrFlags(UInt32 inIndex);
+        
+        // The name index is a hash table of attribute indexes. Each bucket is kept
+        // in index order, so a lookup finds the same attribute a scan of fAttrArray would.
+        static UInt32                   HashAttrName(const char* inAttrName);
+        void                            AddToNameIndex(UInt32 inIndex);
+        void                            RebuildNameIndex(UInt32 inNumBuckets);
+
         UInt32                          fNextAvailableID;
         UInt32                          fNumValidAttrs;
         UInt32                          fAttrArraySize;
         QTSSAttrInfoDict**              fAttrArray;
+        AttrFlags*                      fAttrFlags;     // same size and order as fAttrArray
+        SInt32*                         fNameBuckets;   // first attribute index in each bucket, or -1
+        UInt32                          fNumNameBuckets;// always a power of 2
         UInt32                          fFlags;
         
         friend class QTSSDictionary;
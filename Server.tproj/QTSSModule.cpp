@@ -218,6 +218,7 @@ QTSS_Error  QTSSModule::AddRole(QTSS_Role inRole)
         case QTSS_RTPSendPackets_Role:      fRoleArray[kRTPSendPacketsRole] = true;     break;
         case QTSS_ClientSessionClosing_Role:fRoleArray[kClientSessionClosingRole] = true;break;
         case QTSS_RTCPProcess_Role:         fRoleArray[kRTCPProcessRole] = true;        break;
+        case QTSS_RTCPReport_Role:          fRoleArray[kRTCPReportRole] = true;         break;
         case QTSS_ErrorLog_Role:            fRoleArray[kErrorLogRole] = true;           break;
         case QTSS_RereadPrefs_Role:         fRoleArray[kRereadPrefsRole] = true;        break;
         case QTSS_OpenFile_Role:            fRoleArray[kOpenFileRole] = true;           break;
@@ -120,8 +120,9 @@ class QTSSModule : public QTSSDictionary, public Task
             kRTSPIncomingDataRole =     21,
             kStateChangeRole =          22,
             kTimedIntervalRole =        23,
+            kRTCPReportRole =           24,
             
-            kNumRoles =                 24
+            kNumRoles =                 25
         };
         typedef UInt32 RoleIndex;
         
@@ -95,6 +95,14 @@ class RTSPListenerSocket : public TCPListenerSocket
         
         //sole job of this object is to implement this function
         virtual Task*   GetSessionTask(TCPSocket** outSocket);
+        
+        //turns connections away at accept time when the server can't take them
+        virtual StrPtrLen*  GetRejectResponse(UInt32 inRemoteAddr);
+        
+    private:
+    
+        static StrPtrLen    sServiceUnavailableResponse;
+        static StrPtrLen    sNotEnoughBandwidthResponse;
 };
 
 class RTPSocketPool : public UDPSocketPool
@@ -274,6 +282,7 @@ void QTSServer::StartTasks()
 {
     fRTCPTask = new RTCPTask();
     fStatsTask = new RTPStatsUpdaterTask();
+    fLatencyTask = new TaskLatencyTask();
 
     //
     // Start listening
@@ -747,6 +756,7 @@ void    QTSServer::InitCallbacks()
     
     sCallbacks.addr[kLockStdLibCallback] =                  (QTSS_CallbackProcPtr)QTSSCallbacks::QTSS_LockStdLib;
     sCallbacks.addr[kUnlockStdLibCallback] =                (QTSS_CallbackProcPtr)QTSSCallbacks::QTSS_UnlockStdLib;
+    sCallbacks.addr[kNewRequestMemoryCallback] =            (QTSS_CallbackProcPtr)QTSSCallbacks::QTSS_NewRequestMemory;
 }
 
 void QTSServer::LoadModules(QTSServerPrefs* inPrefs)
@@ -1031,6 +1041,45 @@ void QTSServer::SetupPublicHeader()
 }
 
 
+// These go out before we have read a request, so there is no CSeq to echo back.
+StrPtrLen   RTSPListenerSocket::sServiceUnavailableResponse("RTSP/1.0 503 Service Unavailable\r\nRetry-After: 10\r\nConnection: Close\r\n\r\n");
+StrPtrLen   RTSPListenerSocket::sNotEnoughBandwidthResponse("RTSP/1.0 453 Not Enough Bandwidth\r\nConnection: Close\r\n\r\n");
+
+StrPtrLen*  RTSPListenerSocket::GetRejectResponse(UInt32 inRemoteAddr)
+{
+    // Admin requests come in from this machine, so always let those through
+    if ((inRemoteAddr >> 24) == 127)
+        return NULL;
+
+    QTSServerInterface* theServer = QTSServerInterface::GetServer();
+    StrPtrLen* theResponse = NULL;
+    
+    // The task threads are falling behind. Taking on more clients
+    // would only make the ones we have now glitch.
+    if (theServer->IsOverloaded())
+        theResponse = &sServiceUnavailableResponse;
+
+    // Any client getting in now would be turned away at SETUP by
+    // RTSPSession::IsOkToAddNewRTPSession, so save it the round trips.
+    // The RTSP session count is allowed some slack for HTTP tunnels and
+    // clients that only do a DESCRIBE.
+    SInt32 maxConns = theServer->GetPrefs()->GetMaxConnections();
+    if ((theResponse == NULL) && (maxConns > -1))
+    {
+        if ((theServer->GetNumRTPSessions() >= (UInt32)maxConns) ||
+            (theServer->GetNumRTSPSessions() + theServer->GetNumRTSPHTTPSessions() >= (UInt32)maxConns * 2))
+            theResponse = &sNotEnoughBandwidthResponse;
+    }
+
+    SInt32 maxKBits = theServer->GetPrefs()->GetMaxKBitsBandwidth();
+    if ((theResponse == NULL) && (maxKBits > -1) && (theServer->GetCurBandwidthInBits() >= ((UInt32)maxKBits * 1024)))
+        theResponse = &sNotEnoughBandwidthResponse;
+
+    if (theResponse != NULL)
+        theServer->IncrementNumRejectedConnections();
+    return theResponse;
+}
+
 Task*   RTSPListenerSocket::GetSessionTask(TCPSocket** outSocket)
 {
     Assert(outSocket != NULL);
@@ -1052,12 +1101,13 @@ UDPSocketPair*  RTPSocketPool::ConstructUDPSocketPair()
 {
     Task* theTask = ((QTSServer*)QTSServerInterface::GetServer())->fRTCPTask;
     
-    //construct a pair of UDP sockets, the lower one for RTP data (outgoing only, no demuxer
-    //necessary), and one for RTCP data (incoming, so definitely need a demuxer).
+    //construct a pair of UDP sockets, the lower one for RTP data, and one for RTCP data
+    //(incoming, so definitely need a demuxer). The RTP socket needs a demuxer as well,
+    //because streams using rtcp-mux get their RTCP on it.
     //These are nonblocking sockets that DON'T receive events (we are going to poll for data)
 	// They do receive events - we don't poll from them anymore
     return NEW
-        UDPSocketPair(  NEW UDPSocket(theTask, Socket::kNonBlockingSocketType),
+        UDPSocketPair(  NEW UDPSocket(theTask, UDPSocket::kWantsDemuxer | Socket::kNonBlockingSocketType),
                         NEW UDPSocket(theTask, UDPSocket::kWantsDemuxer | Socket::kNonBlockingSocketType));
 }
 
@@ -1074,6 +1124,19 @@ void RTPSocketPool::SetUDPSocketOptions(UDPSocketPair* inPair)
     // used for sending... on UNIX typically the socket buffer size doesn't matter because the
     // packet goes right down to the driver. On Win32 and linux, unless this is really big, we get packet loss.
     inPair->GetSocketA()->SetSocketBufSize(256 * 1024);
+    
+    //
+    // With kernel pacing on, RTP packets carry the time they should go out and the
+    // kernel holds them until then. If the kernel can't do that, streams sent on
+    // this socket are paced by the server as usual.
+    if (QTSServerInterface::GetServer()->GetPrefs()->GetKernelPacingWindowInMsec() > 0)
+        (void)inPair->GetSocketA()->EnableTransmitTime();
+    
+    //
+    // RTP streams on this socket can then hand a burst of same size packets
+    // to the kernel in one send. Where it can't, they go out one by one.
+    if (QTSServerInterface::GetServer()->GetPrefs()->IsUDPSegmentationEnabled())
+        (void)inPair->GetSocketA()->EnableSegmentation();
 
     //
     // Always set the Rcv buf size for the RTCP sockets. This is important because the
@@ -113,6 +113,7 @@ class QTSServer : public QTSServerInterface
         // GLOBAL TASKS
         RTCPTask*           fRTCPTask;
         RTPStatsUpdaterTask*fStatsTask;
+        TaskLatencyTask*    fLatencyTask;
         SessionTimeoutTask  *fSessionTimeoutTask;
         static char*        sPortPrefString;
         static XMLPrefsParser* sPrefsSource;
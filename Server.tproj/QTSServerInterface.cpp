@@ -43,6 +43,8 @@
 #include "UDPSocketPool.h"
 #include "RTSPProtocol.h"
 #include "RTPPacketResender.h"
+#include "OSMemory.h"
+#include "RTSPSession.h"
 #ifndef __MacOSX__
 #include "revision.h"
 #endif
@@ -139,7 +141,18 @@ QTSSAttrInfoDict::AttrInfo  QTSServerInterface::sAttributes[] =
 
     /* 38  */ { "qtssSvrServerBuild",           NULL,   qtssAttrDataTypeCharArray,  qtssAttrModeRead | qtssAttrModePreempSafe },
     /* 39  */ { "qtssSvrServerPlatform",        NULL,   qtssAttrDataTypeCharArray,  qtssAttrModeRead | qtssAttrModePreempSafe },
-    /* 40  */ { "qtssSvrRTSPServerComment",     NULL,   qtssAttrDataTypeCharArray,  qtssAttrModeRead | qtssAttrModePreempSafe }
+    /* 40  */ { "qtssSvrRTSPServerComment",     NULL,   qtssAttrDataTypeCharArray,  qtssAttrModeRead | qtssAttrModePreempSafe },
+    /* 41  */ { "qtssSvrMemorySizeClasses",     NULL,   qtssAttrDataTypeUInt32,     qtssAttrModeRead },
+    /* 42  */ { "qtssSvrMemoryBytesInUse",      NULL,   qtssAttrDataTypeUInt64,     qtssAttrModeRead },
+    /* 43  */ { "qtssSvrMemoryThreadCacheHitPercent", NULL, qtssAttrDataTypeFloat32, qtssAttrModeRead },
+    /* 44  */ { "qtssSvrObjectPoolHighWaterMark", NULL, qtssAttrDataTypeUInt32,     qtssAttrModeRead },
+    /* 45  */ { "qtssSvrObjectPoolHitPercent",  NULL,   qtssAttrDataTypeFloat32,    qtssAttrModeRead },
+    /* 46  */ { "qtssSvrTaskLatencyInMsec",     NULL,   qtssAttrDataTypeUInt32,     qtssAttrModeRead },
+    /* 47  */ { "qtssSvrNumRejectedConnections", NULL,  qtssAttrDataTypeUInt32,     qtssAttrModeRead },
+    /* 48  */ { "qtssSvrNumUDPSegmentedSends",  NULL,   qtssAttrDataTypeUInt64,     qtssAttrModeRead },
+    /* 49  */ { "qtssSvrNumUDPSegmentsSent",    NULL,   qtssAttrDataTypeUInt64,     qtssAttrModeRead },
+    /* 50  */ { "qtssSvrSendWakeupsPerSec",     NULL,   qtssAttrDataTypeUInt32,     qtssAttrModeRead },
+    /* 51  */ { "qtssSvrWastedSendWakeupsPerSec", NULL, qtssAttrDataTypeUInt32,     qtssAttrModeRead }
 };
 
 void    QTSServerInterface::Initialize()
@@ -218,7 +231,17 @@ QTSServerInterface::QTSServerInterface()
     fTotalMP3Bytes(0),
     fAvgMP3BandwidthInBits(0),
     fSigInt(false),
-    fSigTerm(false)
+    fSigTerm(false),
+    fTaskLatencyInMsec(0),
+    fNumRejectedConnections(0),
+    fTotalUDPSegmentedSends(0),
+    fTotalUDPSegmentsSent(0),
+    fPeriodicUDPSegmentedSends(0),
+    fPeriodicUDPSegmentsSent(0),
+    fSendWakeupsPerSecond(0),
+    fWastedSendWakeupsPerSecond(0),
+    fPeriodicSendWakeups(0),
+    fPeriodicWastedSendWakeups(0)
 {
     for (UInt32 y = 0; y < QTSSModule::kNumRoles; y++)
     {
@@ -250,11 +273,25 @@ QTSServerInterface::QTSServerInterface()
     this->SetVal(qtssMP3SvrCurBandwidth,    &fCurrentMP3BandwidthInBits,sizeof(fCurrentMP3BandwidthInBits));
     this->SetVal(qtssMP3SvrTotalBytes,      &fTotalMP3Bytes,            sizeof(fTotalMP3Bytes));
     this->SetVal(qtssMP3SvrAvgBandwidth,    &fAvgMP3BandwidthInBits,    sizeof(fAvgMP3BandwidthInBits));
+    this->SetVal(qtssSvrTaskLatencyInMsec,  &fTaskLatencyInMsec,        sizeof(fTaskLatencyInMsec));
+    this->SetVal(qtssSvrNumRejectedConnections, &fNumRejectedConnections, sizeof(fNumRejectedConnections));
+    this->SetVal(qtssSvrNumUDPSegmentedSends,   &fTotalUDPSegmentedSends,   sizeof(fTotalUDPSegmentedSends));
+    this->SetVal(qtssSvrNumUDPSegmentsSent,     &fTotalUDPSegmentsSent,     sizeof(fTotalUDPSegmentsSent));
+    this->SetVal(qtssSvrSendWakeupsPerSec,      &fSendWakeupsPerSecond,     sizeof(fSendWakeupsPerSecond));
+    this->SetVal(qtssSvrWastedSendWakeupsPerSec, &fWastedSendWakeupsPerSecond, sizeof(fWastedSendWakeupsPerSecond));
 
     this->SetVal(qtssSvrServerBuild,        sServerBuildStr.Ptr,    sServerBuildStr.Len);
     this->SetVal(qtssSvrRTSPServerComment,  sServerCommentStr.Ptr,  sServerCommentStr.Len);
     this->SetVal(qtssSvrServerPlatform,     sServerPlatformStr.Ptr, sServerPlatformStr.Len);
 
+    for (UInt32 theClass = 0; theClass < OSMemory::kNumSizeClasses; theClass++)
+    {
+        UInt32 theClassSize = OSMemory::GetSizeClassSize(theClass);
+        if (theClassSize == 0)
+            break;
+        (void)this->SetValue(qtssSvrMemorySizeClasses, theClass, &theClassSize, sizeof(theClassSize), QTSSDictionary::kDontObeyReadOnly);
+    }
+
     sServer = this;
 }
 
@@ -391,6 +428,21 @@ SInt64 RTPStatsUpdaterTask::Run()
     (void)atomic_sub(&theServer->fPeriodicRTPPacketsLost, periodicPacketsLost);
     theServer->fTotalRTPPacketsLost += periodicPacketsLost;
     
+    // ..and for segmented UDP sends
+    unsigned int periodicSegmentedSends = theServer->fPeriodicUDPSegmentedSends;
+    (void)atomic_sub(&theServer->fPeriodicUDPSegmentedSends, periodicSegmentedSends);
+    theServer->fTotalUDPSegmentedSends += periodicSegmentedSends;
+    
+    unsigned int periodicSegmentsSent = theServer->fPeriodicUDPSegmentsSent;
+    (void)atomic_sub(&theServer->fPeriodicUDPSegmentsSent, periodicSegmentsSent);
+    theServer->fTotalUDPSegmentsSent += periodicSegmentsSent;
+    
+    // ..and RTP session wakeups, which only go into the rates below
+    unsigned int periodicSendWakeups = theServer->fPeriodicSendWakeups;
+    (void)atomic_sub(&theServer->fPeriodicSendWakeups, periodicSendWakeups);
+    unsigned int periodicWastedSendWakeups = theServer->fPeriodicWastedSendWakeups;
+    (void)atomic_sub(&theServer->fPeriodicWastedSendWakeups, periodicWastedSendWakeups);
+    
     SInt64 curTime = OS::Milliseconds();
     
     //for cpu percent
@@ -424,6 +476,10 @@ SInt64 RTPStatsUpdaterTask::Run()
         Assert(packetsPerSecond >= 0);
         theServer->fRTPPacketsPerSecond = (UInt32)packetsPerSecond;
         
+        //and for RTP session wakeups
+        theServer->fSendWakeupsPerSecond = (UInt32)((Float32)periodicSendWakeups / theTime);
+        theServer->fWastedSendWakeupsPerSecond = (UInt32)((Float32)periodicWastedSendWakeups / theTime);
+        
         //do the computation for cpu percent
         Float32 diffTime = cpuTimeInSec - theServer->fCPUTimeUsedInSec;
         theServer->fCPUPercent = (diffTime/theTime) * 100;  
@@ -443,6 +499,9 @@ SInt64 RTPStatsUpdaterTask::Run()
     //for cpu percent
     theServer->fCPUTimeUsedInSec    = cpuTimeInSec; 
     
+    this->UpdateMemoryStats(theServer);
+    this->UpdatePoolStats(theServer);
+    
     //also compute average bandwidth, a much more smooth value. This is done with
     //the fLastBandwidthAvg, a timestamp of the last time we did an average, and
     //fLastBytesSent, the number of bytes sent when we last did an average.
@@ -489,6 +548,39 @@ SInt64 RTPStatsUpdaterTask::Run()
     return theServer->GetPrefs()->GetTotalBytesUpdateTimeInSecs() * 1000;
 }
 
+void RTPStatsUpdaterTask::UpdateMemoryStats(QTSServerInterface* inServer)
+{
+    // Nothing to report if OSMemory was built without the thread cache
+    if (OSMemory::GetSizeClassSize(0) == 0)
+        return;
+        
+    UInt64 theBytesInUse[OSMemory::kNumSizeClasses + 1];
+    Float32 theHitPercents[kMaxMemoryStatThreads];
+    UInt32 theNumThreads = kMaxMemoryStatThreads;
+    OSMemory::GetThreadCacheStats(theBytesInUse, theHitPercents, &theNumThreads);
+    
+    for (UInt32 x = 0; x <= OSMemory::kNumSizeClasses; x++)
+        (void)inServer->SetValue(qtssSvrMemoryBytesInUse, x, &theBytesInUse[x], sizeof(theBytesInUse[x]), QTSSDictionary::kDontObeyReadOnly);
+        
+    for (UInt32 y = 0; y < theNumThreads; y++)
+        (void)inServer->SetValue(qtssSvrMemoryThreadCacheHitPercent, y, &theHitPercents[y], sizeof(theHitPercents[y]), QTSSDictionary::kDontObeyReadOnly);
+    inServer->SetNumValues(qtssSvrMemoryThreadCacheHitPercent, theNumThreads);
+}
+
+void RTPStatsUpdaterTask::UpdatePoolStats(QTSServerInterface* inServer)
+{
+    // Same order as described for qtssSvrObjectPoolHighWaterMark
+    OSBufferPool* thePools[] = { RTSPSession::GetPool(), RTPSession::GetPool(), RTPStream::GetPool() };
+    
+    for (UInt32 x = 0; x < sizeof(thePools) / sizeof(thePools[0]); x++)
+    {
+        UInt32 theHighWaterMark = thePools[x]->GetHighWaterMark();
+        Float32 theHitPercent = thePools[x]->GetHitPercent();
+        (void)inServer->SetValue(qtssSvrObjectPoolHighWaterMark, x, &theHighWaterMark, sizeof(theHighWaterMark), QTSSDictionary::kDontObeyReadOnly);
+        (void)inServer->SetValue(qtssSvrObjectPoolHitPercent, x, &theHitPercent, sizeof(theHitPercent), QTSSDictionary::kDontObeyReadOnly);
+    }
+}
+
 RTPSessionInterface* RTPStatsUpdaterTask::GetNewestSession(OSRefTable* inRTPSessionMap)
 {
     //Caller must lock down the RTP session map
@@ -512,6 +604,45 @@ RTPSessionInterface* RTPStatsUpdaterTask::GetNewestSession(OSRefTable* inRTPSess
 }
 
 
+Bool16 QTSServerInterface::IsOverloaded()
+{
+    UInt32 theMaxLatency = fSrvrPrefs->GetOverloadTaskLatencyInMsec();
+    if ((theMaxLatency > 0) && (fTaskLatencyInMsec >= theMaxLatency))
+        return true;
+
+    UInt32 theMaxQueuedTasks = fSrvrPrefs->GetOverloadQueuedTasks();
+    if ((theMaxQueuedTasks > 0) && (TaskThreadPool::GetNumQueuedTasks() >= theMaxQueuedTasks))
+        return true;
+
+    return false;
+}
+
+TaskLatencyTask::TaskLatencyTask()
+:   Task(), fNextRunTime(0)
+{
+    this->SetTaskName("TaskLatencyTask");
+    this->Signal(Task::kStartEvent);
+}
+
+SInt64 TaskLatencyTask::Run()
+{
+    (void)this->GetEvents();
+
+    QTSServerInterface* theServer = QTSServerInterface::sServer;
+    SInt64 theCurrentTime = OS::Milliseconds();
+
+    UInt32 theLatency = 0;
+    if ((fNextRunTime != 0) && (theCurrentTime > fNextRunTime))
+        theLatency = (UInt32)(theCurrentTime - fNextRunTime);
+
+    // Smooth it, so one slow wakeup doesn't turn connections away
+    // but a few in a row quickly will.
+    theServer->fTaskLatencyInMsec = ((theServer->fTaskLatencyInMsec * 3) + theLatency) / 4;
+
+    fNextRunTime = theCurrentTime + kIntervalInMsec;
+    return kIntervalInMsec;
+}
+
 
 void* QTSServerInterface::CurrentUnixTimeMilli(QTSSDictionary* inServer, UInt32* outLen)
 {
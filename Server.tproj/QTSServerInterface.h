@@ -105,6 +105,15 @@ class QTSServerInterface : public QTSSDictionary
         //total rtp bytes reported as lost by the clients
         void            IncrementTotalRTPPacketsLost(UInt32 packets)
                                         { (void)atomic_add(&fPeriodicRTPPacketsLost, packets); }
+        //RTSP connections the listeners turned away because the server was overloaded
+        void            IncrementNumRejectedConnections()
+                                        { (void)atomic_add(&fNumRejectedConnections, 1); }
+        //a run of inNumSegments RTP packets went out in one segmented UDP send
+        void            IncrementUDPSegmentedSends(UInt32 inNumSegments)
+                                        { (void)atomic_add(&fPeriodicUDPSegmentedSends, 1); (void)atomic_add(&fPeriodicUDPSegmentsSent, inNumSegments); }
+        //a playing RTP session woke up to send. Wasted if it sent nothing.
+        void            IncrementSendWakeups(Bool16 inWasted)
+                                        { (void)atomic_add(&fPeriodicSendWakeups, 1); if (inWasted) (void)atomic_add(&fPeriodicWastedSendWakeups, 1); }
                                         
         // Also increments current RTP session count
         void            IncrementTotalRTPSessions()
@@ -117,6 +126,8 @@ class QTSServerInterface : public QTSSDictionary
         // ACCESSORS
         
         QTSS_ServerState    GetServerState()        { return fServerState; }
+        UInt32              GetNumRTSPSessions()    { return fNumRTSPSessions; }
+        UInt32              GetNumRTSPHTTPSessions(){ return fNumRTSPHTTPSessions; }
         UInt32              GetNumRTPSessions()     { return fNumRTPSessions; }
         UInt32              GetTotalRTPSessions()   { return fTotalRTPSessions; }
         UInt32              GetCurBandwidthInBits() { return fCurrentRTPBandwidthInBits; }
@@ -125,6 +136,10 @@ class QTSServerInterface : public QTSSDictionary
         UInt64              GetTotalRTPBytes()      { return fTotalRTPBytes; }
         UInt64              GetTotalRTPPacketsLost(){ return fTotalRTPPacketsLost; }
         Float32             GetCPUPercent()         { return fCPUPercent; }
+        UInt32              GetTaskLatencyInMsec()  { return fTaskLatencyInMsec; }
+        
+        // True while the task threads are further behind than the overload prefs allow
+        Bool16              IsOverloaded();
         Bool16              SigIntSet()             { return fSigInt; }
         Bool16				SigTermSet()			{ return fSigTerm; }
 		
@@ -324,6 +339,22 @@ class QTSServerInterface : public QTSSDictionary
         Bool16              fSigInt;
         Bool16              fSigTerm;
 
+        // Overload stats, see TaskLatencyTask
+        UInt32              fTaskLatencyInMsec;
+        unsigned int        fNumRejectedConnections;
+        
+        // Segmented UDP send stats, totalled up the same way as the byte counts
+        UInt64              fTotalUDPSegmentedSends;
+        UInt64              fTotalUDPSegmentsSent;
+        unsigned int        fPeriodicUDPSegmentedSends;
+        unsigned int        fPeriodicUDPSegmentsSent;
+        
+        // RTP session wakeup rates, see RTPSession::Run
+        UInt32              fSendWakeupsPerSecond;
+        UInt32              fWastedSendWakeupsPerSecond;
+        unsigned int        fPeriodicSendWakeups;
+        unsigned int        fPeriodicWastedSendWakeups;
+
         // Param retrieval functions
         static void* CurrentUnixTimeMilli(QTSSDictionary* inServer, UInt32* outLen);
         static void* GetTotalUDPSockets(QTSSDictionary* inServer, UInt32* outLen);
@@ -337,6 +368,7 @@ class QTSServerInterface : public QTSSDictionary
         
         friend class RTPStatsUpdaterTask;
         friend class SessionTimeoutTask;
+        friend class TaskLatencyTask;
 };
 
 
@@ -350,9 +382,16 @@ class RTPStatsUpdaterTask : public Task
     
     private:
     
+        enum
+        {
+            kMaxMemoryStatThreads = 256    // most threads reported in qtssSvrMemoryThreadCacheHitPercent
+        };
+        
         virtual SInt64 Run();
         RTPSessionInterface* GetNewestSession(OSRefTable* inRTPSessionMap);
                 Float32 GetCPUTimeInSeconds();
+        void    UpdateMemoryStats(QTSServerInterface* inServer);
+        void    UpdatePoolStats(QTSServerInterface* inServer);
         
         SInt64 fLastBandwidthTime;
         SInt64 fLastBandwidthAvg;
@@ -360,6 +399,28 @@ class RTPStatsUpdaterTask : public Task
         SInt64 fLastTotalMP3Bytes;
 };
 
+class TaskLatencyTask : public Task
+{
+    public:
+    
+        // This class wakes up on a short fixed interval and measures how late it
+        // gets run. That is how long any task signalled now has to wait for a
+        // task thread, so the RTSP listeners use it to spot an overloaded server.
+        TaskLatencyTask();
+        virtual ~TaskLatencyTask() {}
+    
+    private:
+    
+        enum
+        {
+            kIntervalInMsec = 100   // UInt32
+        };
+        
+        virtual SInt64 Run();
+        
+        SInt64 fNextRunTime;
+};
+
 
 
 #endif // __QTSSERVERINTERFACE_H__
@@ -133,7 +133,12 @@ QTSServerPrefs::PrefInfo QTSServerPrefs::sPrefInfo[] =
 	{ kDontAllowMultipleValues, "0",        NULL                    },  //run_num_threads
     { kDontAllowMultipleValues, DEFAULTPATHS_PID_DIR PLATFORM_SERVER_BIN_NAME ".pid",	NULL	},	//pid_file
     { kDontAllowMultipleValues, "false",    NULL                    },   //force_logs_close_on_write
-    { kDontAllowMultipleValues, "true",    NULL                     }   //enable_rtsp_play_info_full_url
+    { kDontAllowMultipleValues, "true",    NULL                     },  //enable_rtsp_play_info_full_url
+    { kDontAllowMultipleValues, "500",      NULL                    },  //overload_task_latency
+    { kDontAllowMultipleValues, "10000",    NULL                    },  //overload_queued_tasks
+    { kDontAllowMultipleValues, "0",        NULL                    },  //kernel_pacing_window
+    { kDontAllowMultipleValues, "true",     NULL                    },  //enable_udp_segmentation
+    { kDontAllowMultipleValues, "true",     NULL                    }   //enable_rtcp_mux
 
 };
 
@@ -210,7 +215,12 @@ QTSSAttrInfoDict::AttrInfo  QTSServerPrefs::sAttributes[] =
 	/* 66 */ { "run_num_threads",                       NULL,                   qtssAttrDataTypeUInt32,     qtssAttrModeRead | qtssAttrModeWrite },
 	/* 67 */ { "pid_file",								NULL,					qtssAttrDataTypeCharArray,	qtssAttrModeRead | qtssAttrModeWrite },
     /* 68 */ { "force_logs_close_on_write",             NULL,                   qtssAttrDataTypeBool16,     qtssAttrModeRead | qtssAttrModeWrite },
-    /* 69 */ { "enable_rtsp_play_info_full_url",        NULL,                   qtssAttrDataTypeBool16,     qtssAttrModeRead | qtssAttrModeWrite }
+    /* 69 */ { "enable_rtsp_play_info_full_url",        NULL,                   qtssAttrDataTypeBool16,     qtssAttrModeRead | qtssAttrModeWrite },
+    /* 70 */ { "overload_task_latency",                 NULL,                   qtssAttrDataTypeUInt32,     qtssAttrModeRead | qtssAttrModeWrite },
+    /* 71 */ { "overload_queued_tasks",                 NULL,                   qtssAttrDataTypeUInt32,     qtssAttrModeRead | qtssAttrModeWrite },
+    /* 72 */ { "kernel_pacing_window",                  NULL,                   qtssAttrDataTypeUInt32,     qtssAttrModeRead | qtssAttrModeWrite },
+    /* 73 */ { "enable_udp_segmentation",               NULL,                   qtssAttrDataTypeBool16,     qtssAttrModeRead | qtssAttrModeWrite },
+    /* 74 */ { "enable_rtcp_mux",                       NULL,                   qtssAttrDataTypeBool16,     qtssAttrModeRead | qtssAttrModeWrite }
 
 };
 
@@ -278,7 +288,12 @@ QTSServerPrefs::QTSServerPrefs(XMLPrefsParser* inPrefsSource, Bool16 inWriteMiss
     fEnablePacketHeaderPrintfs(false),   
     fPacketHeaderPrintfOptions(kRTPALL | kRTCPSR | kRTCPRR | kRTCPAPP | kRTCPACK),
     fCloseLogsOnWrite(false),
-    fRTSPPlayInfoFullURL(false)    
+    fRTSPPlayInfoFullURL(false),
+    fOverloadTaskLatencyInMsec(0),
+    fOverloadQueuedTasks(0),
+    fKernelPacingWindowInMsec(0),
+    fUDPSegmentationEnabled(true),
+    fRTCPMuxEnabled(true)
 {
     SetupAttributes();
     RereadServerPreferences(inWriteMissingPrefs);
@@ -357,6 +372,11 @@ void QTSServerPrefs::SetupAttributes()
     this->SetVal(qtssPrefsCloseLogsOnWrite,             &fCloseLogsOnWrite,             sizeof(fCloseLogsOnWrite));
 	this->SetVal(qtssPrefsOverbufferRate,				&fOverbufferRate,				sizeof(fOverbufferRate));
     this->SetVal(qtssPrefsRTSPPlayInfoFullURL,          &fRTSPPlayInfoFullURL,          sizeof(fRTSPPlayInfoFullURL));
+    this->SetVal(qtssPrefsOverloadTaskLatencyInMsec,    &fOverloadTaskLatencyInMsec,    sizeof(fOverloadTaskLatencyInMsec));
+    this->SetVal(qtssPrefsOverloadQueuedTasks,          &fOverloadQueuedTasks,          sizeof(fOverloadQueuedTasks));
+    this->SetVal(qtssPrefsKernelPacingWindowInMsec,     &fKernelPacingWindowInMsec,     sizeof(fKernelPacingWindowInMsec));
+    this->SetVal(qtssPrefsEnableUDPSegmentation,        &fUDPSegmentationEnabled,       sizeof(fUDPSegmentationEnabled));
+    this->SetVal(qtssPrefsEnableRTCPMux,                &fRTCPMuxEnabled,               sizeof(fRTCPMuxEnabled));
 
 }
 
@@ -193,6 +193,19 @@ class QTSServerPrefs : public QTSSPrefs
                 
         UInt32  GetNumThreads()             { return fNumThreads; }
         
+        // Past either of these the RTSP listeners turn new connections away. 0 means no limit.
+        UInt32  GetOverloadTaskLatencyInMsec()  { return fOverloadTaskLatencyInMsec; }
+        UInt32  GetOverloadQueuedTasks()        { return fOverloadQueuedTasks; }
+        
+        // How far ahead UDP packets may be handed to the kernel to send on time. 0 means off.
+        UInt32  GetKernelPacingWindowInMsec()   { return fKernelPacingWindowInMsec; }
+        
+        // Whether runs of same size RTP packets may go out in one segmented UDP send
+        Bool16  IsUDPSegmentationEnabled()      { return fUDPSegmentationEnabled; }
+        
+        // Whether a client asking for rtcp-mux in its SETUP gets it
+        Bool16  IsRTCPMuxEnabled()              { return fRTCPMuxEnabled; }
+        
     private:
 
         UInt32      fRTSPTimeoutInSecs;
@@ -264,6 +277,11 @@ class QTSServerPrefs : public QTSSPrefs
         UInt32  fPacketHeaderPrintfOptions;
         Bool16  fCloseLogsOnWrite;
         Bool16  fRTSPPlayInfoFullURL;
+        UInt32  fOverloadTaskLatencyInMsec;
+        UInt32  fOverloadQueuedTasks;
+        UInt32  fKernelPacingWindowInMsec;
+        Bool16  fUDPSegmentationEnabled;
+        Bool16  fRTCPMuxEnabled;
         enum //fPacketHeaderPrintfOptions
         {
             kRTPALL = 1 << 0,
@@ -53,7 +53,8 @@ RTPOverbufferWindow::RTPOverbufferWindow(UInt32 inSendInterval, UInt32 inInitial
 	fOverbufferingEnabled(true),
 	fOverbufferRate(inOverbufferRate),
 	fSendAheadDurationInMsec(1000),
-	fOverbufferWindowBegin(-1)
+	fOverbufferWindowBegin(-1),
+	fKernelPacingWindow(0)
 {
     if (fSendInterval == 0)
     {
@@ -91,8 +92,13 @@ SInt64 RTPOverbufferWindow::CheckTransmitTime(const SInt64& inTransmitTime, cons
 	if (fOverbufferWindowBegin == -1)
 		fOverbufferWindowBegin = inCurrentTime;
 	
-	if ((inTransmitTime <= inCurrentTime + fSendInterval) || 
-		(fOverbufferingEnabled && (inTransmitTime <= inCurrentTime + fSendInterval + fSendAheadDurationInMsec)))
+	// If the kernel paces the packets, hand them over as far ahead as it allows
+	SInt32 theSendWindow = fSendInterval;
+	if (fKernelPacingWindow > theSendWindow)
+		theSendWindow = fKernelPacingWindow;
+
+	if ((inTransmitTime <= inCurrentTime + theSendWindow) || 
+		(fOverbufferingEnabled && (inTransmitTime <= inCurrentTime + theSendWindow + fSendAheadDurationInMsec)))
     {
         //
         // If this happens, this packet needs to be sent regardless of overbuffering
@@ -147,6 +153,22 @@ SInt64 RTPOverbufferWindow::CheckTransmitTime(const SInt64& inTransmitTime, cons
     return -1;  // send this packet
 }
 
+SInt64 RTPOverbufferWindow::GetKernelSendTime(const SInt64& inTransmitTime, const SInt64& inCurrentTime)
+{
+    if (fKernelPacingWindow == 0)
+        return 0;
+        
+    // Overbuffered packets are meant to go out this far ahead of their transmit time
+    SInt64 theSendTime = inTransmitTime;
+    if (fOverbufferingEnabled)
+        theSendTime -= fSendAheadDurationInMsec;
+        
+    // Packets let through to get further ahead shouldn't be held longer than the window
+    if (theSendTime > inCurrentTime + fKernelPacingWindow)
+        theSendTime = inCurrentTime + fKernelPacingWindow;
+    return theSendTime;
+}
+
 void RTPOverbufferWindow::ResetOverBufferWindow()
 {
     fBytesDuringLastSecond = 0;
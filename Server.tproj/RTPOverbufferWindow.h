@@ -93,6 +93,15 @@ class RTPOverbufferWindow
         // is above the play rate.
         void MarkBeginningOfWriteBurst() { fWriteBurstBeginning = true; }       
 
+        //
+        // Kernel pacing
+        // If packets are sent on a socket the kernel paces (see UDPSocket::EnableTransmitTime),
+        // set how far ahead of time they may be handed over. CheckTransmitTime then lets
+        // packets through up to this far ahead, and GetKernelSendTime says when each should
+        // actually leave. Packets the server would have sent anyway leave right away.
+        void    SetKernelPacingWindow(UInt32 inWindowInMsec) { fKernelPacingWindow = inWindowInMsec; }
+        SInt64  GetKernelSendTime(const SInt64& inTransmitTime, const SInt64& inCurrentTime);
+
     private:
         
         SInt32 fWindowSize;
@@ -121,6 +130,7 @@ class RTPOverbufferWindow
 		UInt32 fSendAheadDurationInMsec;
 		
 		SInt64 fOverbufferWindowBegin;
+		SInt32 fKernelPacingWindow;
 
 };
 
@@ -72,11 +72,12 @@ class MyAckListLog : public QTSSRollingLog
 };
 #endif
 
-static const UInt32 kPacketArrayIncreaseInterval = 32;// must be multiple of 2
-static const UInt32 kInitialPacketArraySize = 64;// must be multiple of kPacketArrayIncreaseInterval (Turns out this is as big as we typically need)
-//static const UInt32 kMaxPacketArraySize = 512;// must be multiple of kPacketArrayIncreaseInterval it would have to be a 3 mbit or more
+static const UInt32 kInitialPacketArraySize = 64;// must be a power of 2 (Turns out this is as big as we typically need)
+static const UInt32 kMaxPacketArraySize = 32768;// half the sequence number space
+static const UInt32 kNoPacketIndex = 0xFFFFFFFF;
 
 static const UInt32 kMaxDataBufferSize = 1600;
+static const UInt32 kRTPHeaderSize = 12;
 OSBufferPool RTPPacketResender::sBufferPool(kMaxDataBufferSize);
 unsigned int    RTPPacketResender::sNumWastedBytes = 0;
 
@@ -93,9 +94,9 @@ RTPPacketResender::RTPPacketResender()
     fNumSent(0),
     fPacketArray(NULL),
     fPacketArraySize(kInitialPacketArraySize),
-    fPacketArrayMask(0),
-    fHighestSeqNum(0),
-    fLastUsed(0),
+    fPacketArrayMask(kInitialPacketArraySize - 1),
+    fOldestIndex(kNoPacketIndex),
+    fNewestIndex(kNoPacketIndex),
     fPacketQMutex()
 {
     fPacketArray = (RTPResenderEntry*) NEW char[sizeof(RTPResenderEntry) * fPacketArraySize];
@@ -106,19 +107,9 @@ RTPPacketResender::RTPPacketResender()
 RTPPacketResender::~RTPPacketResender()
 {
     for (UInt32 x = 0; x < fPacketArraySize; x++)
-    {
-        if (fPacketArray[x].fPacketSize > 0)
-            atomic_sub(&sNumWastedBytes, kMaxDataBufferSize - fPacketArray[x].fPacketSize);
-        if (fPacketArray[x].fPacketData != NULL)
-        {
-            if (fPacketArray[x].fIsSpecialBuffer)
-                delete [] (char*)fPacketArray[x].fPacketData;
-            else
-                sBufferPool.Put(fPacketArray[x].fPacketData);
-        }
-    }
+        this->FreePacketData(&fPacketArray[x]);
             
-    delete [] fPacketArray;
+    delete [] (char*)fPacketArray;
     
 
 }
@@ -226,54 +217,147 @@ void RTPPacketResender::SetDestination(UDPSocket* inOutputSocket, UInt32 inDestA
     fDestPort = inDestPort;
 }
 
-RTPResenderEntry*   RTPPacketResender::GetEmptyEntry(UInt16 inSeqNum, UInt32 inPacketSize)
+RTPResenderEntry* RTPPacketResender::GetEntryBySeqNum(UInt16 inSeqNum)
 {
-    
-    RTPResenderEntry* theEntry = NULL;
-    
-    for (UInt32 packetIndex = 0 ;packetIndex < fPacketsInList; packetIndex++) // see if packet is already in the array
-    {   if (inSeqNum == fPacketArray[packetIndex].fSeqNum)
-        {   return NULL;
+    RTPResenderEntry* theEntry = &fPacketArray[inSeqNum & fPacketArrayMask];
+    if ((theEntry->fPacketSize == 0) || (theEntry->fSeqNum != inSeqNum))
+        return NULL;
+    return theEntry;
+}
+
+void RTPPacketResender::LinkAsNewest(UInt32 packetIndex)
+{
+    RTPResenderEntry* theEntry = &fPacketArray[packetIndex];
+    theEntry->fPrevIndex = fNewestIndex;
+    theEntry->fNextIndex = kNoPacketIndex;
+    if (fNewestIndex != kNoPacketIndex)
+        fPacketArray[fNewestIndex].fNextIndex = packetIndex;
+    else
+        fOldestIndex = packetIndex;
+    fNewestIndex = packetIndex;
+}
+
+void RTPPacketResender::Unlink(UInt32 packetIndex)
+{
+    RTPResenderEntry* theEntry = &fPacketArray[packetIndex];
+    if (theEntry->fPrevIndex != kNoPacketIndex)
+        fPacketArray[theEntry->fPrevIndex].fNextIndex = theEntry->fNextIndex;
+    else
+        fOldestIndex = theEntry->fNextIndex;
+    if (theEntry->fNextIndex != kNoPacketIndex)
+        fPacketArray[theEntry->fNextIndex].fPrevIndex = theEntry->fPrevIndex;
+    else
+        fNewestIndex = theEntry->fPrevIndex;
+}
+
+Bool16 RTPPacketResender::ReallocatePacketArray(UInt32 inNewSize, UInt16 inSeqNum)
+{
+    UInt32 theNewMask = inNewSize - 1;
+    RTPResenderEntry* tempArray = (RTPResenderEntry*) NEW char[sizeof(RTPResenderEntry) * inNewSize];
+    ::memset(tempArray,0,sizeof(RTPResenderEntry) * inNewSize);
+
+    //
+    // Move the packets over oldest first, keeping the send order list intact.
+    // If two of them (or one of them and inSeqNum) still share a slot, this size won't do.
+    UInt32 theNewOldest = kNoPacketIndex;
+    UInt32 theNewNewest = kNoPacketIndex;
+    for (UInt32 theIndex = fOldestIndex; theIndex != kNoPacketIndex; theIndex = fPacketArray[theIndex].fNextIndex)
+    {
+        UInt32 theNewIndex = fPacketArray[theIndex].fSeqNum & theNewMask;
+        if ((tempArray[theNewIndex].fPacketSize > 0) || (theNewIndex == (UInt32)(inSeqNum & theNewMask)))
+        {
+            delete [] (char*)tempArray;
+            return false;
         }
+        tempArray[theNewIndex] = fPacketArray[theIndex];
+        tempArray[theNewIndex].fPrevIndex = theNewNewest;
+        tempArray[theNewIndex].fNextIndex = kNoPacketIndex;
+        if (theNewNewest != kNoPacketIndex)
+            tempArray[theNewNewest].fNextIndex = theNewIndex;
+        else
+            theNewOldest = theNewIndex;
+        theNewNewest = theNewIndex;
     }
 
-    if (fPacketsInList == fPacketArraySize) // allocate a new array
+    delete [] (char*)fPacketArray;
+    fPacketArray = tempArray;
+    fPacketArraySize = inNewSize;
+    fPacketArrayMask = theNewMask;
+    fOldestIndex = theNewOldest;
+    fNewestIndex = theNewNewest;
+    //qtss_printf("NewArray size=%ld packetsInList=%ld\n",fPacketArraySize, fPacketsInList);
+    return true;
+}
+
+Bool16 RTPPacketResender::GrowPacketArray(UInt16 inSeqNum)
+{
+    for (UInt32 theNewSize = fPacketArraySize * 2; theNewSize <= kMaxPacketArraySize; theNewSize *= 2)
     {
-        fPacketArraySize += kPacketArrayIncreaseInterval;
-        RTPResenderEntry* tempArray = (RTPResenderEntry*) NEW char[sizeof(RTPResenderEntry) * fPacketArraySize];
-        ::memset(tempArray,0,sizeof(RTPResenderEntry) * fPacketArraySize);
-        ::memcpy(tempArray,fPacketArray,sizeof(RTPResenderEntry) * fPacketsInList);
-        delete [] fPacketArray;
-        fPacketArray = tempArray;
-        //qtss_printf("NewArray size=%ld packetsInList=%ld\n",fPacketArraySize, fPacketsInList);
+        if (this->ReallocatePacketArray(theNewSize, inSeqNum))
+            return true;
     }
+    return false;
+}
 
-    if (fPacketsInList <  fPacketArraySize) // have an open spot
-    {   theEntry = &fPacketArray[fPacketsInList];
-        fPacketsInList++;
-        
-        if (fPacketsInList < fPacketArraySize)
-            fLastUsed = fPacketsInList;
-        else
-            fLastUsed = fPacketArraySize;
+void RTPPacketResender::FreePacketData(RTPResenderEntry* inEntry)
+{
+    if (inEntry->fSharedBuffer != NULL)
+    {
+        inEntry->fSharedBuffer->Release();
+        return;
     }
-    else 
+    
+    //
+    // Track the number of wasted bytes we have
+    if (inEntry->fPacketSize > 0)
+        atomic_sub(&sNumWastedBytes, kMaxDataBufferSize - inEntry->fPacketSize);
+
+    if (inEntry->fIsSpecialBuffer)
+        delete [] (char*)inEntry->fPacketData;
+    else if (inEntry->fPacketData != NULL)
+        sBufferPool.Put(inEntry->fPacketData);
+}
+
+RTPResenderEntry*   RTPPacketResender::GetEmptyEntry(UInt16 inSeqNum, UInt32 inPacketSize, OSSharedBuffer* inSharedBuffer)
+{
+    UInt32 theIndex = inSeqNum & fPacketArrayMask;
+    RTPResenderEntry* theEntry = &fPacketArray[theIndex];
+    if (theEntry->fPacketSize > 0)
     {
-        // nothing open so re-use 
-        if (fLastUsed < fPacketArraySize - 1)
-            fLastUsed ++;
+        if (theEntry->fSeqNum == inSeqNum) // packet is already in the array
+            return NULL;
+
+        //
+        // The slot still holds a packet sent a whole ring size ago. Grow the ring
+        // so both fit, or if it is as big as it gets, let the old packet go.
+        if (this->GrowPacketArray(inSeqNum))
+        {
+            theIndex = inSeqNum & fPacketArrayMask;
+            theEntry = &fPacketArray[theIndex];
+        }
         else
-            fLastUsed = 0;
-            
-        //qtss_printf("array is full = %lu reusing index=%lu\n",fPacketsInList,fLastUsed); 
-        theEntry = &fPacketArray[fLastUsed];
-        RemovePacket(fLastUsed, false); // delete packet in place don't fill we will use the spot
+        {
+            //qtss_printf("array is full = %lu reusing index=%lu\n",fPacketsInList,theIndex);
+            this->RemovePacket(theIndex, true); // keep the window available
+        }
     }
+    Assert(theEntry->fPacketSize == 0);
+
+    theEntry->fSeqNum = inSeqNum;
+    this->LinkAsNewest(theIndex);
+    fPacketsInList++;
             
     //
+    // If the packet is in a shared buffer, just hang on to that. Retransmits of
+    // these go through a buffer on the stack, so this only works up to kMaxDataBufferSize.
     // Check to see if this packet is too big for the buffer. If it is, then
     // we need to specially allocate a special buffer
-    if (inPacketSize > kMaxDataBufferSize)
+    if ((inSharedBuffer != NULL) && (inPacketSize >= kRTPHeaderSize) && (inPacketSize <= kMaxDataBufferSize))
+    {
+        inSharedBuffer->Retain();
+        theEntry->fSharedBuffer = inSharedBuffer;
+    }
+    else if (inPacketSize > kMaxDataBufferSize)
     {
         //sBufferPool.Put(theEntry->fPacketData);
         theEntry->fIsSpecialBuffer = true;
@@ -290,23 +374,28 @@ RTPResenderEntry*   RTPPacketResender::GetEmptyEntry(UInt16 inSeqNum, UInt32 inP
 }
 
 
+SInt64 RTPPacketResender::GetNextResendTime()
+{
+    //
+    // The oldest packet in send order is the first one due
+    if ((fPacketsInList <= 0) || (fOldestIndex == kNoPacketIndex))
+        return 0;
+    return fPacketArray[fOldestIndex].fAddedTime + fBandwidthTracker->CurRetransmitTimeout() + 1;
+}
+
 void RTPPacketResender::ClearOutstandingPackets()
 {   
     //OSMutexLocker packetQLocker(&fPacketQMutex);
-    //for (UInt16 packetIndex = 0; packetIndex < fPacketArraySize; packetIndex++) //Testing purposes
-    for (UInt16 packetIndex = 0; packetIndex < fPacketsInList; packetIndex++)
-    {
-        this->RemovePacket(packetIndex,false);// don't move packets delete in place
-        Assert(fPacketArray[packetIndex].fPacketSize==0);
-    }
+    while (fOldestIndex != kNoPacketIndex)
+        this->RemovePacket(fOldestIndex, true);
+
     if (fBandwidthTracker != NULL)
         fBandwidthTracker->EmptyWindow(fBandwidthTracker->BytesInList()); //clean it out
-    fPacketsInList = 0; // deleting in place doesn't decrement
     
     Assert(fPacketsInList == 0);
 }
 
-void RTPPacketResender::AddPacket( void * inRTPPacket, UInt32 packetSize, SInt32 ageLimit )
+void RTPPacketResender::AddPacket( void * inRTPPacket, UInt32 packetSize, SInt32 ageLimit, OSSharedBuffer* inSharedBuffer )
 {
     //OSMutexLocker packetQLocker(&fPacketQMutex);
     // the caller needs to adjust the overall age limit by reducing it
@@ -319,7 +408,7 @@ void RTPPacketResender::AddPacket( void * inRTPPacket, UInt32 packetSize, SInt32
     
     if ( ageLimit > 0 )
     {   
-        RTPResenderEntry* theEntry = this->GetEmptyEntry(theSeqNum, packetSize);
+        RTPResenderEntry* theEntry = this->GetEmptyEntry(theSeqNum, packetSize, inSharedBuffer);
 
         //
         // This may happen if this sequence number has already been added.
@@ -329,7 +418,20 @@ void RTPPacketResender::AddPacket( void * inRTPPacket, UInt32 packetSize, SInt32
             
         //
         // Reset all the information in the RTPResenderEntry
-        ::memcpy(theEntry->fPacketData, inRTPPacket, packetSize);
+        if (theEntry->fSharedBuffer != NULL)
+        {
+            // The owner of the buffer may rewrite the header for other clients, but never the payload
+            theEntry->fPacketData = inRTPPacket;
+            ::memcpy(theEntry->fHeader, inRTPPacket, kRTPHeaderSize);
+        }
+        else
+        {
+            ::memcpy(theEntry->fPacketData, inRTPPacket, packetSize);
+            
+            //
+            // Track the number of wasted bytes we have
+            atomic_add(&sNumWastedBytes, kMaxDataBufferSize - packetSize);
+        }
         theEntry->fPacketSize = packetSize;
         theEntry->fAddedTime = OS::Milliseconds();
         theEntry->fOrigRetransTimeout = fBandwidthTracker->CurRetransmitTimeout();
@@ -337,10 +439,6 @@ void RTPPacketResender::AddPacket( void * inRTPPacket, UInt32 packetSize, SInt32
         theEntry->fNumResends = 0;
         theEntry->fSeqNum = theSeqNum;
         
-        //
-        // Track the number of wasted bytes we have
-        atomic_add(&sNumWastedBytes, kMaxDataBufferSize - packetSize);
-        
         //PLDoubleLinkedListNode<RTPResenderEntry> * listNode = NEW PLDoubleLinkedListNode<RTPResenderEntry>( new RTPResenderEntry(inRTPPacket, packetSize, ageLimit, fRTTEstimator.CurRetransmitTimeout() ) );
         //fAckList.AddNodeToTail(listNode);
         fBandwidthTracker->FillWindow(packetSize);
@@ -359,20 +457,9 @@ void RTPPacketResender::AckPacket( UInt16 inSeqNum, SInt64& inCurTimeInMsec )
 {
     //OSMutexLocker packetQLocker(&fPacketQMutex);
     
-    SInt32 foundIndex = -1;
-    for (UInt32 packetIndex = 0 ;packetIndex < fPacketsInList; packetIndex++)
-    {   if (inSeqNum == fPacketArray[packetIndex].fSeqNum)
-        {   foundIndex = packetIndex;
-            break;
-        }
-    }
-    
-    RTPResenderEntry* theEntry = NULL;
-    if (foundIndex != -1)
-        theEntry = &fPacketArray[foundIndex];
-
+    RTPResenderEntry* theEntry = this->GetEntryBySeqNum(inSeqNum);
 
-    if (theEntry == NULL || theEntry->fPacketSize == 0 )
+    if (theEntry == NULL)
     {   /*  we got an ack for a packet that has already expired or
             for a packet whose re-transmit crossed with it's original ack
     
@@ -429,11 +516,11 @@ void RTPPacketResender::AckPacket( UInt16 inSeqNum, SInt64& inCurTimeInMsec )
             , (long)fTrackID, theEntry->fPacketSize, OS::Milliseconds() );
     #endif
         }
-        this->RemovePacket(foundIndex);
+        this->RemovePacket(inSeqNum & fPacketArrayMask);
     }
 }
 
-void RTPPacketResender::RemovePacket(UInt32 packetIndex, Bool16 reuseIndex)
+void RTPPacketResender::RemovePacket(UInt32 packetIndex, Bool16 emptyWindow)
 {
     //OSMutexLocker packetQLocker(&fPacketQMutex);
 
@@ -448,35 +535,18 @@ void RTPPacketResender::RemovePacket(UInt32 packetIndex, Bool16 reuseIndex)
     if (theEntry->fPacketSize == 0)
         return;
         
-    //
-    // Track the number of wasted bytes we have
-    atomic_sub(&sNumWastedBytes, kMaxDataBufferSize - theEntry->fPacketSize);
-    Assert(theEntry->fPacketSize > 0);
-
     //
     // Update our list information
     Assert(fPacketsInList > 0);
     
-    if (theEntry->fIsSpecialBuffer)
-    {   delete [] (char*)theEntry->fPacketData;
-    }
-    else if (theEntry->fPacketData != NULL)
-        sBufferPool.Put(theEntry->fPacketData);
+    this->FreePacketData(theEntry);
         
-
-    if (reuseIndex) // we are re-using the space so keep array contiguous
-    {
-        fPacketArray[packetIndex] = fPacketArray[fPacketsInList -1]; 
-        ::memset(&fPacketArray[fPacketsInList -1],0,sizeof(RTPResenderEntry));
-        fPacketsInList--;
-
-    }
-    else    // the array is full
-    {
+    if (emptyWindow) // the packet is being thrown away without an ack
         fBandwidthTracker->EmptyWindow( theEntry->fPacketSize, false ); // keep window available
-        ::memset(theEntry,0,sizeof(RTPResenderEntry));
-    }
-    
+
+    this->Unlink(packetIndex);
+    ::memset(theEntry,0,sizeof(RTPResenderEntry));
+    fPacketsInList--;
 }
 
 void RTPPacketResender::ResendDueEntries()
@@ -489,69 +559,220 @@ void RTPPacketResender::ResendDueEntries()
     SInt32 numResends = 0;
     RTPResenderEntry* theEntry = NULL; 
     SInt64 curTime = OS::Milliseconds();
-    for (SInt32 packetIndex = fPacketsInList -1; packetIndex >= 0; packetIndex--) // walk backwards because remove packet moves array members forward
+    
+    //
+    // The list is in the order packets were last sent, so stop at the first one
+    // that isn't due. Resent packets go to the back of the list, so also stop
+    // once we get past the packets that were in it when we started.
+    UInt32 theLastIndex = fNewestIndex;
+    UInt32 theNextIndex = fOldestIndex;
+    while (theNextIndex != kNoPacketIndex)
     {
+        UInt32 packetIndex = theNextIndex;
         theEntry = &fPacketArray[packetIndex];
+        theNextIndex = (packetIndex == theLastIndex) ? kNoPacketIndex : theEntry->fNextIndex;
         
-        if (theEntry->fPacketSize == 0) 
-            continue;
+        if ((curTime - theEntry->fAddedTime) <= fBandwidthTracker->CurRetransmitTimeout())
+            break;
         
-        if ((curTime - theEntry->fAddedTime) > fBandwidthTracker->CurRetransmitTimeout())
+        // Change:  Only expire packets after they were due to be resent. This gives the client
+        // a chance to ack them and improves congestion avoidance and RTT calculation
+        if (curTime > theEntry->fExpireTime)
         {
-            // Change:  Only expire packets after they were due to be resent. This gives the client
-            // a chance to ack them and improves congestion avoidance and RTT calculation
-            if (curTime > theEntry->fExpireTime)
-            {
     #if RTP_PACKET_RESENDER_DEBUGGING   
-                unsigned char version;
-                version = *((char*)theEntry->fPacketData);
-                version &= 0x84;    // grab most sig 2 bits
-                version = version >> 6; // shift by 6 bits
-                this->logprintf( "expired:  seq number %li, track id %li (port: %li), vers # %li, pack seq # %li, size: %li, OS::Msecs: %qd\n", \
-                                    (long)ntohs( *((UInt16*)(((char*)theEntry->fPacketData)+2)) ), fTrackID,  (long) ntohs(fDestPort), \
-                                    (long)version, (long)ntohs( *((UInt16*)(((char*)theEntry->fPacketData)+2))), theEntry->fPacketSize, OS::Milliseconds() );
+            unsigned char version;
+            version = *((char*)theEntry->fPacketData);
+            version &= 0x84;    // grab most sig 2 bits
+            version = version >> 6; // shift by 6 bits
+            this->logprintf( "expired:  seq number %li, track id %li (port: %li), vers # %li, pack seq # %li, size: %li, OS::Msecs: %qd\n", \
+                                (long)ntohs( *((UInt16*)(((char*)theEntry->fPacketData)+2)) ), fTrackID,  (long) ntohs(fDestPort), \
+                                (long)version, (long)ntohs( *((UInt16*)(((char*)theEntry->fPacketData)+2))), theEntry->fPacketSize, OS::Milliseconds() );
     #endif
-                //
-                // This packet is expired
-                fNumExpired++;
-                //qtss_printf("Packet expired: %d\n", ((UInt16*)thePacket)[1]);
-                fBandwidthTracker->EmptyWindow(theEntry->fPacketSize);
-                this->RemovePacket(packetIndex);
-//              qtss_printf("Expired packet %d\n", theEntry->fSeqNum);
-                continue;
-            }
-            
-            // Resend this packet
+            //
+            // This packet is expired
+            fNumExpired++;
+            //qtss_printf("Packet expired: %d\n", ((UInt16*)thePacket)[1]);
+            fBandwidthTracker->EmptyWindow(theEntry->fPacketSize);
+            this->RemovePacket(packetIndex);
+//          qtss_printf("Expired packet %d\n", theEntry->fSeqNum);
+            continue;
+        }
+        
+        // Resend this packet
+        if (theEntry->fSharedBuffer != NULL)
+        {
+            // Put back the header as it was when we first sent it
+            char theResendBuffer[kMaxDataBufferSize];
+            ::memcpy(theResendBuffer, theEntry->fHeader, kRTPHeaderSize);
+            ::memcpy(theResendBuffer + kRTPHeaderSize, (char*)theEntry->fPacketData + kRTPHeaderSize, theEntry->fPacketSize - kRTPHeaderSize);
+            fSocket->SendTo(fDestAddr, fDestPort, theResendBuffer, theEntry->fPacketSize);
+        }
+        else
             fSocket->SendTo(fDestAddr, fDestPort, theEntry->fPacketData, theEntry->fPacketSize);
-            //qtss_printf("Packet resent: %d\n", ((UInt16*)theEntry->fPacketData)[1]);
+        //qtss_printf("Packet resent: %d\n", ((UInt16*)theEntry->fPacketData)[1]);
 
-            theEntry->fNumResends++;
+        theEntry->fNumResends++;
     #if RTP_PACKET_RESENDER_DEBUGGING   
-            this->logprintf( "re-sent: %li RTO %li, track id %li (port %li), size: %li, OS::Ms %qd\n", (long)ntohs( *((UInt16*)(((char*)theEntry->fPacketData)+2)) ),  curTime - theEntry->fAddedTime, \
-                    fTrackID, (long) ntohs(fDestPort) \
-                    , theEntry->fPacketSize, OS::Milliseconds());
+        this->logprintf( "re-sent: %li RTO %li, track id %li (port %li), size: %li, OS::Ms %qd\n", (long)ntohs( *((UInt16*)(((char*)theEntry->fPacketData)+2)) ),  curTime - theEntry->fAddedTime, \
+                fTrackID, (long) ntohs(fDestPort) \
+                , theEntry->fPacketSize, OS::Milliseconds());
     #endif      
 
-            fNumResends++;
-            
-            numResends ++;
-            //qtss_printf("resend loop numResends=%ld packet theEntry->fNumResends=%ld stream fNumResends=\n",numResends,theEntry->fNumResends++, fNumResends);
-                        
-            // ok -- lets try this.. add 1.5x of the INITIAL duration since the last send to the rto estimator
-            // since we won't get an ack on this packet
-            // this should keep us from exponentially increasing due o a one time increase
-            // in the actuall rtt, only AddToEstimate on the first resend ( assume that it's a dupe )
-            // if it's not a dupe, but rather an actual loss, the subseqnuent actuals wil bring down the average quickly
-            
-            if ( theEntry->fNumResends == 1 )
-                fBandwidthTracker->AddToRTTEstimate( (SInt32) ((theEntry->fOrigRetransTimeout  * 3) / 2 ));
-            
-//          qtss_printf("Retransmitted packet %d\n", theEntry->fSeqNum);
-            theEntry->fAddedTime = curTime;
-            fBandwidthTracker->AdjustWindowForRetransmit();
-            continue;
-        }
+        fNumResends++;
         
+        numResends ++;
+        //qtss_printf("resend loop numResends=%ld packet theEntry->fNumResends=%ld stream fNumResends=\n",numResends,theEntry->fNumResends++, fNumResends);
+                    
+        // ok -- lets try this.. add 1.5x of the INITIAL duration since the last send to the rto estimator
+        // since we won't get an ack on this packet
+        // this should keep us from exponentially increasing due o a one time increase
+        // in the actuall rtt, only AddToEstimate on the first resend ( assume that it's a dupe )
+        // if it's not a dupe, but rather an actual loss, the subseqnuent actuals wil bring down the average quickly
+        
+        if ( theEntry->fNumResends == 1 )
+            fBandwidthTracker->AddToRTTEstimate( (SInt32) ((theEntry->fOrigRetransTimeout  * 3) / 2 ));
+        
+//      qtss_printf("Retransmitted packet %d\n", theEntry->fSeqNum);
+        theEntry->fAddedTime = curTime;
+        this->Unlink(packetIndex);
+        this->LinkAsNewest(packetIndex);
+        fBandwidthTracker->AdjustWindowForRetransmit();
     }
 }
-void RTPPacketResender::RemovePacket(RTPResenderEntry* inEntry){ Assert(0); }
+
+#if RTP_PACKET_RESENDER_TESTING
+static void AddTestPacket(RTPPacketResender* inResender, UInt16 inSeqNum)
+{
+    UInt16 thePacket[6];
+    ::memset(thePacket, 0, sizeof(thePacket));
+    thePacket[1] = htons(inSeqNum);
+    inResender->AddPacket(thePacket, sizeof(thePacket), 60000);
+}
+
+Bool16 RTPPacketResender::Test()
+{
+    RTPBandwidthTracker theTracker(false);
+    theTracker.SetWindowSize(64 * 1024 * 1024);
+    UDPSocket theSocket(NULL, 0); // never opened, so resends go nowhere
+    
+    RTPPacketResender theVictim;
+    theVictim.SetBandwidthTracker(&theTracker);
+    theVictim.SetDestination(&theSocket, 0, 0);
+    
+    //
+    // Add across a sequence number wrap: 65526 ... 65535, 0 ... 9
+    UInt16 theFirst = 65526;
+    UInt16 theSeqNum = theFirst;
+    for (UInt32 x = 0; x < 20; x++, theSeqNum++)
+        AddTestPacket(&theVictim, theSeqNum);
+    if (theVictim.fPacketsInList != 20)
+        return false;
+        
+    // A repeat is ignored
+    AddTestPacket(&theVictim, 65535);
+    AddTestPacket(&theVictim, 0);
+    if (theVictim.fPacketsInList != 20)
+        return false;
+    
+    // Ack every other one, on both sides of the wrap
+    SInt64 theCurTime = OS::Milliseconds();
+    theSeqNum = theFirst;
+    for (UInt32 x = 0; x < 20; x += 2, theSeqNum += 2)
+        theVictim.AckPacket(theSeqNum, theCurTime);
+    if (theVictim.fPacketsInList != 10)
+        return false;
+    
+    theSeqNum = theFirst;
+    for (UInt32 x = 0; x < 20; x++, theSeqNum++)
+    {
+        Bool16 isAcked = ((x % 2) == 0);
+        if ((theVictim.GetEntryBySeqNum(theSeqNum) == NULL) != isAcked)
+            return false;
+    }
+    
+    // Acking an unknown or already acked packet changes nothing
+    theVictim.AckPacket(theFirst, theCurTime);
+    theVictim.AckPacket(5000, theCurTime);
+    if ((theVictim.fPacketsInList != 10) || (theVictim.fNumAcksForMissingPackets != 2))
+        return false;
+    
+    //
+    // The send order list runs oldest first, through the wrap
+    UInt16 theExpected = theFirst + 1;
+    UInt32 theCount = 0;
+    for (UInt32 theIndex = theVictim.fOldestIndex; theIndex != kNoPacketIndex; theIndex = theVictim.fPacketArray[theIndex].fNextIndex, theExpected += 2, theCount++)
+    {
+        if (theVictim.fPacketArray[theIndex].fSeqNum != theExpected)
+            return false;
+    }
+    if (theCount != 10)
+        return false;
+    
+    //
+    // Make the oldest 3 due (65527, 65529, 65531). Only they get resent, and they
+    // move to the back of the list in the same order.
+    SInt64 theRTO = theTracker.CurRetransmitTimeout();
+    theCurTime = OS::Milliseconds();
+    theExpected = theFirst + 1;
+    for (UInt32 x = 0; x < 3; x++, theExpected += 2)
+        theVictim.GetEntryBySeqNum(theExpected)->fAddedTime = theCurTime - (theRTO * 2) - x;
+    
+    SInt64 theNextDue = theVictim.GetEntryBySeqNum(theFirst + 1)->fAddedTime + theRTO + 1;
+    if (theVictim.GetNextResendTime() != theNextDue)
+        return false;
+    
+    theVictim.ResendDueEntries();
+    if (theVictim.fNumResends != 3)
+        return false;
+    
+    UInt16 theOrder[10] = { 65533, 65535, 1, 3, 5, 7, 9, 65527, 65529, 65531 };
+    theCount = 0;
+    for (UInt32 theIndex = theVictim.fOldestIndex; theIndex != kNoPacketIndex; theIndex = theVictim.fPacketArray[theIndex].fNextIndex, theCount++)
+    {
+        if ((theCount >= 10) || (theVictim.fPacketArray[theIndex].fSeqNum != theOrder[theCount]))
+            return false;
+        if (theVictim.fPacketArray[theIndex].fNumResends != ((theCount >= 7) ? 1U : 0U))
+            return false;
+    }
+    if ((theCount != 10) || (theVictim.fNewestIndex != (UInt32)(65531 & theVictim.fPacketArrayMask)))
+        return false;
+    
+    // Nothing else is due yet
+    theVictim.ResendDueEntries();
+    if (theVictim.fNumResends != 3)
+        return false;
+    
+    theVictim.ClearOutstandingPackets();
+    if ((theVictim.fPacketsInList != 0) || (theVictim.GetNextResendTime() != 0))
+        return false;
+    
+    //
+    // Fill half the sequence space without acks, starting near a wrap. The ring
+    // grows until every packet has its own slot.
+    theFirst = 60000;
+    theSeqNum = theFirst;
+    for (UInt32 x = 0; x < kMaxPacketArraySize; x++, theSeqNum++)
+        AddTestPacket(&theVictim, theSeqNum);
+    if ((theVictim.fPacketsInList != kMaxPacketArraySize) || (theVictim.fPacketArraySize != kMaxPacketArraySize))
+        return false;
+    
+    theSeqNum = theFirst;
+    for (UInt32 y = 0; y < kMaxPacketArraySize; y++, theSeqNum++)
+    {
+        if (theVictim.GetEntryBySeqNum(theSeqNum) == NULL)
+            return false;
+    }
+    
+    // The ring can't grow past that, so the next one takes the oldest one's slot
+    AddTestPacket(&theVictim, theSeqNum);
+    if ((theVictim.fPacketsInList != kMaxPacketArraySize) || (theVictim.fPacketArraySize != kMaxPacketArraySize))
+        return false;
+    if ((theVictim.GetEntryBySeqNum(theFirst) != NULL) || (theVictim.GetEntryBySeqNum(theSeqNum) == NULL))
+        return false;
+    if (theVictim.fPacketArray[theVictim.fOldestIndex].fSeqNum != (UInt16)(theFirst + 1))
+        return false;
+    
+    theVictim.ClearOutstandingPackets();
+    return (theVictim.fPacketsInList == 0);
+}
+#endif
@@ -31,6 +31,12 @@
     another timer for it's possible re-transmission.
     A duration timer is started to measure the RTT based on the client's ack.
     
+    Packets live in a ring indexed by sequence number, so finding one to ack or
+    to check for a repeat is a single lookup. The ring doubles in size when a new
+    sequence number lands on a slot still in use. Packets are also linked in the
+    order they were last sent. They all share one retransmit timeout, so the ones
+    due for a resend are always at the head of that list.
+    
 */
 
 #ifndef __RTP_PACKET_RESENDER_H__
@@ -44,8 +50,10 @@
 #include "OSMemory.h"
 #include "OSBufferPool.h"
 #include "OSMutex.h"
+#include "OSSharedBuffer.h"
 
 #define RTP_PACKET_RESENDER_DEBUGGING 0
+#define RTP_PACKET_RESENDER_TESTING 0
 
 class MyAckListLog;
 
@@ -56,11 +64,15 @@ class RTPResenderEntry
         void*               fPacketData;
         UInt32              fPacketSize;
         Bool16              fIsSpecialBuffer;
+        OSSharedBuffer*     fSharedBuffer;  // if set, fPacketData points into it
+        char                fHeader[12];    // RTP header of a packet in a shared buffer, as we sent it
         SInt64              fExpireTime;
         SInt64              fAddedTime;
         SInt64              fOrigRetransTimeout;
         UInt32              fNumResends;
         UInt16              fSeqNum;
+        UInt32              fPrevIndex;     // neighbours in send order
+        UInt32              fNextIndex;
 #if RTP_PACKET_RESENDER_DEBUGGING
         UInt32              fPacketArraySizeWhenAdded;
 #endif
@@ -81,8 +93,9 @@ class RTPPacketResender
         
         //
         // AddPacket adds a new packet to the resend queue. This will not send the packet.
-        // AddPacket itself is not thread safe.
-        void                AddPacket( void * rtpPacket, UInt32 packetSize, SInt32 ageLimitInMsec );
+        // If the packet is in inSharedBuffer, the resender keeps a reference to it
+        // rather than a copy. AddPacket itself is not thread safe.
+        void                AddPacket( void * rtpPacket, UInt32 packetSize, SInt32 ageLimitInMsec, OSSharedBuffer* inSharedBuffer = NULL );
         
         //
         // Acks a packet. Also not thread safe.
@@ -92,6 +105,10 @@ class RTPPacketResender
         // Resends outstanding packets in the queue. Guess what. Not thread safe.
         void                ResendDueEntries();
         
+        //
+        // When ResendDueEntries will next have something to do, or 0 if no packets are outstanding.
+        SInt64              GetNextResendTime();
+        
         //
         // Clear outstanding packets - if we no longer care about any of the
         // outstanding, unacked packets
@@ -107,6 +124,10 @@ class RTPPacketResender
         static UInt32       GetNumRetransmitBuffers() { return sBufferPool.GetTotalNumBuffers(); }
         static UInt32       GetWastedBufferBytes() { return sNumWastedBytes; }
 
+#if RTP_PACKET_RESENDER_TESTING
+        static Bool16       Test();
+#endif
+
 #if RTP_PACKET_RESENDER_DEBUGGING
         void                SetDebugInfo(UInt32 trackID, UInt16 remoteRTCPPort, UInt32 curPacketDelay);
         void                SetLog( StrPtrLen *logname );
@@ -145,20 +166,21 @@ class RTPPacketResender
 #endif
         
         RTPResenderEntry*   fPacketArray;
-        UInt16              fStartSeqNum;
-        UInt32              fPacketArraySize;
+        UInt32              fPacketArraySize;   // always a power of 2
         UInt32              fPacketArrayMask;
-        UInt16              fHighestSeqNum;
-        UInt32              fLastUsed;
+        UInt32              fOldestIndex;       // head and tail of the send order list
+        UInt32              fNewestIndex;
         OSMutex             fPacketQMutex;
 
-        RTPResenderEntry*   GetEntryByIndex(UInt16 inIndex);
         RTPResenderEntry*   GetEntryBySeqNum(UInt16 inSeqNum);
 
-        RTPResenderEntry*   GetEmptyEntry(UInt16 inSeqNum, UInt32 inPacketSize);
-        void ReallocatePacketArray();
-        void RemovePacket(UInt32 packetIndex, Bool16 reuse=true);
-        void RemovePacket(RTPResenderEntry* inEntry);
+        RTPResenderEntry*   GetEmptyEntry(UInt16 inSeqNum, UInt32 inPacketSize, OSSharedBuffer* inSharedBuffer);
+        void                FreePacketData(RTPResenderEntry* inEntry);
+        Bool16 GrowPacketArray(UInt16 inSeqNum);
+        Bool16 ReallocatePacketArray(UInt32 inNewSize, UInt16 inSeqNum);
+        void LinkAsNewest(UInt32 packetIndex);
+        void Unlink(UInt32 packetIndex);
+        void RemovePacket(UInt32 packetIndex, Bool16 emptyWindow=false);
 
         static OSBufferPool sBufferPool;
         static unsigned int sNumWastedBytes;
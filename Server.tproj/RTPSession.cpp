@@ -46,6 +46,35 @@
 
 #define RTPSESSION_DEBUGGING 0
 
+OSBufferPool RTPSession::sPool(sizeof(RTPSession), kMaxFreeInPool);
+
+void* RTPSession::operator new(size_t inSize)
+{
+    // A derived class won't fit in a pool buffer
+    if (inSize != sizeof(RTPSession))
+        return ::operator new(inSize);
+    return sPool.Get();
+}
+
+#if MEMORY_DEBUGGING
+void* RTPSession::operator new(size_t inSize, char* inFile, int inLine)
+{
+    if (inSize != sizeof(RTPSession))
+        return ::operator new(inSize, inFile, inLine);
+    return sPool.Get();
+}
+#endif
+
+void RTPSession::operator delete(void* inMem, size_t inSize)
+{
+    if (inMem == NULL)
+        return;
+    if (inSize != sizeof(RTPSession))
+        ::operator delete(inMem);
+    else
+        sPool.Put(inMem);
+}
+
 RTPSession::RTPSession() :
     RTPSessionInterface(),
     fModule(NULL),
@@ -382,6 +411,34 @@ UInt32 RTPSession::PowerOf2Floor(UInt32 inNumToFloor)
     return retVal;
 }
 
+UInt32 RTPSession::GetNumResends()
+{
+    UInt32 theNumResends = 0;
+    RTPStream** theStream = NULL;
+    UInt32 theStreamLen = 0;
+    for (int streamIter = 0; this->GetValuePtr(qtssCliSesStreamObjects, streamIter, (void**)&theStream, &theStreamLen) == QTSS_NoErr; streamIter++)
+        if (theStream && *theStream)
+            theNumResends += (*theStream)->GetNumResends();
+    return theNumResends;
+}
+
+SInt64 RTPSession::GetNextResendTime()
+{
+    SInt64 theNextResendTime = 0;
+    RTPStream** theStream = NULL;
+    UInt32 theStreamLen = 0;
+    for (int streamIter = 0; this->GetValuePtr(qtssCliSesStreamObjects, streamIter, (void**)&theStream, &theStreamLen) == QTSS_NoErr; streamIter++)
+    {
+        if (theStream && *theStream)
+        {
+            SInt64 theStreamResendTime = (*theStream)->GetNextResendTime();
+            if ((theStreamResendTime != 0) && ((theNextResendTime == 0) || (theStreamResendTime < theNextResendTime)))
+                theNextResendTime = theStreamResendTime;
+        }
+    }
+    return theNextResendTime;
+}
+
 void RTPSession::Teardown()
 {
     // To proffer a quick death of the RTSP session, let's disassociate
@@ -391,7 +448,10 @@ void RTPSession::Teardown()
     // this fRTSPSession pointer could otherwise be being used simultaneously by
     // an RTP stream.
     if (fRTSPSession != NULL)
+    {
+        fRTSPSession->CancelWriteEvent(this);
         fRTSPSession->DecrementObjectHolderCount();
+    }
     fRTSPSession = NULL;
     fState = qtssPausedState;
     this->Signal(Task::kKillEvent);
@@ -558,11 +618,23 @@ SInt64 RTPSession::Run()
     //RTSP requests coming in while it's sending packets
     {
         OSMutexLocker locker(&fSessionMutex);
+        UInt32 thePacketsSent = this->GetPacketsSent();
+        UInt32 theResendsSent = this->GetNumResends();
 
         //just make sure we haven't been scheduled before our scheduled play
         //time. If so, reschedule ourselves for the proper time. (if client
         //sends a play while we are already playing, this may occur)
         theParams.rtpSendPacketsParams.inCurrentTime = OS::Milliseconds();
+        
+        //
+        // If a stream was flow controlled and now has room, don't wait for
+        // the time the module asked for, which was only a guess.
+        if ((events & Task::kWriteEvent) && fWaitingToSend)
+        {
+            fWaitingToSend = false;
+            fNextSendPacketsTime = theParams.rtpSendPacketsParams.inCurrentTime;
+        }
+        
         if (fNextSendPacketsTime > theParams.rtpSendPacketsParams.inCurrentTime)
         {
             RTPStream** retransStream = NULL;
@@ -588,7 +660,18 @@ SInt64 RTPSession::Run()
             // Async event registration is definitely allowed from this role.
             fModuleState.eventRequested = false;
             Assert(fModule != NULL);
+            fWaitingToSend = false;
+            fSendingPackets = true;
             (void)fModule->CallDispatch(QTSS_RTPSendPackets_Role, &theParams);
+            fSendingPackets = false;
+            
+            //
+            // Send whatever runs of UDP packets the streams are still holding
+            RTPStream** theStream = NULL;
+            UInt32 theStreamLen = 0;
+            for (int streamIter = 0; this->GetValuePtr(qtssCliSesStreamObjects, streamIter, (void**)&theStream, &theStreamLen) == QTSS_NoErr; streamIter++)
+                if (theStream && *theStream)
+                    (*theStream)->FlushSegmentedWrites();
     #if RTPSESSION_DEBUGGING
             qtss_printf("RTPSession %ld: back from sendPackets, nextPacketTime = %"_64BITARG_"d\n",(SInt32)this, theParams.rtpSendPacketsParams.outNextPacketTime);
     #endif
@@ -598,6 +681,39 @@ SInt64 RTPSession::Run()
             fNextSendPacketsTime = theParams.rtpSendPacketsParams.inCurrentTime + theParams.rtpSendPacketsParams.outNextPacketTime;
         }
         
+        //
+        // Interleaved packets written above may still be waiting in the RTSP
+        // session's coalesce buffer. Send them all now. If the connection is flow
+        // controlled, come back once it drains instead of holding them until the next packet.
+        if ((fRTSPSession != NULL) && (fRTSPSession->FlushInterleavedWrites() != QTSS_NoErr))
+        {
+            if (fRTSPSession->RequestWriteEvent(this))
+                fWaitingToSend = true;
+            else
+            {
+                SInt64 theRetryTime = QTSServerInterface::GetServer()->GetPrefs()->GetSendIntervalInMsec();
+                if (theParams.rtpSendPacketsParams.outNextPacketTime > theRetryTime)
+                    theParams.rtpSendPacketsParams.outNextPacketTime = theRetryTime;
+            }
+        }
+        
+        //
+        // A flow controlled stream gets an event when it can send again (see
+        // RTPSessionInterface::WaitForSendReady), so don't poll for that.
+        // Reliable UDP streams only recover lost packets by resending them
+        // though, so still wake up when the next resend is due.
+        if (fWaitingToSend && (theParams.rtpSendPacketsParams.outNextPacketTime < kMaxSendReadyWaitInMsec))
+        {
+            SInt64 theWaitTime = kMaxSendReadyWaitInMsec;
+            SInt64 theNextResendTime = this->GetNextResendTime();
+            if ((theNextResendTime != 0) && (theNextResendTime - theParams.rtpSendPacketsParams.inCurrentTime < theWaitTime))
+                theWaitTime = theNextResendTime - theParams.rtpSendPacketsParams.inCurrentTime;
+            if (theParams.rtpSendPacketsParams.outNextPacketTime < theWaitTime)
+                theParams.rtpSendPacketsParams.outNextPacketTime = theWaitTime;
+        }
+        
+        // A wakeup that only resent packets wasn't wasted
+        QTSServerInterface::GetServer()->IncrementSendWakeups((this->GetPacketsSent() == thePacketsSent) && (this->GetNumResends() == theResendsSent));
     }
     
     //
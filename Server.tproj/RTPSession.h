@@ -48,6 +48,7 @@
 #include "RTPSessionInterface.h"
 #include "RTSPRequestInterface.h"
 #include "RTPStream.h"
+#include "OSBufferPool.h"
 #include "QTSSModule.h"
 
 
@@ -58,6 +59,14 @@ class RTPSession : public RTPSessionInterface
         RTPSession();
         virtual ~RTPSession();
         
+        // Allocated from a pool, like RTSPSessions
+        static void*    operator new(size_t inSize);
+#if MEMORY_DEBUGGING
+        static void*    operator new(size_t inSize, char* inFile, int inLine);
+#endif
+        static void     operator delete(void* inMem, size_t inSize);
+        static OSBufferPool*    GetPool()   { return &sPool; }
+        
         //
         //ACCESS FUNCTIONS
         
@@ -113,6 +122,12 @@ class RTPSession : public RTPSessionInterface
 
     private:
     
+        enum
+        {
+            kMaxFreeInPool = 256
+        };
+        static OSBufferPool sPool;
+    
         //where timeouts, deletion conditions get processed
         virtual SInt64  Run();
         
@@ -121,11 +136,17 @@ class RTPSession : public RTPSessionInterface
     
 		//overbuffer logging function
 		void LogOverbufferStats();
+		
+        // Across all streams: packets resent so far, and when the
+        // next reliable UDP retransmit is due (0 if none are)
+        UInt32  GetNumResends();
+        SInt64  GetNextResendTime();
 	
 		enum
 		{
             kRTPStreamArraySize     = 20,
-            kCantGetMutexIdleTime   = 10
+            kCantGetMutexIdleTime   = 10,
+            kMaxSendReadyWaitInMsec = 100   // in case the event that should wake a flow controlled session never comes
         };
 
         QTSSModule*         fModule;
@@ -104,6 +104,8 @@ RTPSessionInterface::RTPSessionInterface()
 	fStartedThinning(false),    
     fIsFirstPlay(true),
     fAllTracksInterleaved(true), // assume true until proven false!
+    fSendingPackets(false),
+    fWaitingToSend(false),
     fFirstPlayTime(0),
     fPlayTime(0),
     fAdjustedPlayTime(0),
@@ -211,7 +213,10 @@ void RTPSessionInterface::UpdateRTSPSession(RTSPSessionInterface* inNewRTSPSessi
     {
         // If there was an old session, let it know that we are done
         if (fRTSPSession != NULL)
+        {
+            fRTSPSession->CancelWriteEvent(this);
             fRTSPSession->DecrementObjectHolderCount();
+        }
         
         // Increment this count to prevent the RTSP session from being deleted
         fRTSPSession = inNewRTSPSession;
@@ -61,7 +61,10 @@ class RTPSessionInterface : public QTSSDictionary, public Task
         RTPSessionInterface();
         virtual ~RTPSessionInterface()
             {   if (fRTSPSession != NULL)
+                {
+                    fRTSPSession->CancelWriteEvent(this);
                     fRTSPSession->DecrementObjectHolderCount();
+                }
                 delete [] fSRBuffer.Ptr;
                 delete [] fAuthNonce.Ptr;       
                 delete [] fAuthOpaque.Ptr;      
@@ -102,6 +105,17 @@ class RTPSessionInterface : public QTSSDictionary, public Task
         RTPOverbufferWindow* GetOverbufferWindow() { return &fOverbufferWindow; }
         UInt32  GetFramesSkipped() { return fFramesSkipped; }
         
+        // True while the module is in its QTSS_RTPSendPackets_Role. Streams may hold
+        // on to packets until the end of that call (see RTPStream::FlushSegmentedWrites
+        // and RTSPSessionInterface::FlushInterleavedWrites).
+        Bool16  IsSendingPackets()  { return fSendingPackets; }
+        
+        // A stream that can't send until its socket drains or an ack opens its
+        // window calls WaitForSendReady. Whoever sees that happen calls
+        // SignalSendReady, which wakes the session instead of having it poll.
+        void    WaitForSendReady()  { fWaitingToSend = true; }
+        void    SignalSendReady()   { if (fWaitingToSend) this->Signal(Task::kWriteEvent); }
+        
         //
         // MEMORY FOR RTCP PACKETS
         
@@ -188,6 +202,8 @@ class RTPSessionInterface : public QTSSDictionary, public Task
         //Some stream related information that is shared amongst all streams
         Bool16      fIsFirstPlay;
         Bool16      fAllTracksInterleaved;
+        Bool16      fSendingPackets;
+        Bool16      fWaitingToSend;
         SInt64      fFirstPlayTime;//in milliseconds
         SInt64      fPlayTime;
         SInt64      fAdjustedPlayTime;
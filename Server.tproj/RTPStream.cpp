@@ -95,7 +95,9 @@ QTSSAttrInfoDict::AttrInfo  RTPStream::sAttributes[] =
     /* 35 */ { "qtssRTPStrPacketCountInRTCPInterval",       NULL,   qtssAttrDataTypeUInt32, qtssAttrModeRead | qtssAttrModePreempSafe  },
     /* 36 */ { "qtssRTPStrSvrRTPPort",              NULL,   qtssAttrDataTypeUInt16, qtssAttrModeRead | qtssAttrModePreempSafe  },
     /* 37 */ { "qtssRTPStrClientRTPPort",           NULL,   qtssAttrDataTypeUInt16, qtssAttrModeRead | qtssAttrModePreempSafe  },
-    /* 38 */ { "qtssRTPStrNetworkMode",             NULL,   qtssAttrDataTypeUInt32, qtssAttrModeRead | qtssAttrModePreempSafe  }
+    /* 38 */ { "qtssRTPStrNetworkMode",             NULL,   qtssAttrDataTypeUInt32, qtssAttrModeRead | qtssAttrModePreempSafe  },
+    /* 39 */ { "qtssRTPStrRoundTripTimeInMsec",     NULL,   qtssAttrDataTypeUInt32, qtssAttrModeRead | qtssAttrModePreempSafe  },
+    /* 40 */ { "qtssRTPStrCurPacketDelayInMsec",    NULL,   qtssAttrDataTypeSInt32, qtssAttrModeRead | qtssAttrModePreempSafe  }
 
 };
 
@@ -120,6 +122,8 @@ char *RTPStream::TCP = "TCP";
 
 QTSS_ModuleState RTPStream::sRTCPProcessModuleState = { NULL, 0, NULL, false };
 
+OSBufferPool RTPStream::sPool(sizeof(RTPStream), kMaxFreeInPool);
+
 void    RTPStream::Initialize()
 {
     for (int x = 0; x < qtssRTPStrNumParams; x++)
@@ -128,6 +132,33 @@ void    RTPStream::Initialize()
                 sAttributes[x].fAttrDataType, sAttributes[x].fAttrPermission);
 }
 
+void* RTPStream::operator new(size_t inSize)
+{
+    // A derived class won't fit in a pool buffer
+    if (inSize != sizeof(RTPStream))
+        return ::operator new(inSize);
+    return sPool.Get();
+}
+
+#if MEMORY_DEBUGGING
+void* RTPStream::operator new(size_t inSize, char* inFile, int inLine)
+{
+    if (inSize != sizeof(RTPStream))
+        return ::operator new(inSize, inFile, inLine);
+    return sPool.Get();
+}
+#endif
+
+void RTPStream::operator delete(void* inMem, size_t inSize)
+{
+    if (inMem == NULL)
+        return;
+    if (inSize != sizeof(RTPStream))
+        ::operator delete(inMem);
+    else
+        sPool.Put(inMem);
+}
+
 RTPStream::RTPStream(UInt32 inSSRC, RTPSessionInterface* inSession)
 :   QTSSDictionary(QTSSDictionaryMap::GetMap(QTSSDictionaryMap::kRTPStreamDictIndex), NULL),
     fLastQualityChange(0),
@@ -182,6 +213,7 @@ RTPStream::RTPStream(UInt32 inSSRC, RTPSessionInterface* inSession)
     fAudioDryCount(0),
     fClientSSRC(0),
     fIsTCP(false),
+    fIsRTCPMux(false),
     fTransportType(qtssRTPTransportTypeUDP),
     fTurnThinningOffDelay_TCP(0),
     fIncreaseThinningDelay_TCP(0),
@@ -207,7 +239,13 @@ RTPStream::RTPStream(UInt32 inSSRC, RTPSessionInterface* inSession)
     fRTPChannel(0),
     fRTCPChannel(0),
     fNetworkMode(qtssRTPNetworkModeDefault),
-    fStreamStartTimeOSms(OS::Milliseconds())
+    fStreamStartTimeOSms(OS::Milliseconds()),
+    fRoundTripTimeInMsec(0),
+    fCurPacketDelayInMsec(0),
+    fSegmentBuffer(NULL),
+    fSegmentBufferLen(0),
+    fSegmentSize(0),
+    fNumSegments(0)
 {
 
     fStreamRef = this;
@@ -262,6 +300,8 @@ RTPStream::RTPStream(UInt32 inSSRC, RTPSessionInterface* inSession)
     this->SetVal(qtssRTPStrSvrRTPPort,          &fLocalRTPPort,         sizeof(fLocalRTPPort));
     this->SetVal(qtssRTPStrClientRTPPort,       &fRemoteRTPPort,        sizeof(fRemoteRTPPort));
     this->SetVal(qtssRTPStrNetworkMode,         &fNetworkMode,          sizeof(fNetworkMode));
+    this->SetVal(qtssRTPStrRoundTripTimeInMsec, &fRoundTripTimeInMsec,  sizeof(fRoundTripTimeInMsec));
+    this->SetVal(qtssRTPStrCurPacketDelayInMsec, &fCurPacketDelayInMsec, sizeof(fCurPacketDelayInMsec));
     
     
 }
@@ -272,14 +312,16 @@ RTPStream::~RTPStream()
     if (fSockets != NULL)
     {
         // If there is an UDP socket pair associated with this stream, make sure to free it up
-        Assert(fSockets->GetSocketB()->GetDemuxer() != NULL);
-        fSockets->GetSocketB()->GetDemuxer()->
+        Assert(this->GetRTCPSocket()->GetDemuxer() != NULL);
+        this->GetRTCPSocket()->GetDemuxer()->
             UnregisterTask(fRemoteAddr, fRemoteRTCPPort, this);
         Assert(err == QTSS_NoErr);
     
         QTSServerInterface::GetServer()->GetSocketPool()->ReleaseUDPSocketPair(fSockets);
     }
     
+    delete [] fSegmentBuffer;
+    
 #if RTP_PACKET_RESENDER_DEBUGGING
     //fResender.LogClose(fFlowControlDurationMsec);
     //qtss_printf("Flow control duration msec: %"_64BITARG_"d. Max outstanding packets: %d\n", fFlowControlDurationMsec, fResender.GetMaxPacketsInList());
@@ -391,6 +433,17 @@ QTSS_Error RTPStream::Setup(RTSPRequestInterface* request, QTSS_AddStreamFlags i
 	//
 	// decide whether to overbuffer
 	this->SetOverBufferState(request);
+    
+    //
+    // rtcp-mux only means something for UDP. If we aren't going to do it,
+    // clear it so the response doesn't claim we are.
+    if (request->IsRTCPMux())
+    {
+        if ((fTransportType != qtssRTPTransportTypeTCP) && QTSServerInterface::GetServer()->GetPrefs()->IsRTCPMuxEnabled())
+            fIsRTCPMux = true;
+        else
+            request->SetRTCPMux(false);
+    }
         
     // Check to see if this RTP stream should be sent over TCP.
     if (fTransportType == qtssRTPTransportTypeTCP)
@@ -425,6 +478,8 @@ QTSS_Error RTPStream::Setup(RTSPRequestInterface* request, QTSS_AddStreamFlags i
     }
     fRemoteRTPPort = request->GetClientPortA();
     fRemoteRTCPPort = request->GetClientPortB();
+    if (fIsRTCPMux)
+        fRemoteRTCPPort = fRemoteRTPPort;
 
     if ((fRemoteRTPPort == 0) || (fRemoteRTCPPort == 0))
         return QTSSModuleUtils::SendErrorResponse(request, qtssClientBadRequest, qtssMsgNoClientPortInTransport);       
@@ -480,6 +535,12 @@ QTSS_Error RTPStream::Setup(RTSPRequestInterface* request, QTSS_AddStreamFlags i
     if (fSockets == NULL)
         return QTSSModuleUtils::SendErrorResponse(request, qtssServerInternal, qtssMsgOutOfPorts);      
     
+    else if ((fTransportType == qtssRTPTransportTypeUDP) && fSockets->GetSocketA()->IsTransmitTimeEnabled())
+    {
+        //
+        // The kernel can hold packets until they are due, so packets can be sent further ahead
+        fSession->GetOverbufferWindow()->SetKernelPacingWindow(QTSServerInterface::GetServer()->GetPrefs()->GetKernelPacingWindowInMsec());
+    }
     else if (fTransportType == qtssRTPTransportTypeReliableUDP)
     {
         //
@@ -518,8 +579,8 @@ QTSS_Error RTPStream::Setup(RTSPRequestInterface* request, QTSS_AddStreamFlags i
     fLocalRTPPort = fSockets->GetSocketA()->GetLocalPort();
 
     //finally, register with the demuxer to get RTCP packets from the proper address
-    Assert(fSockets->GetSocketB()->GetDemuxer() != NULL);
-    QTSS_Error err = fSockets->GetSocketB()->GetDemuxer()->RegisterTask(fRemoteAddr, fRemoteRTCPPort, this);
+    Assert(this->GetRTCPSocket()->GetDemuxer() != NULL);
+    QTSS_Error err = this->GetRTCPSocket()->GetDemuxer()->RegisterTask(fRemoteAddr, fRemoteRTCPPort, this);
     //errors should only be returned if there is a routing problem, there should be none
     Assert(err == QTSS_NoErr);
     return QTSS_NoErr;
@@ -675,7 +736,9 @@ QTSS_Error  RTPStream::InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* ou
 
     //char blahblah[2048];
     
-    QTSS_Error err = fSession->GetRTSPSession()->InterleavedWrite( inBuffer, inLen, outLenWritten, channel);
+    // Only hold packets back during a send burst, which RTPSession::Run flushes at
+    // the end. Packets written from elsewhere, like the reflector's sender, go right out.
+    QTSS_Error err = fSession->GetRTSPSession()->InterleavedWrite( inBuffer, inLen, outLenWritten, channel, fSession->IsSendingPackets());
     //QTSS_Error err = fSession->GetRTSPSession()->InterleavedWrite( blahblah, 2044, outLenWritten, channel);
 #if DEBUG
     //if (outLenWritten != NULL)
@@ -692,6 +755,10 @@ QTSS_Error  RTPStream::InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* ou
     }
 #endif      
 
+    // If the socket is full, have the session woken when it drains
+    if ( (err == EAGAIN) && fSession->IsSendingPackets() && fSession->GetRTSPSession()->RequestWriteEvent(fSession) )
+        fSession->WaitForSendReady();
+
     // reset the timeouts when the connection is still alive
     // wehn transmitting over HTTP, we're not going to get
     // RTCPs that would normally Refresh the session time.
@@ -715,8 +782,56 @@ void    RTPStream::SendRetransmits()
     
 }
 
+//SegmentedWrite must be called from a fSession mutex protected caller
+void RTPStream::SegmentedWrite(void* inBuffer, UInt32 inLen)
+{
+    //
+    // A run is a series of packets all fSegmentSize long, except maybe the last.
+    // The caller's buffer goes away after this call, so packets get copied.
+    if ((fNumSegments > 0) && ((inLen > fSegmentSize) || (fNumSegments == UDPSocket::kMaxSegments)
+                                || (fSegmentBufferLen + inLen > kSegmentBufferSize)))
+        this->FlushSegmentedWrites();
+    
+    if (inLen > UDPSocket::kMaxSegmentSize)
+    {
+        (void)fSockets->GetSocketA()->SendTo(fRemoteAddr, fRemoteRTPPort, inBuffer, inLen);
+        return;
+    }
+    
+    if (fSegmentBuffer == NULL)
+        fSegmentBuffer = NEW char[kSegmentBufferSize];
+    
+    if (fNumSegments == 0)
+        fSegmentSize = inLen;
+    ::memcpy(fSegmentBuffer + fSegmentBufferLen, inBuffer, inLen);
+    fSegmentBufferLen += inLen;
+    fNumSegments++;
+    
+    // A shorter packet ends the run
+    if (inLen < fSegmentSize)
+        this->FlushSegmentedWrites();
+}
+
+void RTPStream::FlushSegmentedWrites()
+{
+    if (fNumSegments == 0)
+        return;
+        
+    Bool16 wasSegmented = false;
+    (void)fSockets->GetSocketA()->SendSegmentsTo(fRemoteAddr, fRemoteRTPPort, fSegmentBuffer, fSegmentBufferLen,
+                                                    (UInt16)fSegmentSize, &wasSegmented);
+    
+    // Count the sends that really went out segmented
+    if (wasSegmented)
+        QTSServerInterface::GetServer()->IncrementUDPSegmentedSends(fNumSegments);
+
+    fSegmentBufferLen = 0;
+    fSegmentSize = 0;
+    fNumSegments = 0;
+}
+
 //ReliableRTPWrite must be called from a fSession mutex protected caller
-QTSS_Error RTPStream::ReliableRTPWrite(void* inBuffer, UInt32 inLen, const SInt64& curPacketDelay)
+QTSS_Error RTPStream::ReliableRTPWrite(void* inBuffer, UInt32 inLen, const SInt64& curPacketDelay, OSSharedBuffer* inSharedBuffer)
 {
     QTSS_Error err = QTSS_NoErr;
 
@@ -763,6 +878,9 @@ QTSS_Error RTPStream::ReliableRTPWrite(void* inBuffer, UInt32 inLen, const SInt6
             fFlowControlStartedMsec = OS::Milliseconds();
         }
 #endif
+        // Acks opening up the window wake the session up again
+        if (fSession->IsSendingPackets())
+            fSession->WaitForSendReady();
         err = QTSS_WouldBlock;
     }
     else
@@ -779,7 +897,7 @@ QTSS_Error RTPStream::ReliableRTPWrite(void* inBuffer, UInt32 inLen, const SInt6
         // Assign a lifetime to the packet using the current delay of the packet and
         // the time until this packet becomes stale.
         fBytesSentThisInterval += inLen;
-        fResender.AddPacket( inBuffer, inLen, (SInt32) (fDropAllPacketsForThisStreamDelay - curPacketDelay) );
+        fResender.AddPacket( inBuffer, inLen, (SInt32) (fDropAllPacketsForThisStreamDelay - curPacketDelay), inSharedBuffer );
 
         (void)fSockets->GetSocketA()->SendTo(fRemoteAddr, fRemoteRTPPort, inBuffer, inLen);
     }
@@ -926,9 +1044,13 @@ QTSS_Error  RTPStream::Write(void* inBuffer, UInt32 inLen, UInt32* outLenWritten
     SInt64 theTime = OS::Milliseconds();
     
     //
-    // Data passed into this version of write must be a QTSS_PacketStruct
+    // Data passed into this version of write must be a QTSS_PacketStruct,
+    // or a QTSS_SharedPacketStruct, which starts with one
     QTSS_PacketStruct* thePacket = (QTSS_PacketStruct*)inBuffer;
     thePacket->suggestedWakeupTime = -1;
+    OSSharedBuffer* theSharedBuffer = NULL;
+    if (inFlags & qtssWriteFlagsSharedPacket)
+        theSharedBuffer = (OSSharedBuffer*)((QTSS_SharedPacketStruct*)inBuffer)->sharedBuffer;
     SInt64 theCurrentPacketDelay = theTime - thePacket->packetTransmitTime;
     
 #if RTP_PACKET_RESENDER_DEBUGGING
@@ -969,7 +1091,7 @@ QTSS_Error  RTPStream::Write(void* inBuffer, UInt32 inLen, UInt32* outLenWritten
         }
         else if ( inLen > 0 )
         {
-            (void)fSockets->GetSocketB()->SendTo(fRemoteAddr, fRemoteRTCPPort, thePacket->packetData, inLen);
+            (void)this->GetRTCPSocket()->SendTo(fRemoteAddr, fRemoteRTCPPort, thePacket->packetData, inLen);
         }
         
         if (err == QTSS_NoErr)
@@ -977,6 +1099,9 @@ QTSS_Error  RTPStream::Write(void* inBuffer, UInt32 inLen, UInt32* outLenWritten
     }
     else if (inFlags & qtssWriteFlagsIsRTP)
     {
+        // Modules look at this to see how well the session is keeping up
+        fCurPacketDelayInMsec = (SInt32)theCurrentPacketDelay;
+        
         //
         // Check to see if this packet fits in the overbuffer window
         thePacket->suggestedWakeupTime = fSession->GetOverbufferWindow()->CheckTransmitTime(thePacket->packetTransmitTime, theTime, inLen);
@@ -1000,9 +1125,13 @@ QTSS_Error  RTPStream::Write(void* inBuffer, UInt32 inLen, UInt32* outLenWritten
             if ( fTransportType == qtssRTPTransportTypeTCP )    // write out in interleave format on the RTSP TCP channel
                 err = this->InterleavedWrite( thePacket->packetData, inLen, outLenWritten, fRTPChannel );       
             else if ( fTransportType == qtssRTPTransportTypeReliableUDP )
-                err = this->ReliableRTPWrite( thePacket->packetData, inLen, theCurrentPacketDelay );
+                err = this->ReliableRTPWrite( thePacket->packetData, inLen, theCurrentPacketDelay, theSharedBuffer );
+            else if ( (inLen > 0) && fSession->IsSendingPackets() && fSockets->GetSocketA()->IsSegmentationEnabled()
+                        && !fSockets->GetSocketA()->IsTransmitTimeEnabled() )
+                this->SegmentedWrite( thePacket->packetData, inLen );
             else if ( inLen > 0 )
-                (void)fSockets->GetSocketA()->SendTo(fRemoteAddr, fRemoteRTPPort, thePacket->packetData, inLen);
+                (void)fSockets->GetSocketA()->SendTo(fRemoteAddr, fRemoteRTPPort, thePacket->packetData, inLen,
+                                                        fSession->GetOverbufferWindow()->GetKernelSendTime(thePacket->packetTransmitTime, theTime));
             
             if (err == QTSS_NoErr)
                 PrintPacketPrefEnabled( (char*) thePacket->packetData, inLen, (SInt32) RTPStream::rtp);
@@ -1135,7 +1264,7 @@ void RTPStream::SendRTCPSR(const SInt64& inTime, Bool16 inAppendBye)
     }
     else
     {
-       err = fSockets->GetSocketB()->SendTo(fRemoteAddr, fRemoteRTCPPort, theSR->GetSRPacket(), thePacketLen);
+       err = this->GetRTCPSocket()->SendTo(fRemoteAddr, fRemoteRTCPPort, theSR->GetSRPacket(), thePacketLen);
     }
     
     if (err == QTSS_NoErr)
@@ -1159,6 +1288,7 @@ void RTPStream::ProcessIncomingRTCPPacket(StrPtrLen* inPacket)
 {
     StrPtrLen currentPtr(*inPacket);
     SInt64 curTime = OS::Milliseconds();
+    Bool16 hasReport = false;
 
 
     // Modules are guarenteed atomic access to the session. Also, the RTSP Session accessed
@@ -1207,10 +1337,10 @@ void RTPStream::ProcessIncomingRTCPPacket(StrPtrLen* inPacket)
                 // Set the Client SSRC based on latest RTCP
                 fClientSSRC = rtcpPacket.GetPacketSSRC();
 
-                fFractionLostPackets = receiverPacket.GetCumulativeFractionLostPackets();
-                fJitter = receiverPacket.GetCumulativeJitter();
-                
-                UInt32 curTotalLostPackets = receiverPacket.GetCumulativeTotalLostPackets();
+                UInt32 curTotalLostPackets = 0;
+                receiverPacket.GetCumulativeStats(&fFractionLostPackets, &curTotalLostPackets, &fJitter);
+                this->UpdateRoundTripTime(&receiverPacket, curTime);
+                hasReport = true;
                 
                 // Workaround for client problem.  Sometimes it appears to report a bogus lost packet count.
                 // Since we can't have lost more packets than we sent, ignore the packet if that seems to be the case.
@@ -1276,6 +1406,8 @@ void RTPStream::ProcessIncomingRTCPPacket(StrPtrLen* inPacket)
                             }
                         }
                         
+                        if (!fResender.IsFlowControlled())
+                            fSession->SignalSendReady();
                     }
                 }
                 else
@@ -1285,7 +1417,10 @@ void RTPStream::ProcessIncomingRTCPPacket(StrPtrLen* inPacket)
                     // If it isn't an ACK, assume its the qtss APP packet
                     RTCPCompressedQTSSPacket compressedQTSSPacket;
                     if (!compressedQTSSPacket.ParseCompressedQTSSPacket((UInt8*)currentPtr.Ptr, currentPtr.Len))
+                    {   fSession->GetSessionMutex()->Unlock();
                         return;//abort if we discover a malformed app packet
+                    }
+                    hasReport = true;
 
                     fReceiverBitRate =      compressedQTSSPacket.GetReceiverBitRate();
                     fAvgLateMsec =          compressedQTSSPacket.GetAverageLateMilliseconds();
@@ -1363,10 +1498,43 @@ void RTPStream::ProcessIncomingRTCPPacket(StrPtrLen* inPacket)
     // Invoke RTCP processing modules
     for (UInt32 x = 0; x < QTSServerInterface::GetNumModulesInRole(QTSSModule::kRTCPProcessRole); x++)
         (void)QTSServerInterface::GetModule(QTSSModule::kRTCPProcessRole, x)->CallDispatch(QTSS_RTCPProcess_Role, &theParams);
+        
+    // Modules that only care about the stats don't need to see acks, SDES or BYEs. With
+    // reliable UDP, acks are most of the RTCP packets we get.
+    if (hasReport)
+    {
+        for (UInt32 y = 0; y < QTSServerInterface::GetNumModulesInRole(QTSSModule::kRTCPReportRole); y++)
+            (void)QTSServerInterface::GetModule(QTSSModule::kRTCPReportRole, y)->CallDispatch(QTSS_RTCPReport_Role, &theParams);
+    }
 
     fSession->GetSessionMutex()->Unlock();
 }
 
+void RTPStream::UpdateRoundTripTime(RTCPReceiverPacket* inReceiverPacket, const SInt64& inCurrentTime)
+{
+    //
+    // The first report block tells when the client got our last SR (LSR) and how long
+    // it held on to it (DLSR), both in 1/65536 secs. Without an SR yet, LSR is 0.
+    if ((inReceiverPacket->GetReportCount() > 0) && (inReceiverPacket->GetLastSenderReportTime(0) != 0))
+    {
+        // Middle 32 bits of the NTP time, figured the same way as in our SRs
+        SInt64 theNTPTime = fSession->GetNTPPlayTime() + OS::TimeMilli_To_Fixed64Secs(inCurrentTime - fSession->GetPlayTime());
+        UInt32 theNow = (UInt32)(theNTPTime >> 16);
+        UInt32 theRTT = theNow - inReceiverPacket->GetLastSenderReportTime(0) - inReceiverPacket->GetLastSenderReportDelay(0);
+        
+        // A bogus report makes this wrap around to something huge
+        if (theRTT < (kMaxRoundTripTimeInSecs << 16))
+        {
+            fRoundTripTimeInMsec = (UInt32)(((UInt64)theRTT * 1000) >> 16);
+            return;
+        }
+    }
+    
+    // Reliable UDP keeps its own estimate from the acks
+    if (fTracker != NULL)
+        fRoundTripTimeInMsec = fTracker->RunningAverageMSecs();
+}
+
 char* RTPStream::GetStreamTypeStr()
 {
     char *streamType = NULL;
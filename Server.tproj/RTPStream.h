@@ -51,8 +51,11 @@
 #include "RTPSessionInterface.h"
 
 #include "RTPPacketResender.h"
+#include "OSBufferPool.h"
 #include "QTSServerInterface.h"
 
+class RTCPReceiverPacket;
+
 class RTPStream : public QTSSDictionary, public UDPDemuxerTask
 {
     public:
@@ -66,6 +69,14 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
         RTPStream(UInt32 inSSRC, RTPSessionInterface* inSession);
         virtual ~RTPStream();
         
+        // Allocated from a pool, like the RTPSessions that own them
+        static void*    operator new(size_t inSize);
+#if MEMORY_DEBUGGING
+        static void*    operator new(size_t inSize, char* inFile, int inLine);
+#endif
+        static void     operator delete(void* inMem, size_t inSize);
+        static OSBufferPool*    GetPool()   { return &sPool; }
+        
         //
         //ACCESS FUNCTIONS
         
@@ -120,6 +131,16 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
         // should be called periodically even if there is no new packet data, as
         // the pipe should have a steady stream of data in it. 
         void SendRetransmits();
+        
+        // For reliable UDP, when SendRetransmits next has work, or 0 if it has none.
+        // The number of packets the stream has resent so far.
+        SInt64 GetNextResendTime()  { return (fTransportType == qtssRTPTransportTypeReliableUDP) ? fResender.GetNextResendTime() : 0; }
+        UInt32 GetNumResends()      { return (UInt32)fResender.GetNumResends(); }
+        
+        //
+        // While the session is sending packets, runs of same size RTP packets to a UDP
+        // client are held and sent in one segmented send. Sends what is being held.
+        void FlushSegmentedWrites();
 
         //
         // Update the thinning parameters for this stream to match current prefs
@@ -135,6 +156,12 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
 		void DisableSSRC() { fEnableSSRC = false; }
 		
     private:
+    
+        enum
+        {
+            kMaxFreeInPool = 512    // usually two streams per session
+        };
+        static OSBufferPool sPool;
         
         enum
         {
@@ -143,6 +170,7 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
             kDefaultPayloadBufSize      = 32,
             kSenderReportIntervalInSecs = 7,
             kNumPrebuiltChNums          = 10,
+            kMaxRoundTripTimeInSecs     = 60    // longer RTTs from receiver reports are taken as bogus
         };
     
         SInt64 fLastQualityChange;
@@ -152,6 +180,9 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
         //or fresh ones (only fresh in extreme special cases)
         UDPSocketPair*          fSockets;
         RTPSessionInterface*    fSession;
+        
+        // With rtcp-mux, RTCP goes both ways over the RTP socket
+        UDPSocket*              GetRTCPSocket() { return fIsRTCPMux ? fSockets->GetSocketA() : fSockets->GetSocketB(); }
 
         // info for kinda reliable UDP
         //DssDurationTimer      fInfoDisplayTimer;
@@ -231,6 +262,7 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
         UInt32      fClientSSRC;
         
         Bool16      fIsTCP;
+        Bool16      fIsRTCPMux;
         QTSS_RTPTransportType   fTransportType;
         
         // HTTP params
@@ -283,11 +315,31 @@ class RTPStream : public QTSSDictionary, public UDPDemuxerTask
         QTSS_RTPNetworkMode     fNetworkMode;
         
         SInt64  fStreamStartTimeOSms;
+        
+        UInt32  fRoundTripTimeInMsec;
+        SInt32  fCurPacketDelayInMsec;
+        
+        // The run of RTP packets waiting for FlushSegmentedWrites. Allocated the
+        // first time this stream has one.
+        enum
+        {
+            kSegmentBufferSize = 32768
+        };
+        char*   fSegmentBuffer;
+        UInt32  fSegmentBufferLen;
+        UInt32  fSegmentSize;
+        UInt32  fNumSegments;
+        
+        void        SegmentedWrite(void* inBuffer, UInt32 inLen);
+        
+        void        UpdateRoundTripTime(RTCPReceiverPacket* inReceiverPacket, const SInt64& inCurrentTime);
+        
         // acutally write the data out that way
         QTSS_Error  InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* outLenWritten, unsigned char channel );
 
-        // implements the ReliableRTP protocol
-        QTSS_Error  ReliableRTPWrite(void* inBuffer, UInt32 inLen, const SInt64& curPacketDelay);
+        // implements the ReliableRTP protocol. If inSharedBuffer is set, inBuffer
+        // is in it and the resender holds on to it instead of copying the packet.
+        QTSS_Error  ReliableRTPWrite(void* inBuffer, UInt32 inLen, const SInt64& curPacketDelay, OSSharedBuffer* inSharedBuffer);
 
         void        SetTCPThinningParams();
         QTSS_Error  TCPWrite(void* inBuffer, UInt32 inLen, UInt32* outLenWritten, UInt32 inFlags);
@@ -49,29 +49,13 @@ StrPtrLen RTSPProtocol::sMethods[] =
     StrPtrLen("RECORD")
 };
 
+// Tables are built at static init time, so each has to come after the array it indexes
+StringLookupTable RTSPProtocol::sMethodTable(RTSPProtocol::sMethods, qtssNumMethods, true);
+
 QTSS_RTSPMethod
 RTSPProtocol::GetMethod(const StrPtrLen &inMethodStr)
 {
-    //chances are this is one of our selected "VIP" methods. so check for this.
-    QTSS_RTSPMethod theMethod = qtssIllegalMethod;
-    
-    switch(*inMethodStr.Ptr)
-    {
-        case 'S':   case 's':   theMethod = qtssSetupMethod;    break;
-        case 'D':   case 'd':   theMethod = qtssDescribeMethod; break;
-        case 'T':   case 't':   theMethod = qtssTeardownMethod; break;
-        case 'O':   case 'o':   theMethod = qtssOptionsMethod;  break;
-        case 'A':   case 'a':   theMethod = qtssAnnounceMethod; break;
-    }
-
-    if ((theMethod != qtssIllegalMethod) &&
-        (inMethodStr.EqualIgnoreCase(sMethods[theMethod].Ptr, sMethods[theMethod].Len)))
-        return theMethod;
-
-    for (SInt32 x = qtssNumVIPMethods; x < qtssIllegalMethod; x++)
-        if (inMethodStr.EqualIgnoreCase(sMethods[x].Ptr, sMethods[x].Len))
-            return x;
-    return qtssIllegalMethod;
+    return sMethodTable.Find(inMethodStr);
 }
 
 
@@ -133,53 +117,11 @@ StrPtrLen RTSPProtocol::sHeaders[] =
 	StrPtrLen("x-Accept-Dynamic-Rate")
 };
 
+StringLookupTable RTSPProtocol::sHeaderTable(RTSPProtocol::sHeaders, qtssNumHeaders, true);
+
 QTSS_RTSPHeader RTSPProtocol::GetRequestHeader(const StrPtrLen &inHeaderStr)
 {
-    if (inHeaderStr.Len == 0)
-        return qtssIllegalHeader;
-    
-    QTSS_RTSPHeader theHeader = qtssIllegalHeader;
-    
-    //chances are this is one of our selected "VIP" headers. so check for this.
-    switch(*inHeaderStr.Ptr)
-    {
-        case 'C':   case 'c':   theHeader = qtssCSeqHeader;         break;
-        case 'S':   case 's':   theHeader = qtssSessionHeader;      break;
-        case 'U':   case 'u':   theHeader = qtssUserAgentHeader;    break;
-        case 'A':   case 'a':   theHeader = qtssAcceptHeader;       break;
-        case 'T':   case 't':   theHeader = qtssTransportHeader;    break;
-        case 'R':   case 'r':   theHeader = qtssRangeHeader;        break;
-        case 'X':   case 'x':   theHeader = qtssExtensionHeaders;   break;
-    }
-    
-    //
-    // Check to see whether this is one of our extension headers. These
-    // are very likely to appear in requests.
-    if (theHeader == qtssExtensionHeaders)
-    {
-        for (SInt32 y = qtssExtensionHeaders; y < qtssNumHeaders; y++)
-        {
-            if (inHeaderStr.EqualIgnoreCase(sHeaders[y].Ptr, sHeaders[y].Len))
-                return y;
-        }
-    }
-    
-    //
-    // It's not one of our extension headers, check to see if this is one of
-    // our normal VIP headers
-    if ((theHeader != qtssIllegalHeader) &&
-        (inHeaderStr.EqualIgnoreCase(sHeaders[theHeader].Ptr, sHeaders[theHeader].Len)))
-        return theHeader;
-
-    //
-    //If this isn't one of our VIP headers, go through the remaining request headers, trying
-    //to find the right one.
-    for (SInt32 x = qtssNumVIPHeaders; x < qtssNumHeaders; x++)
-    {
-        if (inHeaderStr.EqualIgnoreCase(sHeaders[x].Ptr, sHeaders[x].Len))
-            return x;
-    }
-    return qtssIllegalHeader;
+    return sHeaderTable.Find(inHeaderStr);
 }
 
 
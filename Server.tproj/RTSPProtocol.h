@@ -40,6 +40,7 @@
 
 #include "QTSSRTSPProtocol.h"
 #include "StrPtrLen.h"
+#include "StringLookupTable.h"
 
 class RTSPProtocol
 {
@@ -99,6 +100,8 @@ class RTSPProtocol
         //for other lookups
         static StrPtrLen            sMethods[];
         static StrPtrLen            sHeaders[];
+        static StringLookupTable    sMethodTable;
+        static StringLookupTable    sHeaderTable;
         static StrPtrLen            sStatusCodeStrings[];
         static StrPtrLen            sStatusCodeAsStrings[];
         static SInt32               sStatusCodes[];
@@ -461,6 +461,8 @@ void RTSPRequest::ParseTransportHeader()
                 {   
                     if ( theTransportSubHeader.EqualIgnoreCase("RTP/AVP/TCP") )
                         fTransportType = qtssRTPTransportTypeTCP;
+                    else if ( theTransportSubHeader.EqualIgnoreCase("rtcp-mux") )
+                        fRTCPMux = true;
                     break;
                 }
                 case 'c':   //client_port sub-header
@@ -730,6 +732,12 @@ void RTSPRequest::ParseClientPortSubHeader(StrPtrLen* inClientPortSubHeader)
     theSubHeaderParser.GetThru(NULL,'-');
     theSubHeaderParser.ConsumeWhitespace();
     fClientPortB = (UInt16)theSubHeaderParser.ConsumeInteger(NULL);
+    
+    // A client asking for rtcp-mux may only give the one port. It may come
+    // before or after this, so just fill in the usual RTCP port.
+    if (fClientPortB == 0)
+        fClientPortB = fClientPortA + 1;
+    
     if (fClientPortB != fClientPortA + 1) // an error in the port values
     {
         // The following to setup and log the error as a message level 2.
@@ -780,11 +788,12 @@ QTSS_Error RTSPRequest::ParseBasicHeader(StringParser *inParsedAuthLinePtr)
     if (0 == authWord.Len ) 
         return theErr;
         
-    char* encodedStr = authWord.GetAsCString();
-    OSCharArrayDeleter encodedStrDeleter(encodedStr);   
+    // Both of these go away with the request
+    char* encodedStr = (char*)fArena.Alloc(authWord.Len + 1);
+    ::memcpy(encodedStr, authWord.Ptr, authWord.Len);
+    encodedStr[authWord.Len] = '\0';
     
-    char *decodedAuthWord = NEW char[Base64decode_len(encodedStr) + 1];
-    OSCharArrayDeleter decodedAuthWordDeleter(decodedAuthWord);
+    char *decodedAuthWord = (char*)fArena.Alloc(Base64decode_len(encodedStr) + 1);
 
     (void) Base64decode(decodedAuthWord, encodedStr);
     
@@ -61,6 +61,14 @@ StrPtrLen   RTSPRequestInterface::sPremadeNoHeaderPtr(sPremadeNoHeader, kStaticH
 
 StrPtrLen   RTSPRequestInterface::sColonSpace(": ", 2);
 
+char        RTSPRequestInterface::sHeaderPrefixBuf[kHeaderPrefixBufSizeInBytes];
+StrPtrLen   RTSPRequestInterface::sHeaderPrefixes[qtssNumHeaders];
+
+char        RTSPRequestInterface::sDateAndExpiresBuf[kStaticHeaderSizeInBytes];
+StrPtrLen   RTSPRequestInterface::sDateAndExpires(sDateAndExpiresBuf, 0);
+UInt32      RTSPRequestInterface::sDateSlot = 0;
+UInt32      RTSPRequestInterface::sExpiresSlot = 0;
+
 QTSSAttrInfoDict::AttrInfo  RTSPRequestInterface::sAttributes[] =
 {   /*fields:   fAttrName, fFuncPtr, fAttrDataType, fAttrPermission */
     /* 0 */ { "qtssRTSPReqFullRequest",         NULL,                   qtssAttrDataTypeCharArray,  qtssAttrModeRead | qtssAttrModePreempSafe },
@@ -126,6 +134,31 @@ void  RTSPRequestInterface::Initialize()
     sPremadeNoHeaderPtr.Len = noServerInfoHeaderFormatter.GetCurrentOffset();
     Assert(sPremadeNoHeaderPtr.Len < kStaticHeaderSizeInBytes);
     
+    StringFormatter prefixFormatter(sHeaderPrefixBuf, kHeaderPrefixBufSizeInBytes);
+    for (UInt32 theHeader = 0; theHeader < qtssNumHeaders; theHeader++)
+    {
+        sHeaderPrefixes[theHeader].Ptr = prefixFormatter.GetCurrentPtr();
+        prefixFormatter.Put(RTSPProtocol::GetHeaderString(theHeader));
+        prefixFormatter.Put(sColonSpace);
+        sHeaderPrefixes[theHeader].Len = prefixFormatter.GetCurrentPtr() - sHeaderPrefixes[theHeader].Ptr;
+    }
+    Assert(prefixFormatter.GetCurrentOffset() < kHeaderPrefixBufSizeInBytes);
+    
+    // The date slots are filled with blanks here, the real date is copied over them per response
+    char theBlankDate[DateBuffer::kDateBufferLen];
+    ::memset(theBlankDate, ' ', DateBuffer::kDateBufferLen);
+    StringFormatter dateFormatter(sDateAndExpiresBuf, kStaticHeaderSizeInBytes);
+    dateFormatter.Put(sHeaderPrefixes[qtssDateHeader]);
+    sDateSlot = dateFormatter.GetCurrentOffset();
+    dateFormatter.Put(theBlankDate, DateBuffer::kDateBufferLen);
+    dateFormatter.PutEOL();
+    dateFormatter.Put(sHeaderPrefixes[qtssExpiresHeader]);
+    sExpiresSlot = dateFormatter.GetCurrentOffset();
+    dateFormatter.Put(theBlankDate, DateBuffer::kDateBufferLen);
+    dateFormatter.PutEOL();
+    sDateAndExpires.Len = dateFormatter.GetCurrentOffset();
+    Assert(sDateAndExpires.Len < kStaticHeaderSizeInBytes);
+    
     //Setup all the dictionary stuff
     for (UInt32 x = 0; x < qtssRTSPReqNumParams; x++)
         QTSSDictionaryMap::GetMap(QTSSDictionaryMap::kRTSPRequestDictIndex)->
@@ -155,6 +188,7 @@ RTSPRequestInterface::RTSPRequestInterface(RTSPSessionInterface *session)
     fSourceAddr(0),
     fTransportType(qtssRTPTransportTypeUDP),
     fNetworkMode(qtssRTPNetworkModeDefault),    
+    fRTCPMux(false),
     fContentLength(0),
     fIfModSinceDate(0),
     fSpeed(0),
@@ -162,6 +196,7 @@ RTSPRequestInterface::RTSPRequestInterface(RTSPSessionInterface *session)
     fPrebufferAmt(-1),
     fWindowSize(0),
     fMovieFolderPtr(&fMovieFolderPath[0]),
+    fArena((char*)fArenaBuffer, sizeof(fArenaBuffer)),
     fHeaderDictionary(QTSSDictionaryMap::GetMap(QTSSDictionaryMap::kRTSPHeaderDictIndex)),
     fAllowed(true),
     fTransportMode(qtssRTPTransportModePlay),
@@ -183,6 +218,10 @@ RTSPRequestInterface::RTSPRequestInterface(RTSPSessionInterface *session)
     //we can properly initialize their pointers right off the bat.
 
     fStreamRef = this;
+    this->SetArena(&fArena);
+    fHeaderDictionary.SetArena(&fArena);
+    fUserProfile.SetArena(&fArena);
+    
     RTSPRequestStream* input = session->GetInputStream();
     this->SetVal(qtssRTSPReqFullRequest, input->GetRequestBuffer()->Ptr, input->GetRequestBuffer()->Len);
     this->SetVal(qtssRTSPReqMethod, &fMethod, sizeof(fMethod));
@@ -222,8 +261,13 @@ void RTSPRequestInterface::AppendHeader(QTSS_RTSPHeader inHeader, StrPtrLen* inV
     if (!fStandardHeadersWritten)
         this->WriteStandardHeaders();
         
-    fOutputStream->Put(RTSPProtocol::GetHeaderString(inHeader));
-    fOutputStream->Put(sColonSpace);
+    if (inHeader < qtssNumHeaders)
+        fOutputStream->Put(sHeaderPrefixes[inHeader]);
+    else
+    {
+        fOutputStream->Put(RTSPProtocol::GetHeaderString(inHeader));
+        fOutputStream->Put(sColonSpace);
+    }
     fOutputStream->Put(*inValue);
     fOutputStream->PutEOL();
 }
@@ -247,11 +291,13 @@ void RTSPRequestInterface::AppendDateAndExpires()
     Assert(OSThread::GetCurrent() != NULL);
     DateBuffer* theDateBuffer = OSThread::GetCurrent()->GetDateBuffer();
     theDateBuffer->InexactUpdate(); // Update the date buffer to the current date & time
-    StrPtrLen theDate(theDateBuffer->GetDateBuffer(), DateBuffer::kDateBufferLen);
     
-    // Append dates, and have this response expire immediately
-    this->AppendHeader(qtssDateHeader, &theDate);
-    this->AppendHeader(qtssExpiresHeader, &theDate);
+    // Append dates, and have this response expire immediately. Put leaves the
+    // whole template contiguous at the end of the buffer, so patch it there.
+    fOutputStream->Put(sDateAndExpires);
+    char* theTemplate = fOutputStream->GetCurrentPtr() - sDateAndExpires.Len;
+    ::memcpy(theTemplate + sDateSlot, theDateBuffer->GetDateBuffer(), DateBuffer::kDateBufferLen);
+    ::memcpy(theTemplate + sExpiresSlot, theDateBuffer->GetDateBuffer(), DateBuffer::kDateBufferLen);
 }
 
 
@@ -269,8 +315,7 @@ void RTSPRequestInterface::AppendSessionHeaderWithTimeout( StrPtrLen* inSessionI
         // Just write out the session header and session ID
         if (inSessionID != NULL && inSessionID->Len > 0)
         {
-            fOutputStream->Put( RTSPProtocol::GetHeaderString(qtssSessionHeader ) );
-            fOutputStream->Put(sColonSpace);
+            fOutputStream->Put( sHeaderPrefixes[qtssSessionHeader] );
             fOutputStream->Put( *inSessionID );
         
         
@@ -324,20 +369,36 @@ void RTSPRequestInterface::AppendTransportHeader(StrPtrLen* serverPortA,
     static StrPtrLen    sInterLeaved("interleaved");//match the interleaved tag
     static StrPtrLen    sClientPort("client_port");
     static StrPtrLen    sClientPortString(";client_port=");
+    static StrPtrLen    sRTCPMux("rtcp-mux");
+    static StrPtrLen    sRTCPMuxString(";rtcp-mux");
     
     if (!fStandardHeadersWritten)
         this->WriteStandardHeaders();
 
     // Just write out the same transport header the client sent to us.
-    fOutputStream->Put(RTSPProtocol::GetHeaderString(qtssTransportHeader));
-    fOutputStream->Put(sColonSpace);
+    fOutputStream->Put(sHeaderPrefixes[qtssTransportHeader]);
 
-    StrPtrLen outFirstTransport(fFirstTransport.GetAsCString());
-    OSCharArrayDeleter outFirstTransportDeleter(outFirstTransport.Ptr);
+    // RemoveWhitespace works in place, so work on a copy that goes away with the request
+    StrPtrLen outFirstTransport((char*)fArena.Alloc(fFirstTransport.Len + 1), fFirstTransport.Len);
+    ::memcpy(outFirstTransport.Ptr, fFirstTransport.Ptr, fFirstTransport.Len);
+    outFirstTransport.Ptr[outFirstTransport.Len] = '\0';
     outFirstTransport.RemoveWhitespace();
     while (outFirstTransport[outFirstTransport.Len - 1] == ';')
         outFirstTransport.Len --;
 
+    // rtcp-mux goes back at the end, and only if the stream took it
+    StrPtrLen stripRTCPMuxStr;
+    if (outFirstTransport.FindStringIgnoreCase(sRTCPMux, &stripRTCPMuxStr) != NULL)
+    {
+        char* theStart = stripRTCPMuxStr.Ptr;
+        if ((theStart > outFirstTransport.Ptr) && (*(theStart - 1) == ';'))
+            theStart--;
+        char* theEnd = stripRTCPMuxStr.Ptr + stripRTCPMuxStr.Len;
+        char* theTransportEnd = outFirstTransport.Ptr + outFirstTransport.Len;
+        ::memmove(theStart, theEnd, theTransportEnd - theEnd);
+        outFirstTransport.Len -= (UInt32)(theEnd - theStart);
+    }
+
     // see if it contains an interleaved field or client port field
     StrPtrLen stripClientPortStr;
     StrPtrLen stripInterleavedStr;
@@ -364,14 +425,12 @@ void RTSPRequestInterface::AppendTransportHeader(StrPtrLen* serverPortA,
     if (stripClientPortStr.Len != 0)
     {
         fOutputStream->Put(sClientPortString);
-        UInt16 portA = this->GetClientPortA();
-        UInt16 portB = this->GetClientPortB();
-        StrPtrLenDel clientPortA(QTSSDataConverter::ValueToString( &portA, sizeof(portA), qtssAttrDataTypeUInt16));
-        StrPtrLenDel clientPortB(QTSSDataConverter::ValueToString( &portB, sizeof(portB), qtssAttrDataTypeUInt16));
-        
-        fOutputStream->Put(clientPortA);
-        fOutputStream->PutChar('-');
-        fOutputStream->Put(clientPortB);        
+        fOutputStream->Put((SInt32)this->GetClientPortA());
+        if (!fRTCPMux)
+        {
+            fOutputStream->PutChar('-');
+            fOutputStream->Put((SInt32)this->GetClientPortB());
+        }
     }
     
     // Append the server ports, if provided.
@@ -383,6 +442,9 @@ void RTSPRequestInterface::AppendTransportHeader(StrPtrLen* serverPortA,
         fOutputStream->Put(*serverPortB);
     }
     
+    if (fRTCPMux)
+        fOutputStream->Put(sRTCPMuxString);
+    
     // Append channel #'s, if provided
     if (channelA != NULL)
     {
@@ -394,18 +456,15 @@ void RTSPRequestInterface::AppendTransportHeader(StrPtrLen* serverPortA,
     
     if (ssrc != NULL && ssrc->Ptr != NULL && ssrc->Len != 0 && fNetworkMode == qtssRTPNetworkModeUnicast && fTransportMode == qtssRTPTransportModePlay)
     {
-        char* theCString = ssrc->GetAsCString();
-        OSCharArrayDeleter cStrDeleter(theCString);
-        
-        UInt32 ssrcVal = 0;
-        ::sscanf(theCString, "%lu", &ssrcVal);
-        ssrcVal = htonl(ssrcVal);
+        StringParser theSSRCParser(ssrc);
+        UInt32 ssrcVal = htonl(theSSRCParser.ConsumeInteger());
         
-        StrPtrLen hexSSRC(QTSSDataConverter::ValueToString( &ssrcVal, sizeof(ssrcVal), qtssAttrDataTypeUnknown));
-        OSCharArrayDeleter hexStrDeleter(hexSSRC.Ptr);
+        // 8 hex digits, most significant first
+        char hexSSRC[sizeof(ssrcVal) * 2];
+        QTSSDataConverter::ConvertBytesToCHexString(&ssrcVal, sizeof(ssrcVal), hexSSRC);
 
         fOutputStream->Put(sSSRC);
-        fOutputStream->Put(hexSSRC);
+        fOutputStream->Put(hexSSRC, sizeof(hexSSRC));
     }
 
     fOutputStream->PutEOL();
@@ -727,7 +786,7 @@ void* RTSPRequestInterface::GetLocalPath(QTSSDictionary* inRequest, UInt32* outL
 	}
 	
 	UInt32 fullPathLen = filePath.Len + theRootDir->Len;
-	char* theFullPath = NEW char[fullPathLen+1];
+	char* theFullPath = (char*)theRequest->GetArena()->Alloc(fullPathLen+1);
 	theFullPath[fullPathLen] = '\0';
 	
 	::memcpy(theFullPath, theRootDir->Ptr, theRootDir->Len);
@@ -735,8 +794,8 @@ void* RTSPRequestInterface::GetLocalPath(QTSSDictionary* inRequest, UInt32* outL
 	
 	(void)theRequest->SetValue(qtssRTSPReqLocalPath, 0, theFullPath,fullPathLen , QTSSDictionary::kDontObeyReadOnly);
 	
-	// delete our copy of the data
-	delete [] theFullPath;
+	// give back our copy of the data if nothing else has come out of the arena since
+	theRequest->GetArena()->Release(theFullPath, fullPathLen+1);
 	*outLen = 0;
 	
 	return NULL;
@@ -156,12 +156,22 @@ class RTSPRequestInterface : public QTSSDictionary
         QTSS_RTPNetworkMode         GetNetworkMode()    { return fNetworkMode; }
         UInt32                      GetWindowSize()     { return fWindowSize; }
         
+        // True if the client asked for rtcp-mux. The RTP stream clears it if it
+        // won't multiplex, so that the Transport: header in the response leaves it out.
+        Bool16                      IsRTCPMux()         { return fRTCPMux; }
+        void                        SetRTCPMux(Bool16 inRTCPMux) { fRTCPMux = inRTCPMux; }
+        
             
         Bool16                      HasResponseBeenSent()
                                         { return fOutputStream->GetBytesWritten() > 0; }
             
         RTSPSessionInterface*       GetSession()         { return fSession; }
         QTSSDictionary*             GetHeaderDictionary(){ return &fHeaderDictionary; }
+
+        // Memory that lives exactly as long as this request. Attribute values copied
+        // into the request, its header dictionary and its user profile come from here,
+        // as does memory modules get from QTSS_NewRequestMemory.
+        OSArena*                    GetArena()          { return &fArena; }
         
         Bool16                      GetAllowed()                { return fAllowed; }
         void                        SetAllowed(Bool16 allowed)  { fAllowed = allowed;}
@@ -200,7 +210,8 @@ class RTSPRequestInterface : public QTSSDictionary
         enum
         {
             kMovieFolderBufSizeInBytes = 256,   //Uint32
-            kMaxFilePathSizeInBytes = 256       //Uint32
+            kMaxFilePathSizeInBytes = 256,      //Uint32
+            kArenaBufSizeInBytes = 2048         //Uint32
         };
         
         QTSS_RTSPMethod             fMethod;            //Method of this request
@@ -220,6 +231,7 @@ class RTSPRequestInterface : public QTSSDictionary
         UInt32                      fSourceAddr;
         QTSS_RTPTransportType       fTransportType;
         QTSS_RTPNetworkMode         fNetworkMode;
+        Bool16                      fRTCPMux;
     
         UInt32                      fContentLength;
         SInt64                      fIfModSinceDate;
@@ -243,6 +255,11 @@ class RTSPRequestInterface : public QTSSDictionary
         char                        fMovieFolderPath[kMovieFolderBufSizeInBytes];
         char*                       fMovieFolderPtr;
         
+        // Most requests fit in this buffer, so the arena only allocates for big ones.
+        // UInt64s to keep it aligned.
+        UInt64                      fArenaBuffer[kArenaBufSizeInBytes / sizeof(UInt64)];
+        OSArena                     fArena;
+        
         QTSSDictionary              fHeaderDictionary;
         
         Bool16                      fAllowed;
@@ -277,7 +294,8 @@ class RTSPRequestInterface : public QTSSDictionary
 
         enum
         {
-            kStaticHeaderSizeInBytes = 512  //UInt32
+            kStaticHeaderSizeInBytes = 512,     //UInt32
+            kHeaderPrefixBufSizeInBytes = 2048  //UInt32
         };
         
         Bool16                  fStandardHeadersWritten;
@@ -305,6 +323,17 @@ class RTSPRequestInterface : public QTSSDictionary
         
         static StrPtrLen        sColonSpace;
         
+        // "<header name>: " for every header, so AppendHeader is a single Put per piece
+        static char             sHeaderPrefixBuf[kHeaderPrefixBufSizeInBytes];
+        static StrPtrLen        sHeaderPrefixes[qtssNumHeaders];
+        
+        // The Date and Expires headers with blanks where the date goes. AppendDateAndExpires
+        // copies this in and then fills in the current date at the two slot offsets.
+        static char             sDateAndExpiresBuf[kStaticHeaderSizeInBytes];
+        static StrPtrLen        sDateAndExpires;
+        static UInt32           sDateSlot;
+        static UInt32           sExpiresSlot;
+        
         //Dictionary support
         static QTSSAttrInfoDict::AttrInfo   sAttributes[];
 };
@@ -49,6 +49,8 @@ RTSPRequestStream::RTSPRequestStream(TCPSocket* sock)
     fRetreatBytesRead(0),
     fCurOffset(0),
     fEncodedBytesRemaining(0),
+    fHeaderScanOffset(0),
+    fHeaderLineCount(0),
     fRequest(fRequestBuffer, 0),
     fRequestPtr(NULL),
     fDecode(false),
@@ -63,6 +65,7 @@ void RTSPRequestStream::SnarfRetreat( RTSPRequestStream &fromRequest )
     Assert(fRetreatBytes < kRequestBufferSizeInBytes);
     fRetreatBytes = fromRequest.fRetreatBytes;
     fEncodedBytesRemaining = fCurOffset = fRequest.Len = 0;
+    fHeaderScanOffset = fHeaderLineCount = 0;
     ::memcpy(&fRequestBuffer[0], fromRequest.fRequest.Ptr + fromRequest.fRequest.Len, fromRequest.fRetreatBytes);
 }
 
@@ -108,6 +111,7 @@ QTSS_Error RTSPRequestStream::ReadRequest()
                 
             newOffset = fRequest.Len = fRetreatBytes;
             fRetreatBytes = fRetreatBytesRead = 0;
+            fHeaderScanOffset = fHeaderLineCount = 0;
         }
 
         // We don't have any new data, so try and get some
@@ -210,13 +214,25 @@ QTSS_Error RTSPRequestStream::ReadRequest()
         }
         
         //use a StringParser object to search for a double EOL, which signifies the end of
-        //the header.
+        //the header. The parser starts where the last read left off, at the start of the
+        //last line that might not be complete yet, so lines already checked aren't looked at again.
         Bool16 weAreDone = false;
-        StringParser headerParser(&fRequest);
+        StringParser headerParser(&fRequest, fHeaderScanOffset, fHeaderLineCount + 1);
         
-        UInt16 lcount = 0;
-        while (headerParser.GetThruEOL(NULL))
+        UInt16 lcount = fHeaderLineCount;
+        while (true)
         {
+            // If there is data past the last EOL, that EOL can't grow any more
+            // (a \r can't become a \r\n), so the lines up to here are settled.
+            if (headerParser.GetDataRemaining() > 0)
+            {
+                fHeaderScanOffset = headerParser.GetDataParsedLen();
+                fHeaderLineCount = lcount;
+            }
+            
+            if (!headerParser.GetThruEOL(NULL))
+                break;
+                
             lcount++;
             if (headerParser.ExpectEOL())
             {
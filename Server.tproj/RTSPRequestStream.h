@@ -85,6 +85,10 @@ public:
         //RequestArrived).
     StrPtrLen*  GetRequestBuffer()  { return fRequestPtr; }
     Bool16      IsDataPacket()      { return fIsDataPacket; }
+    
+    // True if data past the end of the current request has already been read off
+    // the socket. Once any request body is consumed, that is a pipelined request.
+    Bool16      HasPipelinedData()  { return fRetreatBytes > 0; }
     void        ShowRTSP(Bool16 enable) {fPrintRTSP = enable; }     
     void SnarfRetreat( RTSPRequestStream &fromRequest );
         
@@ -108,6 +112,8 @@ private:
     char                    fRequestBuffer[kRequestBufferSizeInBytes];
     UInt32                  fCurOffset; // tracks how much valid data is in the above buffer
     UInt32                  fEncodedBytesRemaining; // If we are decoding, tracks how many encoded bytes are in the buffer
+    UInt32                  fHeaderScanOffset;  // how much of fRequest is known to be complete header lines
+    UInt16                  fHeaderLineCount;   // number of lines in that part
     
     StrPtrLen               fRequest;
     StrPtrLen*              fRequestPtr;    // pointer to a request header
@@ -72,6 +72,7 @@ QTSS_Error RTSPResponseStream::WriteV(iovec* inVec, UInt32 inNumVectors, UInt32
             // We were able to send all the data in the buffer. Great. Flush it.
             this->Reset();
             fBytesSentInBuffer = 0;
+            fResponseStart = 0;
             
             // Make theLengthSent reflect the amount of data sent in the ioVec
             theLengthSent -= amtInBuffer;
@@ -175,6 +176,7 @@ QTSS_Error RTSPResponseStream::Flush()
             // We were able to send all the data in the buffer. Great. Flush it.
             this->Reset();
             fBytesSentInBuffer = 0;
+            fResponseStart = 0;
         }
         else
         {
@@ -50,7 +50,7 @@ class RTSPResponseStream : public ResizeableStringFormatter
         // on the socket.
         RTSPResponseStream(TCPSocket* inSocket, TimeoutTask* inTimeoutTask)
             :   ResizeableStringFormatter(fOutputBuf, kOutputBufferSizeInBytes),
-                fSocket(inSocket), fBytesSentInBuffer(0), fTimeoutTask(inTimeoutTask),fPrintRTSP(false) {}
+                fSocket(inSocket), fBytesSentInBuffer(0), fTimeoutTask(inTimeoutTask),fPrintRTSP(false), fResponseStart(0) {}
         
         virtual ~RTSPResponseStream() {}
 
@@ -84,6 +84,11 @@ class RTSPResponseStream : public ResizeableStringFormatter
         // this returns QTSS_NoErr, otherwise, it returns EWOULDBLOCK
         QTSS_Error Flush();
         
+        // Responses to pipelined requests can pile up in the buffer before being
+        // flushed together. These mark where the one being built now starts.
+        void        MarkResponseStart()     { fResponseStart = this->GetCurrentOffset(); }
+        UInt32      GetResponseStart()      { return fResponseStart; }
+        
         void        ShowRTSP(Bool16 enable) {fPrintRTSP = enable; }     
 
         
@@ -103,6 +108,7 @@ class RTSPResponseStream : public ResizeableStringFormatter
         UInt32                  fBytesSentInBuffer;
         TimeoutTask*            fTimeoutTask;
         Bool16                  fPrintRTSP;     // debugging printfs
+        UInt32                  fResponseStart;
         
         friend class RTSPRequestInterface;
 };
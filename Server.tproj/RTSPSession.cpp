@@ -118,6 +118,8 @@ static StrPtrLen    sEmptyStr("");
 // static class member  initialized in RTSPSession ctor
 OSRefTable* RTSPSession::sHTTPProxyTunnelMap = NULL;
 
+OSBufferPool RTSPSession::sPool(sizeof(RTSPSession), kMaxFreeInPool);
+
 char        RTSPSession::sHTTPResponseHeaderBuf[kMaxHTTPResponseLen];
 StrPtrLen   RTSPSession::sHTTPResponseHeaderPtr(sHTTPResponseHeaderBuf, kMaxHTTPResponseLen);
 
@@ -145,6 +147,33 @@ void RTSPSession::Initialize()
 }
 
 
+void* RTSPSession::operator new(size_t inSize)
+{
+    // A derived class won't fit in a pool buffer
+    if (inSize != sizeof(RTSPSession))
+        return ::operator new(inSize);
+    return sPool.Get();
+}
+
+#if MEMORY_DEBUGGING
+void* RTSPSession::operator new(size_t inSize, char* inFile, int inLine)
+{
+    if (inSize != sizeof(RTSPSession))
+        return ::operator new(inSize, inFile, inLine);
+    return sPool.Get();
+}
+#endif
+
+void RTSPSession::operator delete(void* inMem, size_t inSize)
+{
+    if (inMem == NULL)
+        return;
+    if (inSize != sizeof(RTSPSession))
+        ::operator delete(inMem);
+    else
+        sPool.Put(inMem);
+}
+
 RTSPSession::RTSPSession( Bool16 doReportHTTPConnectionAddress )
 : RTSPSessionInterface(),
   fRequest(NULL),
@@ -231,6 +260,12 @@ SInt64 RTSPSession::Run()
     if ((events & Task::kTimeoutEvent) || (events & Task::kKillEvent))
         fLiveSession = false;
     
+    // An RTP session may be waiting for the socket to drain
+    if (events & Task::kReadEvent)
+        this->SignalWriteEvent();
+    if (events & Task::kWriteEvent)
+        this->WatchForWriteEvent();
+    
     while (this->IsLiveSession())
     {
         // RTSP Session state machine. There are several well defined points in an RTSP request
@@ -248,7 +283,7 @@ SInt64 RTSPSession::Run()
                     // and still don't have a full request. Wait for more data.
                     
                     //+rt use the socket that reads the data, may be different now.
-                    fInputSocketP->RequestEvent(EV_RE);
+                    this->RequestReadEvent();
                     return 0;
                 }
                 
@@ -334,8 +369,20 @@ SInt64 RTSPSession::Run()
                     // that we've read all outstanding data off the socket,
                     // and still don't have a full request. Wait for more data.
                     
+                    // Responses to pipelined requests may still be waiting in the
+                    // output buffer. Send them before waiting for the client.
+                    if (fOutputStream.GetCurrentOffset() > 0)
+                    {
+                        OSMutexLocker sessionMutexLocker(&fSessionMutex);
+                        if (fOutputStream.Flush() == EAGAIN)
+                        {
+                            fSocket.RequestEvent(EV_WR);
+                            return 0;
+                        }
+                    }
+                    
                     //+rt use the socket that reads the data, may be different now.
-                    fInputSocketP->RequestEvent(EV_RE);
+                    this->RequestReadEvent();
                     return 0;
                 }
                 
@@ -390,6 +437,7 @@ SInt64 RTSPSession::Run()
                 // this point, reset it to 0 (we can then just let it increment
                 // until the next request comes in)
                 fOutputStream.ResetBytesWritten();
+                fOutputStream.MarkResponseStart();
                 
                 // Check for an overfilled buffer, and return an error.
                 if (err == E2BIG)
@@ -964,7 +1012,15 @@ SInt64 RTSPSession::Run()
 					fSentOptionsRequest = false;
 				}
 				
-                err = fOutputStream.Flush();
+                // If the client has pipelined more requests and we already have them,
+                // leave this response in the buffer so that it goes out in the same
+                // write as the responses to those. kReadingRequest sends whatever is
+                // left once there are no more complete requests.
+                if (fInputStream.HasPipelinedData() && (this->GetRemainingReqBodyLen() <= 0)
+                    && !fSentOptionsRequest && (fOutputStream.GetCurrentOffset() < kMaxCoalescedResponseBytes))
+                    err = QTSS_NoErr;
+                else
+                    err = fOutputStream.Flush();
                 
                 if (err == EAGAIN)
                 {
@@ -995,7 +1051,7 @@ SInt64 RTSPSession::Run()
                     
                     if (err == EAGAIN)
                     {
-                        fInputSocketP->RequestEvent(EV_RE);
+                        this->RequestReadEvent();
                         this->ForceSameThread();    // We are holding mutexes, so we need to force
                                                     // the same thread to be used for next Run()
                         return 0;
@@ -1888,8 +1944,10 @@ QTSS_Error RTSPSession::IsOkToAddNewRTPSession()
         return QTSSModuleUtils::SendErrorResponse(fRequest, qtssClientNotEnoughBandwidth,
                                                     qtssMsgTooMuchThruput);
 
-    //if the server is too loaded down (CPU too high, whatever)
-    // --INSERT WORKING CODE HERE--
+    //if the server is too loaded down to keep up with the clients it already has
+    if (theServer->IsOverloaded())
+        return QTSSModuleUtils::SendErrorResponse(fRequest, qtssServerUnavailable,
+                                                    qtssMsgRefusingConnections);
     
     return QTSS_NoErr;                                                  
 }
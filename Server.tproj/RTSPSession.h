@@ -41,6 +41,7 @@
 #include "RTSPRequest.h"
 #include "RTPSession.h"
 #include "TimeoutTask.h"
+#include "OSBufferPool.h"
 
 class RTSPSession : public RTSPSessionInterface
 {
@@ -52,11 +53,27 @@ class RTSPSession : public RTSPSessionInterface
         // Call this before using this object
         static void Initialize();
 
+        // There is one of these per client connection, so their memory is
+        // recycled through a pool instead of going back to the heap.
+        static void*    operator new(size_t inSize);
+#if MEMORY_DEBUGGING
+        static void*    operator new(size_t inSize, char* inFile, int inLine);
+#endif
+        static void     operator delete(void* inMem, size_t inSize);
+        static OSBufferPool*    GetPool()   { return &sPool; }
+
         Bool16 IsPlaying() {if (fRTPSession == NULL) return false; if (fRTPSession->GetSessionState() == qtssPlayingState) return true; return false; }
         
         
     private:
 
+        enum
+        {
+            kMaxFreeInPool = 256,               // more than this many idle sessions get freed
+            kMaxCoalescedResponseBytes = 4096   // flush pipelined responses once this much is buffered
+        };
+        static OSBufferPool sPool;
+
         SInt64 Run();
         
         // Gets & creates RTP session for this request.
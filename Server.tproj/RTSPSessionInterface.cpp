@@ -97,7 +97,11 @@ RTSPSessionInterface::RTSPSessionInterface()
     fOutputStream(&fSocket, &fTimeoutTask),
     fSessionMutex(),
     fTCPCoalesceBuffer(NULL),
+    fTCPCoalesceBufferSize(0),
+    fTCPCoalesceLimit(0),
     fNumInCoalesceBuffer(0),
+    fOutputFlowControlled(false),
+    fWriteEventTask(NULL),
     fSocket(NULL, Socket::kNonBlockingSocketType),
     fOutputSocketP(&fSocket),
     fInputSocketP(&fSocket),
@@ -198,7 +202,7 @@ QTSS_Error RTSPSessionInterface::Read(void* ioBuffer, UInt32 inLength, UInt32* o
 QTSS_Error RTSPSessionInterface::RequestEvent(QTSS_EventType inEventMask)
 {
     if (inEventMask & QTSS_ReadableEvent)
-        fInputSocketP->RequestEvent(EV_RE);
+        this->RequestReadEvent();
     if (inEventMask & QTSS_WriteableEvent)
         fOutputSocketP->RequestEvent(EV_WR);
         
@@ -207,11 +211,6 @@ QTSS_Error RTSPSessionInterface::RequestEvent(QTSS_EventType inEventMask)
 
 UInt8 RTSPSessionInterface::GetTwoChannelNumbers(StrPtrLen* inRTSPSessionID)
 {
-    //
-    // Allocate a TCP coalesce buffer if still needed
-    if (fTCPCoalesceBuffer != NULL)
-        fTCPCoalesceBuffer = new char[kTCPCoalesceBufferSize];
-
     //
     // Allocate 2 channel numbers
     UInt8 theChannelNum = fCurChannelNum;
@@ -249,10 +248,13 @@ StrPtrLen*  RTSPSessionInterface::GetSessionIDForChannelNum(UInt8 inChannelNum)
 /   InterleavedWrite
 /
 /   Write the given RTP packet out on the RTSP channel in interleaved format.
+/   If inCoalesce is set, packets up to kTCPCoalesceDirectWriteSize are copied into
+/   the coalesce buffer, which goes out with the next packet that isn't coalesced,
+/   when it is full, or when this is called with inLen == 0.
 /
 */
 
-QTSS_Error RTSPSessionInterface::InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* outLenWritten, unsigned char channel)
+QTSS_Error RTSPSessionInterface::InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* outLenWritten, unsigned char channel, Bool16 inCoalesce)
 {
 
     if ( inLen == 0 && fNumInCoalesceBuffer == 0 )
@@ -279,84 +281,76 @@ QTSS_Error RTSPSessionInterface::InterleavedWrite(void* inBuffer, UInt32 inLen,
         UInt16      len;
     };
     
-    struct  iovec               iov[3];
+    struct  iovec               iov[4];
     QTSS_Error                  err = QTSS_NoErr;
     
-    
+    if ( fNumInCoalesceBuffer == 0 && inLen > 0 && inCoalesce )
+        this->SizeCoalesceBuffer();
 
-    // flush rules
-    if ( ( inLen > kTCPCoalesceDirectWriteSize || inLen == 0 ) && fNumInCoalesceBuffer > 0 
-        || ( inLen + fNumInCoalesceBuffer + kInteleaveHeaderSize > kTCPCoalesceBufferSize ) && fNumInCoalesceBuffer > 0
+    if ( !inCoalesce || inLen == 0 || inLen > kTCPCoalesceDirectWriteSize
+        || fNumInCoalesceBuffer + kInteleaveHeaderSize + inLen > fTCPCoalesceLimit
         )
     {
-        UInt32      buffLenWritten;
+        // Send whatever is in the coalesce buffer and this packet with one write
+        struct RTPInterleaveHeader  rih;
+        UInt32      numVectors = 1; // skip iov[0], WriteV uses it
+        UInt32      totalLen = 0;
+        UInt32      lenWritten = 0;
         
-        // skip iov[0], WriteV uses it
-        iov[1].iov_base = fTCPCoalesceBuffer;
-        iov[1].iov_len = fNumInCoalesceBuffer;
+        if ( fNumInCoalesceBuffer > 0 )
+        {
+            iov[numVectors].iov_base = fTCPCoalesceBuffer;
+            iov[numVectors].iov_len = fNumInCoalesceBuffer;
+            totalLen += fNumInCoalesceBuffer;
+            numVectors++;
+        }
         
-        err = this->GetOutputStream()->WriteV( iov, 2, fNumInCoalesceBuffer, &buffLenWritten, RTSPResponseStream::kAllOrNothing );
+        if ( inLen > 0 )
+        {
+            rih.header = '$';
+            rih.channel = channel;
+            rih.len = htons( (UInt16)inLen);
+            
+            iov[numVectors].iov_base = (char*)&rih;
+            iov[numVectors].iov_len = sizeof(rih);
+            numVectors++;
+            
+            iov[numVectors].iov_base = (char*)inBuffer;
+            iov[numVectors].iov_len = inLen;
+            numVectors++;
+            totalLen += inLen + sizeof(rih);
+        }
+
+        err = this->GetOutputStream()->WriteV( iov, numVectors, totalLen, &lenWritten, RTSPResponseStream::kAllOrNothing );
 
     #if RTSP_SESSION_INTERFACE_DEBUGGING 
-        qtss_printf("InterleavedWrite: flushing %li\n", fNumInCoalesceBuffer );
+        qtss_printf("InterleavedWrite: flushing %li, bypass %li\n", fNumInCoalesceBuffer, inLen );
     #endif
         
         if ( err == QTSS_NoErr )
             fNumInCoalesceBuffer = 0;
+        fOutputFlowControlled = (err == EAGAIN);
     }
-    
-    
-    
-    if ( err == QTSS_NoErr )
+    else
     {
+        // coalesce with other small writes
         
-        if ( inLen > kTCPCoalesceDirectWriteSize )  
-        {
-            struct RTPInterleaveHeader  rih;
-            
-            // write direct to stream
-            rih.header = '$';
-            rih.channel = channel;
-            rih.len = htons( (UInt16)inLen);
-            
-            iov[1].iov_base = (char*)&rih;
-            iov[1].iov_len = sizeof(rih);
-            
-            iov[2].iov_base = (char*)inBuffer;
-            iov[2].iov_len = inLen;
-
-            err = this->GetOutputStream()->WriteV( iov, 3, inLen + sizeof(rih), outLenWritten, RTSPResponseStream::kAllOrNothing );
-
-        #if RTSP_SESSION_INTERFACE_DEBUGGING 
-            qtss_printf("InterleavedWrite: bypass %li\n", inLen );
-        #endif
-            
-        }
-        else
-        {
-            // coalesce with other small writes
-            
-            fTCPCoalesceBuffer[fNumInCoalesceBuffer] = '$';
-            fNumInCoalesceBuffer++;;
-            
-            fTCPCoalesceBuffer[fNumInCoalesceBuffer] = channel;
-            fNumInCoalesceBuffer++;
-            
-            //*((short*)&fTCPCoalesceBuffer[fNumInCoalesceBuffer]) = htons(inLen);
-            // if we ever turn TCPCoalesce back on, this should be optimized
-            // for processors w/o alignment restrictions as above.
-            
-            SInt16  pcketLen = htons( (UInt16) inLen);
-            ::memcpy( &fTCPCoalesceBuffer[fNumInCoalesceBuffer], &pcketLen, 2 );
-            fNumInCoalesceBuffer += 2;
-            
-            ::memcpy( &fTCPCoalesceBuffer[fNumInCoalesceBuffer], inBuffer, inLen );
-            fNumInCoalesceBuffer += inLen;
+        fTCPCoalesceBuffer[fNumInCoalesceBuffer] = '$';
+        fNumInCoalesceBuffer++;;
         
-        #if RTSP_SESSION_INTERFACE_DEBUGGING 
-            qtss_printf("InterleavedWrite: coalesce %li, total bufff %li\n", inLen, fNumInCoalesceBuffer);
-        #endif
-        }
+        fTCPCoalesceBuffer[fNumInCoalesceBuffer] = channel;
+        fNumInCoalesceBuffer++;
+        
+        SInt16  pcketLen = htons( (UInt16) inLen);
+        ::memcpy( &fTCPCoalesceBuffer[fNumInCoalesceBuffer], &pcketLen, 2 );
+        fNumInCoalesceBuffer += 2;
+        
+        ::memcpy( &fTCPCoalesceBuffer[fNumInCoalesceBuffer], inBuffer, inLen );
+        fNumInCoalesceBuffer += inLen;
+    
+    #if RTSP_SESSION_INTERFACE_DEBUGGING 
+        qtss_printf("InterleavedWrite: coalesce %li, total bufff %li\n", inLen, fNumInCoalesceBuffer);
+    #endif
     }
     
     if ( err == QTSS_NoErr )
@@ -377,6 +371,85 @@ QTSS_Error RTSPSessionInterface::InterleavedWrite(void* inBuffer, UInt32 inLen,
     
 }
 
+void RTSPSessionInterface::SizeCoalesceBuffer()
+{
+    // Hold back no more than the socket can take in one go, so that the
+    // write doesn't end up in the output stream's buffer instead.
+    UInt32 theLimit = fSocket.GetSendBufferSpace();
+    if (theLimit < kTCPCoalesceMinBufferSize)
+        theLimit = kTCPCoalesceMinBufferSize;
+    if (theLimit > kTCPCoalesceMaxBufferSize)
+        theLimit = kTCPCoalesceMaxBufferSize;
+    
+    // The buffer is empty here, so there is nothing to copy over
+    if (theLimit > fTCPCoalesceBufferSize)
+    {
+        delete [] fTCPCoalesceBuffer;
+        fTCPCoalesceBuffer = NEW char[theLimit];
+        fTCPCoalesceBufferSize = theLimit;
+    }
+    fTCPCoalesceLimit = theLimit;
+}
+
+Bool16 RTSPSessionInterface::RequestWriteEvent(Task* inTask)
+{
+    OSMutexLocker locker(&fWriteEventMutex);
+    if (!fOutputFlowControlled)
+        return false;
+        
+    fWriteEventTask = inTask;
+    
+    // The caller is usually an RTP session on another thread. Requesting socket
+    // events from here would race with this session's own requests, and one
+    // would replace the other, so let this session's task do it.
+    this->Signal(Task::kWriteEvent);
+    return true;
+}
+
+void RTSPSessionInterface::WatchForWriteEvent()
+{
+    OSMutexLocker locker(&fWriteEventMutex);
+    if (fWriteEventTask == NULL)
+        return;
+        
+    // Keep reading from the client while waiting, unless the session reads
+    // from another socket (HTTP tunnelling), which it is watching already.
+    if (fOutputSocketP == fInputSocketP)
+        fOutputSocketP->RequestEvent(EV_RE | EV_WR);
+    else
+        fOutputSocketP->RequestEvent(EV_WR);
+}
+
+void RTSPSessionInterface::RequestReadEvent()
+{
+    OSMutexLocker locker(&fWriteEventMutex);
+    if ((fWriteEventTask != NULL) && (fOutputSocketP == fInputSocketP))
+        fInputSocketP->RequestEvent(EV_RE | EV_WR);
+    else
+        fInputSocketP->RequestEvent(EV_RE);
+}
+
+void RTSPSessionInterface::CancelWriteEvent(Task* inTask)
+{
+    OSMutexLocker locker(&fWriteEventMutex);
+    if (fWriteEventTask == inTask)
+        fWriteEventTask = NULL;
+}
+
+void RTSPSessionInterface::SignalWriteEvent()
+{
+    //
+    // Socket events all come in as read events, so this gets called on any of
+    // them. If the socket is still full, the task just asks again.
+    if (fWriteEventTask == NULL)
+        return;
+        
+    OSMutexLocker locker(&fWriteEventMutex);
+    if (fWriteEventTask != NULL)
+        fWriteEventTask->Signal(Task::kWriteEvent);
+    fWriteEventTask = NULL;
+}
+
 /*
     take the TCP socket away from a RTSP session that's
     waiting to be snarfed.
@@ -436,7 +509,8 @@ void RTSPSessionInterface::SaveOutputStream()
 	Assert(fOldOutputStreamBuffer.Ptr == NULL);
 	fOldOutputStreamBuffer.Ptr = NEW char[fOutputStream.GetBytesWritten()];
 	fOldOutputStreamBuffer.Len = fOutputStream.GetBytesWritten();
-	::memcpy(fOldOutputStreamBuffer.Ptr, fOutputStream.GetBufPtr(), fOldOutputStreamBuffer.Len);
+	// skip over any earlier responses still waiting to be flushed
+	::memcpy(fOldOutputStreamBuffer.Ptr, fOutputStream.GetBufPtr() + fOutputStream.GetResponseStart(), fOldOutputStreamBuffer.Len);
 }
 
 void RTSPSessionInterface::RevertOutputStream()
@@ -109,13 +109,26 @@ public:
     virtual QTSS_Error Read(void* ioBuffer, UInt32 inLength, UInt32* outLenRead);
     virtual QTSS_Error RequestEvent(QTSS_EventType inEventMask);
 
-    // performs RTP over RTSP
-    QTSS_Error  InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* outLenWritten, unsigned char channel);
+    // performs RTP over RTSP. If inCoalesce is true, small packets are held back and
+    // sent together, so whoever writes a burst of packets that way must call
+    // FlushInterleavedWrites after it. Otherwise the packet goes out right away,
+    // along with anything still held back.
+    QTSS_Error  InterleavedWrite(void* inBuffer, UInt32 inLen, UInt32* outLenWritten, unsigned char channel, Bool16 inCoalesce);
+    QTSS_Error  FlushInterleavedWrites() { return this->InterleavedWrite(NULL, 0, NULL, 0, false); }
+    
+    // After an interleaved write returns EAGAIN, a task can ask to be signalled
+    // with a Task::kWriteEvent once the socket may have room again, instead of
+    // polling. Returns false if the EAGAIN wasn't from a full socket, in which
+    // case nothing will come. Call CancelWriteEvent before the task goes away
+    // or lets go of this session. This may be called from any thread, the
+    // socket events are only ever changed by this session's own task.
+    Bool16      RequestWriteEvent(Task* inTask);
+    void        CancelWriteEvent(Task* inTask);
 
 	// OPTIONS request
 	void		SaveOutputStream();
 	void		RevertOutputStream();
-	void		ResetOutputStream() { fOutputStream.Reset(); fOutputStream.ResetBytesWritten();}
+	void		ResetOutputStream() { fOutputStream.Reset(fOutputStream.GetResponseStart()); fOutputStream.ResetBytesWritten();}
 	void		SendOptionsRequest();
 	Bool16		SentOptionsRequest() { return fSentOptionsRequest; }
 	SInt32		RoundTripTime() { return fRoundTripTime; }
@@ -155,15 +168,36 @@ protected:
     // be prevented from writing while an RTSP request is in progress
     OSMutex             fSessionMutex;
     
-    // for coalescing small interleaved writes into a single TCP frame
+    // for coalescing small interleaved writes into as few socket writes as possible.
+    // Each time the buffer starts filling up, it is sized to what the socket will take.
     enum
     {
-          kTCPCoalesceBufferSize = 1450 //1450 is the max data space in an TCP segment over ent
-        , kTCPCoalesceDirectWriteSize = 0 // if > this # bytes bypass coalescing and make a direct write
+          kTCPCoalesceMinBufferSize = 1450 //1450 is the max data space in an TCP segment over ent
+        , kTCPCoalesceMaxBufferSize = 32768
+        , kTCPCoalesceDirectWriteSize = 1450 // if > this # bytes bypass coalescing and make a direct write
         , kInteleaveHeaderSize = 4  // '$ '+ 1 byte ch ID + 2 bytes length
     };
+    void        SizeCoalesceBuffer();
+    
     char*       fTCPCoalesceBuffer;
-    SInt32      fNumInCoalesceBuffer;
+    UInt32      fTCPCoalesceBufferSize;     // allocated
+    UInt32      fTCPCoalesceLimit;          // flush once this much is held
+    UInt32      fNumInCoalesceBuffer;
+    
+    // The last interleaved write found the socket full. fWriteEventTask
+    // wants to know when it drains, SignalWriteEvent tells it.
+    // RequestWriteEvent hands the socket request to this session with a
+    // Task::kWriteEvent, and the session's Run calls WatchForWriteEvent.
+    void        SignalWriteEvent();
+    void        WatchForWriteEvent();
+    
+    // Use instead of fInputSocketP->RequestEvent(EV_RE), so that the
+    // write event a task is waiting for doesn't get dropped.
+    void        RequestReadEvent();
+    
+    Bool16      fOutputFlowControlled;
+    Task*       fWriteEventTask;
+    OSMutex     fWriteEventMutex;
 
 
     //+rt  socket we get from "accept()"
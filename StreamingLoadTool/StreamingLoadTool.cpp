@@ -248,6 +248,8 @@ int main(int argc, char *argv[])
 					theClientType = ClientSession::kRTSPReliableUDPClientType;
 				else if (::strcmp("tcp", theValue) == 0)
 					theClientType = ClientSession::kRTSPTCPClientType;
+				else if (::strcmp("rtcpmux", theValue) == 0)
+					theClientType = ClientSession::kRTSPRTCPMuxClientType;
 				else
 					theClientType = ClientSession::kRTSPUDPClientType;
 			}
@@ -775,6 +777,7 @@ char* 	GetClientTypeDescription(ClientSession::ClientType inClientType)
 	static char* kHTTPString = "RTSP/HTTP client";
 	static char* kHTTPDropPostString = "RTSP/HTTP drop post client";
 	static char* kReliableUDPString = "RTSP/ReliableUDP client";
+	static char* kRTCPMuxString = "RTSP/UDP rtcp-mux client";
 	
 	switch (inClientType)
 	{
@@ -788,6 +791,8 @@ char* 	GetClientTypeDescription(ClientSession::ClientType inClientType)
 			return kHTTPDropPostString;
 		case ClientSession::kRTSPReliableUDPClientType:
 			return kReliableUDPString;
+		case ClientSession::kRTSPRTCPMuxClientType:
+			return kRTCPMuxString;
 	}
 	Assert(0);
 	return NULL;
@@ -802,6 +807,7 @@ char*	GetDeathReasonDescription(UInt32 inDeathReason)
 	static char* kSessionTimedoutString = "Couldn't connect to server";
 	static char* kConnectionFailedString = "Server refused connection";
 	static char* kDiedWhilePlayingString = "Disconnected while playing";
+	static char* kRTCPMuxRefusedString = "Server didn't accept rtcp-mux";
 
 	switch (inDeathReason)
 	{
@@ -819,6 +825,8 @@ char*	GetDeathReasonDescription(UInt32 inDeathReason)
 			return kConnectionFailedString;
 		case ClientSession::kDiedWhilePlaying:
 			return kDiedWhilePlayingString;
+		case ClientSession::kRTCPMuxRefused:
+			return kRTCPMuxRefusedString;
 	}
 	Assert(0);
 	return NULL;
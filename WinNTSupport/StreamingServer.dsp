@@ -117,6 +117,10 @@ SOURCE=..\APIModules\QTSSReflectorModule\ReflectorStream.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\APIModules\QTSSReflectorModule\ReflectorTimeShift.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\APIModules\QTSSReflectorModule\RelayOutput.cpp
 # End Source File
 # Begin Source File